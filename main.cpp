@@ -7,13 +7,36 @@
 #include "parray_tools.h"
 #include "catch.h"
 #include <iostream>
+#include <unordered_map>
 #include "str_printf.h"
+#include "parray_parse.h"
+#include "parray_format.h"
+#include "str_format.h"
+#include "parray_iovec.h"
+#include "parray_flat_map.h"
+#include "parray_string_table.h"
+#include "parray_sort.h"
+#include "parray_owned.h"
+#include "parray_shared.h"
+#include "parray_rope.h"
+#include "parray_concat.h"
+#include "parray_utf.h"
+#include "parray_stats.h"
+#include "parray_dispatch.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#   include <unistd.h>
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#endif
 
 
 //------------------------------------------------------------------------------
 using namespace std;
 using namespace adv;
 using common::str_printf;
+using common::str_nprintf;
+using common::str_aprintf;
 
 
 //------------------------------------------------------------------------------
@@ -1777,3 +1800,2252 @@ TEST_CASE("rsplit_and_rjoin_parray", "[rsplit_and_rjoin_parray]")
         }
     }
 }
+
+
+//------------------------------------------------------------------------------
+TEST_CASE("parse", "[parse]")
+{
+    SECTION("integers")
+    {
+        auto r = parse<int>(ntba("123,456"));
+        REQUIRE( r );
+        REQUIRE( r.value == 123 );
+        REQUIRE( r.consumed == 3 );
+
+        REQUIRE( parse<int>(ntba("-2147483648")).value == numeric_limits<int>::min() );
+        REQUIRE( parse<int>(ntba("2147483647")).value == numeric_limits<int>::max() );
+        REQUIRE( parse<int>(ntba("+17")).value == 17 );
+        REQUIRE( parse<long long>(ntba("-9223372036854775808")).value == numeric_limits<long long>::min() );
+        REQUIRE( parse<unsigned long long>(ntba("18446744073709551615")).value == numeric_limits<unsigned long long>::max() );
+        REQUIRE( parse<unsigned char>(ntba("255")).value == 255 );
+        REQUIRE( parse<signed char>(ntba("-128")).value == -128 );
+        REQUIRE( parse<short>(ntba("0000000000000000012345x")).value == 12345 );
+        REQUIRE( parse<short>(ntba("0000000000000000012345x")).consumed == 22 );
+        REQUIRE( parse<unsigned>(ntba("12345678901")).consumed == 11 );
+    }
+
+    SECTION("integer errors")
+    {
+        REQUIRE( parse<int>(rcstring{}).error == parse_error::invalid );
+        REQUIRE( parse<int>(ntba("-")).error == parse_error::invalid );
+        REQUIRE( parse<int>(ntba("-")).consumed == 0 );
+        REQUIRE( parse<int>(ntba(" 1")).error == parse_error::invalid );
+        REQUIRE( parse<unsigned>(ntba("-1")).error == parse_error::invalid );
+
+        auto r = parse<int>(ntba("2147483648;"));
+        REQUIRE( r.error == parse_error::overflow );
+        REQUIRE( r.value == numeric_limits<int>::max() );
+        REQUIRE( r.consumed == 10 );
+
+        REQUIRE( parse<signed char>(ntba("-129")).value == -128 );
+        REQUIRE( parse<unsigned long long>(ntba("18446744073709551616")).error == parse_error::overflow );
+        REQUIRE( parse<unsigned long long>(ntba("123456789012345678901234567890")).consumed == 30 );
+    }
+
+    SECTION("bases")
+    {
+        REQUIRE( parse<int>(ntba("ff"), 16).value == 255 );
+        REQUIRE( parse<int>(ntba("-0x7FfF"), 16).value == -0x7fff );
+        REQUIRE( parse<int>(ntba("0x"), 16).value == 0 );
+        REQUIRE( parse<int>(ntba("0x"), 16).consumed == 1 );
+        REQUIRE( parse<unsigned>(ntba("1010102"), 2).value == 42 );
+        REQUIRE( parse<unsigned>(ntba("1010102"), 2).consumed == 6 );
+        REQUIRE( parse<long>(ntba("zz"), 36).value == 35*36 + 35 );
+        REQUIRE( parse<int>(ntba("1"), 37).error == parse_error::invalid );
+        REQUIRE( parse<unsigned long long>(ntba("FFFFFFFFFFFFFFFF"), 16).value == numeric_limits<unsigned long long>::max() );
+        REQUIRE( parse<unsigned long long>(ntba("10000000000000000"), 16).error == parse_error::overflow );
+    }
+
+    SECTION("floating point")
+    {
+        auto r = parse<double>(ntba("-45.5e1,"));
+        REQUIRE( r );
+        REQUIRE( r.value == -455.0 );
+        REQUIRE( r.consumed == 7 );
+
+        char const* samples[] = { "0", "1", "0.1", "3.14159", "1e22", "1e23", "-2.5e-3", ".5", "5.", "123456789012345678901234567890",
+                                  "2.2250738585072014e-308", "4.9e-324", "1.7976931348623157e308", "0.000000000000000000000000001234",
+                                  "9007199254740993", "1.00000000000000011102230246251565404236316680908203125" };
+        for(char const* s : samples)
+        {
+            rcstring v{ ntbs(s) };
+            auto r = parse<double>(v);
+            REQUIRE( r );
+            REQUIRE( r.consumed == v.len );
+            REQUIRE( r.value == strtod(s, nullptr) );
+
+            auto rf = parse<float>(v);
+            REQUIRE( rf.consumed == v.len );
+            REQUIRE( (rf.error == parse_error::overflow || rf.value == strtof(s, nullptr)) );
+        }
+
+        // long mantissas: float must not be rounded through double
+        char const* float_samples[] = { "0.008763160090893507", "1.569594658690221e-07", "0.01060873968526721", "16777217",
+                                        "3.4028235e38", "1.17549435e-38", "7.038531e-26", "0.3" };
+        for(char const* s : float_samples)
+            REQUIRE( parse<float>(rcstring{ ntbs(s) }).value == strtof(s, nullptr) );
+
+        mt19937_64 rng(31);
+        for(int i = 0; i < 20000; ++i)
+        {
+            char buf[40];
+            int len = snprintf(buf, sizeof(buf), "%.*e", int(rng() % 18), double(rng() % 100000000000000000ull) * pow(10.0, int(rng() % 60) - 40));
+            auto rf = parse<float>(rcstring(size_t(len), buf));
+            REQUIRE( (rf.error == parse_error::overflow || rf.value == strtof(buf, nullptr)) );
+        }
+
+        REQUIRE( parse<double>(ntba("1e")).consumed == 1 );
+        REQUIRE( parse<double>(ntba("1e+")).consumed == 1 );
+        REQUIRE( parse<double>(ntba(".")).error == parse_error::invalid );
+        REQUIRE( parse<double>(ntba("-")).error == parse_error::invalid );
+        REQUIRE( parse<double>(ntba("1e400")).error == parse_error::overflow );
+        REQUIRE( parse<double>(ntba("0e400")).value == 0.0 );
+        REQUIRE( parse<float>(ntba("1e39")).error == parse_error::overflow );
+        REQUIRE( parse<double>(ntba("-Infinity")).value == -numeric_limits<double>::infinity() );
+        REQUIRE( parse<double>(ntba("-Infinity")).consumed == 9 );
+        REQUIRE( parse<double>(ntba("infinit")).consumed == 3 );
+        REQUIRE( parse<double>(ntba("NaN")).value != parse<double>(ntba("NaN")).value );
+        REQUIRE( parse<long double>(ntba("0.25")).value == 0.25L );
+    }
+}
+
+
+//------------------------------------------------------------------------------
+TEST_CASE("format", "[format]")
+{
+    SECTION("integers")
+    {
+        char buf[format_max<long long>];
+        REQUIRE( format_int(buf, 0) == ntba("0") );
+        REQUIRE( format_int(buf, 7) == ntba("7") );
+        REQUIRE( format_int(buf, -12345) == ntba("-12345") );
+        REQUIRE( format_int(buf, numeric_limits<int>::min()) == ntba("-2147483648") );
+        REQUIRE( format_int(buf, numeric_limits<long long>::min()) == ntba("-9223372036854775808") );
+        REQUIRE( format_int(buf, numeric_limits<unsigned long long>::max()) == ntba("18446744073709551615") );
+        REQUIRE( format_int(buf, (signed char)-128) == ntba("-128") );
+        REQUIRE( format_int(buf, 3, 1000).empty() );
+        REQUIRE( format_int(buf, 3, 999) == ntba("999") );
+
+        for(unsigned long long v = 1; v < numeric_limits<unsigned long long>::max() / 3; v = v * 3 + 1)
+        {
+            REQUIRE( format_int(buf, v) == to_string(v) );
+            REQUIRE( format_int(buf, -(long long)v) == to_string(-(long long)v) );
+        }
+
+        string s = "x=";
+        REQUIRE( append_int(s, 42) == ntba("42") );
+        REQUIRE( s == "x=42" );
+    }
+
+    SECTION("doubles")
+    {
+        char buf[format_max<double>];
+        REQUIRE( format_double(buf, 0.0) == ntba("0") );
+        REQUIRE( format_double(buf, -0.0) == ntba("-0") );
+        REQUIRE( format_double(buf, 1.0) == ntba("1") );
+        REQUIRE( format_double(buf, 1234.5) == ntba("1234.5") );
+        REQUIRE( format_double(buf, 0.1) == ntba("0.1") );
+        REQUIRE( format_double(buf, 0.001) == ntba("0.001") );
+        REQUIRE( format_double(buf, 1.5e-7) == ntba("1.5e-07") );
+        REQUIRE( format_double(buf, 1e22) == ntba("1e+22") );
+        REQUIRE( format_double(buf, -1e300) == ntba("-1e+300") );
+        REQUIRE( format_double(buf, 5e-324) == ntba("5e-324") );
+        REQUIRE( format_double(buf, 1.7976931348623157e308) == ntba("1.7976931348623157e+308") );
+        REQUIRE( format_double(buf, numeric_limits<double>::infinity()) == ntba("inf") );
+        REQUIRE( format_double(buf, -numeric_limits<double>::infinity()) == ntba("-inf") );
+        REQUIRE( format_double(buf, numeric_limits<double>::quiet_NaN()) == ntba("nan") );
+        REQUIRE( format_double(buf, 2, 0.5).empty() );
+        REQUIRE( format_double(buf, 3, 0.5) == ntba("0.5") );
+
+        uint64_t x = 88172645463325252ull;  // xorshift
+        for(int i = 0; i < 100000; ++i)
+        {
+            x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+            double v;
+            memcpy(&v, &x, sizeof(v));
+            if (v != v || v - v != 0) continue;     // skip nan/inf
+
+            rcstring s = format_double(buf, v);
+            REQUIRE( s.len <= format_max<double> );
+            REQUIRE( strtod(s.str().c_str(), nullptr) == v );
+            REQUIRE( parse<double>(s).value == v );
+        }
+
+        vector<char> r;
+        REQUIRE( append_double(r, 2.5) == ntba("2.5") );
+        REQUIRE( r.size() == 3 );
+    }
+}
+
+
+//------------------------------------------------------------------------------
+TEST_CASE("str_format", "[str_format]")
+{
+    SECTION("arguments")
+    {
+        char buf[256];
+        rcstring user = ntba("bob");
+        string host = "example.com";
+        char const* p = "ntbs";
+
+        auto r = str_format(buf, ADV_FMT("user={} host={} id={:x} ID={:X} load={} ok={} c={} {}"), user, host, 255, 0xABCu, 0.5, true, 'z', ntbs(p));
+        REQUIRE( !r.truncated() );
+        REQUIRE( r.str == ntba("user=bob host=example.com id=ff ID=ABC load=0.5 ok=true c=z ntbs") );
+        REQUIRE( r.required == r.str.len );
+
+        REQUIRE( str_format(buf, ADV_FMT("")).str == ntba("") );
+        REQUIRE( str_format(buf, ADV_FMT("no args")).str == ntba("no args") );
+        REQUIRE( str_format(buf, ADV_FMT("{}"), -42).str == ntba("-42") );
+        REQUIRE( str_format(buf, ADV_FMT("{{{}}} {{}}"), 1).str == ntba("{1} {}") );
+        REQUIRE( str_format(buf, ADV_FMT("{:x}"), -1).str == ntba("ffffffff") );
+        REQUIRE( str_format(buf, ADV_FMT("{}{}{}"), 1, 2LL, (unsigned short)3).str == ntba("123") );
+
+        char volatile v[] = "vol";
+        REQUIRE( str_format(buf, ADV_FMT("[{}]"), ntba(v)).str == ntba("[vol]") );
+    }
+
+    SECTION("truncation")
+    {
+        char buf[8];
+        auto r = str_format(buf, ADV_FMT("{}-{}"), ntba("abcdef"), 123456);
+        REQUIRE( r.truncated() );
+        REQUIRE( r.required == 13 );
+        REQUIRE( r.str == ntba("abcdef-1") );
+
+        r = str_format(buf, 4, ADV_FMT("x{}"), 1.25);
+        REQUIRE( r.truncated() );
+        REQUIRE( r.required == 5 );
+        REQUIRE( r.str == ntba("x1.2") );
+
+        r = str_format(buf, ADV_FMT("{}"), 1234567);
+        REQUIRE( !r.truncated() );
+        REQUIRE( r.str == ntba("1234567") );
+    }
+}
+
+
+//------------------------------------------------------------------------------
+TEST_CASE("str_printf", "[str_printf]")
+{
+    SECTION("str_nprintf")
+    {
+        char buf[8];
+        REQUIRE( str_nprintf(buf, "%d", 123) == 3 );
+        REQUIRE( string(buf) == "123" );
+
+        REQUIRE( str_nprintf(buf, "%s-%d", "abcdef", 123456) == 13 );      // truncated
+        REQUIRE( string(buf) == "abcdef-" );
+
+        REQUIRE( str_nprintf(buf, 4, "%d", 123456) == 6 );
+        REQUIRE( string(buf) == "123" );
+    }
+
+    SECTION("str_aprintf")
+    {
+        string s;
+        rcstring r = str_aprintf(s, "%d-%s", 42, "abc");
+        REQUIRE( r == ntba("42-abc") );
+        REQUIRE( s == "42-abc" );
+
+        r = str_aprintf(s, "%s", "");
+        REQUIRE( r.empty() );
+        REQUIRE( s == "42-abc" );
+
+        string big(1000, 'x');
+        r = str_aprintf(s, "[%s]", big.c_str());        // doesn't fit into initial room
+        REQUIRE( r.len == 1002 );
+        REQUIRE( r == "[" + big + "]" );
+        REQUIRE( s == "42-abc[" + big + "]" );
+
+        vector<char> v;
+        v.reserve(4096);
+        auto p = v.data();
+        r = str_aprintf(v, "%05.1f", 2.5);
+        REQUIRE( r == ntba("002.5") );
+        REQUIRE( v.size() == 5 );
+        REQUIRE( v.data() == p );                       // no reallocation
+
+        // spare capacity isn't filled (appending to reserved buffer stays linear)
+        struct tracked : string
+        {
+            size_t filled = 0;
+            void resize(size_t n) { if (n > size()) filled += n - size(); string::resize(n); }
+        } t;
+        t.reserve(1 << 20);
+        for(int i = 0; i < 1000; ++i) str_aprintf(t, "%d,", i % 10);
+        REQUIRE( t.size() == 2000 );
+        REQUIRE( t.filled == 3000 );                    // len + 1 per call
+        REQUIRE( t.compare(0, 6, "0,1,2,") == 0 );
+    }
+}
+
+
+//------------------------------------------------------------------------------
+TEST_CASE("iovec_builder", "[iovec_builder]")
+{
+    rcstring user = ntba("bob");
+    deque<rcstring> tags = {ntba("a"), ntba(""), ntba("c")};
+
+    iovec_builder b;
+    b.append(ntba("user=")).append(user).append(ntba(" id=")).append_int(-42).append_double(0.5);
+    b.append_format(ADV_FMT(" [{}:{:x}]"), user, 255);
+    b.append(ntba(" tags=")).join(begin(tags), end(tags), ',');
+    b.append(ntba(" se=")).join_se(begin(tags), end(tags), ntba("::"));
+    b.append(ntba(" r=")).rjoin(begin(tags), end(tags), '|');
+
+    string expected = "user=bob id=-420.5 [bob:ff] tags=a,,c se=a::c r=c||a";
+    REQUIRE( b.size() == expected.size() );
+    REQUIRE( b.count() < 20 );                      // 'id=' number pieces got merged
+
+    string s;
+    b.append_to(s);
+    REQUIRE( s == expected );
+
+    char buf[12];
+    REQUIRE( b.copy_to(buf) == rcstring(expected).left(12) );
+
+    SECTION("large fragments")
+    {
+        iovec_builder b2;
+        string big(5000, 'x');
+        for(int i = 0; i < 100; ++i) b2.append_int(i).append_copy(ntba(","));
+        b2.append_copy(rcstring(big));
+        b2.append_format(ADV_FMT("{}"), rcstring(big));
+
+        string s2;
+        b2.append_to(s2);
+        REQUIRE( s2.size() == b2.size() );
+        REQUIRE( rcstring(s2).right(10000) == big + big );
+        REQUIRE( rcstring(s2).left(6) == ntba("0,1,2,") );
+
+        b2.clear();
+        REQUIRE( b2.empty() );
+        b2.append_int(7);
+        REQUIRE( b2.count() == 1 );
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    SECTION("flush")
+    {
+        int fds[2];
+        REQUIRE( pipe(fds) == 0 );
+        REQUIRE( b.flush(fds[1]) );
+        REQUIRE( b.empty() );
+        close(fds[1]);
+
+        char rbuf[256];
+        ssize_t n = read(fds[0], rbuf, sizeof(rbuf));
+        close(fds[0]);
+        REQUIRE( n == (ssize_t)expected.size() );
+        REQUIRE( rcstring(n, rbuf) == expected );
+    }
+
+    SECTION("flush resumes after EAGAIN")
+    {
+        int fds[2];
+        REQUIRE( pipe(fds) == 0 );
+        REQUIRE( fcntl(fds[0], F_SETFL, O_NONBLOCK) == 0 );
+        REQUIRE( fcntl(fds[1], F_SETFL, O_NONBLOCK) == 0 );
+
+        string data(1 << 20, 'x'), big;
+        for(size_t i = 0; i < data.size(); i += 997) data[i] = char('a' + i % 26);
+        iovec_builder w;
+        for(size_t i = 0; i < data.size(); i += 4000)                  // separators keep fragments apart
+        {
+            w.append(rcstring(data).mid(i, min<size_t>(4000, data.size() - i)));
+            w.append(ntba("|"));
+            big += data.substr(i, 4000) + "|";
+        }
+
+        string got;
+        char rbuf[65536];
+        int failures = 0;
+        while(!w.flush(fds[1]))
+        {
+            REQUIRE( errno == EAGAIN );
+            REQUIRE( w.size() < big.size() - got.size() );             // written part was dropped
+            ++failures;
+            for(ssize_t n; (n = read(fds[0], rbuf, sizeof(rbuf))) > 0; ) got.append(rbuf, n);
+        }
+        close(fds[1]);
+        for(ssize_t n; (n = read(fds[0], rbuf, sizeof(rbuf))) > 0; ) got.append(rbuf, n);
+        close(fds[0]);
+
+        REQUIRE( failures > 0 );
+        REQUIRE( got == big );
+    }
+#endif
+}
+
+
+//------------------------------------------------------------------------------
+TEST_CASE("ntbs_len", "[ntbs_len]")
+{
+    SECTION("all alignments and lengths")
+    {
+        unsigned char         b[80];
+        char volatile         c[80];
+        char16_t              w[80];
+        int                   n[80];
+
+        for(size_t off = 0; off < 9; ++off)
+            for(size_t len = 0; off + len < 70; ++len)
+            {
+                for(size_t i = 0; i < 80; ++i)
+                {
+                    b[i] = (i < off + len) ? 0x80 | i : 0;  // high bits set -- make sure they aren't mistaken for NUL
+                    c[i] = (i < off + len) ? 'a' : 0;
+                    w[i] = (i < off + len) ? 0xFF00 | i : 0;
+                    n[i] = (i < off + len) ? 0x10000 : 0;   // zero low half
+                }
+
+                REQUIRE( parray_traits::ntbs_len(b + off) == len );
+                REQUIRE( parray_traits::ntbs_len(c + off) == len );
+                REQUIRE( parray_wide_traits::ntbs_len(c + off) == len );
+                REQUIRE( parray_traits::ntbs_len(w + off) == len );
+                REQUIRE( parray_traits::ntbs_len(n + off) == len );
+            }
+    }
+
+    SECTION("trait selection")
+    {
+        char volatile s[] = "shared memory record";
+        parray<char volatile const> r{ ntbs<parray_wide_traits>(&s[0]) };
+        REQUIRE( r == ntba("shared memory record") );
+        REQUIRE( (ntbs<parray_wide_traits>(&s[0]) == parray<char const, parray_wide_traits>(ntba("shared memory record"))) );
+
+        char16_t const* u = u"utf-16 text";
+        REQUIRE( parray<char16_t const>(ntbs(u)).len == 11 );
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// reference: length first, then unsigned bytes
+static int ref_cmp(string const& a, string const& b)
+{
+    if (a.size() != b.size()) return (a.size() < b.size()) ? -1 : 1;
+    int r = memcmp(a.data(), b.data(), a.size());
+    return (r < 0) ? -1 : (r > 0) ? 1 : 0;
+}
+
+static void check_ntbs_cmp(rcstring a, char const* b)
+{
+    int expected = ref_cmp(a.str(), string(b));
+
+    REQUIRE( (a == ntbs(b)) == (expected == 0) );
+    REQUIRE( (ntbs(b) == a) == (expected == 0) );
+    REQUIRE( (a != ntbs(b)) == (expected != 0) );
+    REQUIRE( (a <  ntbs(b)) == (expected <  0) );
+    REQUIRE( (a >  ntbs(b)) == (expected >  0) );
+    REQUIRE( (ntbs(b) <  a) == (expected >  0) );
+    REQUIRE( (ntbs(b) >= a) == (expected <= 0) );
+
+    auto ua = reinterpret_cast<unsigned char const*>(a.p);     // ntbs() takes chars only -- use trait directly
+    auto ub = reinterpret_cast<unsigned char const*>(b);
+    REQUIRE( parray_traits::ntbs_eq(a.len, ua, ub) == (expected == 0) );
+    REQUIRE( parray_traits::ntbs_lt(a.len, ua, ub) == (expected <  0) );
+    REQUIRE( parray_traits::ntbs_lt(ub, a.len, ua) == (expected >  0) );
+}
+
+TEST_CASE("ntbs_cmp", "[ntbs_cmp]")
+{
+    SECTION("random arrays")
+    {
+        mt19937 rng(7);
+        char const alphabet[] = { 'a', 'b', '\xFF', '\x80' };     // high bytes check unsigned ordering
+
+        for(size_t iter = 0; iter < 20000; ++iter)
+        {
+            size_t len_a = rng() % 80;
+            size_t len_b = (rng() % 4) ? len_a + (rng() % 3) - 1 : rng() % 80;
+            if (len_b > 100) len_b = 0;
+
+            string a(len_a, 'a'), b(len_b, 'a');
+            for(auto& c : a) c = alphabet[rng() % 2];
+            b.replace(0, min(len_a, len_b), a, 0, min(len_a, len_b));
+            if (!b.empty() && rng() % 2) b[rng() % b.size()] = alphabet[rng() % 4];
+            if (!a.empty() && rng() % 8 == 0) a[rng() % a.size()] = '\0';   // NUL inside of parray
+
+            check_ntbs_cmp(rcstring(a), b.c_str());
+        }
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    SECTION("page boundary")
+    {
+        // last page before inaccessible one -- arrays placed at its very end
+        size_t page = size_t(sysconf(_SC_PAGESIZE));
+        char* mem = static_cast<char*>(mmap(nullptr, 2*page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        REQUIRE( mem != MAP_FAILED );
+        REQUIRE( mprotect(mem + page, page, PROT_NONE) == 0 );
+
+        char* page_end = mem + page;
+        char other[128];
+        for(size_t len = 0; len < 70; ++len)
+            for(size_t len2 : { len - 1, len, len + 1 })
+            {
+                if (len2 > 100) continue;
+
+                // ntbs at the end of page
+                char* b = page_end - len2 - 1;
+                memset(b, 'x', len2);
+                b[len2] = 0;
+
+                memset(other, 'x', len);
+                check_ntbs_cmp(rcstring(len, other), b);
+                if (len) { other[len - 1] = 'y'; check_ntbs_cmp(rcstring(len, other), b); }
+
+                // parray at the end of page
+                char* a = page_end - len;
+                memset(a, 'x', len);
+                memset(other, 'x', len2);
+                other[len2] = 0;
+                check_ntbs_cmp(rcstring(len, a), other);
+            }
+
+        munmap(mem, 2*page);
+    }
+#endif
+}
+
+
+//------------------------------------------------------------------------------
+TEST_CASE("ntbs_cached", "[ntbs_cached]")
+{
+    char const* p = "abcde";
+
+    SECTION("length is calculated once, on first use")
+    {
+        auto s = ntbs_cached(p);
+        REQUIRE( !s.size_known() );
+
+        REQUIRE( s == ntba("abcde") );
+        REQUIRE( s.size_known() );
+        REQUIRE( s.size() == 5 );
+
+        REQUIRE( s != ntba("abcd") );
+        REQUIRE( s <  ntba("aaaaaa") );         // length first
+        REQUIRE( s >  ntba("zzzz") );
+        REQUIRE( ntba("abcdf") >  s );
+        REQUIRE( ntba("abcdd") <= s );
+        REQUIRE( rcstring(s) == ntba("abcde") );
+    }
+
+    SECTION("other operands")
+    {
+        auto s = ntbs_cached(p);
+        char const* q = "abcdf";
+        char const* r = "abcde";
+
+        REQUIRE( s <  ntbs(q) );
+        REQUIRE( s == ntbs(r) );
+        REQUIRE( ntbs(q) >  s );
+        REQUIRE( ntbs(r) >= s );
+        REQUIRE( s == ntbs_cached(r) );
+        REQUIRE( ntbs_cached(q) != s );
+        REQUIRE( s <  ntbs_cached(ntbs(q)) );
+
+        REQUIRE( s == string("abcde") );
+        REQUIRE( string("abcdd") < s );
+        REQUIRE( (s == vector<char>{'a', 'b', 'c', 'd', 'e'}) );
+
+        vector<char> v{'a', 'b', 'c'};
+        REQUIRE( s > v );
+        REQUIRE( v < s );
+
+        stringstream ss;
+        ss << s;
+        REQUIRE( ss.str() == "abcde" );
+    }
+
+    SECTION("same results as ntbs_t")
+    {
+        char const* words[] = { "", "a", "b", "ab", "ba", "abc", "abd", "\xFF" };
+        for(char const* l : words)
+            for(char const* r : words)
+            {
+                auto cl = ntbs_cached(l);
+                rcstring pr{ ntbs(r) };
+
+                REQUIRE( (cl == pr) == (ntbs(l) == pr) );
+                REQUIRE( (cl <  pr) == (ntbs(l) <  pr) );
+                REQUIRE( (pr <  cl) == (pr <  ntbs(l)) );
+                REQUIRE( (cl <  ntbs(r)) == (ntbs(l) < ntbs(r)) );
+                REQUIRE( (ntbs(r) < cl)  == (ntbs(r) < ntbs(l)) );
+            }
+    }
+}
+
+
+//------------------------------------------------------------------------------
+TEST_CASE("parray_flat_map", "[parray_flat_map]")
+{
+    SECTION("set")
+    {
+        parray_flat_set<char> s{ ntba("GET"), ntba("PUT"), ntba("POST"), ntba("DELETE"), ntba("GET"), ntba("") };
+
+        REQUIRE( s.size() == 5 );
+        REQUIRE( s.contains(ntba("GET")) );
+        REQUIRE( s.contains(ntba("POST")) );
+        REQUIRE( s.contains(ntba("")) );
+        REQUIRE( !s.contains(ntba("GE")) );
+        REQUIRE( !s.contains(ntba("PATCH")) );
+        REQUIRE( !s.contains(ntba("DELETED")) );
+        REQUIRE( s.count(ntba("PUT")) == 1 );
+        REQUIRE( s.count_len(3) == 2 );
+        REQUIRE( s.count_len(5) == 0 );
+
+        char const* m = "DELETE";
+        REQUIRE( *s.find(rcstring(ntbs(m))) == ntba("DELETE") );
+
+        // length-first order
+        vector<string> order;
+        for(rcstring k : s) order.push_back(k.str());
+        REQUIRE( (order == vector<string>{"", "GET", "PUT", "POST", "DELETE"}) );
+
+        REQUIRE( s.lower_bound(ntba("HEAD")) - s.begin() == 3 );    // "HEAD" < "POST"
+        REQUIRE( s.lower_bound(ntba("ZZZZZZZZ")) == s.end() );
+
+        parray_flat_set<char> e;
+        REQUIRE( e.empty() );
+        REQUIRE( !e.contains(ntba("x")) );
+    }
+
+    SECTION("set vs std::set")
+    {
+        mt19937 rng(5);
+        vector<string> words;
+        for(size_t i = 0; i < 2000; ++i)
+            words.push_back(string(rng() % 12, 'a') + to_string(rng() % 1000));
+        words.push_back(string(3000, 'x'));     // beyond directory
+        words.push_back(string(2000, 'y'));
+
+        std::set<string> ref(words.begin(), words.end());
+        parray_flat_set<char> s(words.begin(), words.end());
+        REQUIRE( s.size() == ref.size() );
+
+        for(size_t i = 0; i < 5000; ++i)
+        {
+            string k = string(rng() % 12, 'a') + to_string(rng() % 1000);
+            REQUIRE( s.contains(rcstring(k)) == (ref.count(k) != 0) );
+        }
+        REQUIRE( s.contains(rcstring(string(3000, 'x'))) );
+        REQUIRE( s.contains(rcstring(string(2000, 'y'))) );
+        REQUIRE( !s.contains(rcstring(string(2500, 'x'))) );
+        REQUIRE( !s.contains(rcstring(string(3000, 'y'))) );
+    }
+
+    SECTION("map")
+    {
+        parray_flat_map<char, int> m{ {ntba("info"), 1}, {ntba("warn"), 2}, {ntba("error"), 3}, {ntba("info"), 4} };
+
+        REQUIRE( m.size() == 3 );
+        REQUIRE( *m.find(ntba("info")) == 1 );      // first one wins
+        REQUIRE( *m.find(ntba("error")) == 3 );
+        REQUIRE( m.find(ntba("debug")) == nullptr );
+        REQUIRE( m.at(ntba("warn")) == 2 );
+        REQUIRE_THROWS_AS( m.at(ntba("fatal")), std::out_of_range const& );
+
+        *m.find(ntba("warn")) = 20;
+        REQUIRE( m.at(ntba("warn")) == 20 );
+
+        vector<string> keys;
+        int sum = 0;
+        m.for_each([&](rcstring k, int v) { keys.push_back(k.str()); sum += v; });
+        REQUIRE( (keys == vector<string>{"info", "warn", "error"}) );
+        REQUIRE( sum == 24 );
+
+        std::map<string, string> src{ {"a", "1"}, {"bb", "2"} };
+        parray_flat_map<char, string> m2(src.begin(), src.end());
+        REQUIRE( m2.at(ntba("bb")) == "2" );
+        REQUIRE( m2.index_of(ntba("c")) == m2.size() );
+    }
+}
+
+
+//------------------------------------------------------------------------------
+TEST_CASE("string_table", "[string_table]")
+{
+    mt19937 rng(11);
+    vector<string> words;
+    for(size_t i = 0; i < 3000; ++i)
+    {
+        string w = "key_" + to_string(rng() % 5000);       // plenty of shared prefixes
+        if (i % 10 == 0) w += string(rng() % 40, char(0x80 | (rng() % 4)));
+        words.push_back(w);
+    }
+    words.push_back("");
+    words.push_back(string(300, 'z'));
+
+    std::set<string> ref(words.begin(), words.end());
+    vector<string> sorted(ref.begin(), ref.end());
+    sort(sorted.begin(), sorted.end(), [](string const& l, string const& r) { return rcstring(l) < rcstring(r); });
+
+    string_table_builder b;
+    for(auto& w : words) b.add(rcstring(w));
+
+    for(size_t restart : {0, 1, 4, 16})
+    {
+        vector<char> image;
+        b.write(image, restart);
+
+        string_table t;
+        REQUIRE( t.attach(rcstring(image.size(), image.data())) );
+        REQUIRE( t.size() == ref.size() );
+        REQUIRE( t.max_len() == 300 );
+        REQUIRE( t.front_coded() == (restart != 0) );
+
+        // keys in parray_traits order
+        vector<char> buf(t.max_len());
+        for(size_t i = 0; i < sorted.size(); ++i)
+        {
+            REQUIRE( t.key(i, buf.data()) == rcstring(sorted[i]) );
+            REQUIRE( t.find(rcstring(sorted[i])) == i );
+        }
+
+        size_t n = 0;
+        t.for_each([&](rcstring k) { REQUIRE( k == rcstring(sorted[n]) ); ++n; });
+        REQUIRE( n == sorted.size() );
+
+        // misses
+        for(size_t i = 0; i < 2000; ++i)
+        {
+            string w = "key_" + to_string(rng() % 10000);
+            REQUIRE( t.contains(rcstring(w)) == (ref.count(w) != 0) );
+        }
+        REQUIRE( !t.contains(ntba("kez_1")) );
+        REQUIRE( !t.contains(ntba("a")) );
+        REQUIRE( t.contains(ntba("")) );
+
+        if (restart == 0)                                   // no per-key offsets
+        {
+            size_t key_bytes = 0;
+            for(auto& w : sorted) key_bytes += w.size();
+            set<size_t> lens;
+            for(auto& w : sorted) lens.insert(w.size());
+            REQUIRE( image.size() == sizeof(string_table_header) + lens.size()*sizeof(string_table_group) + key_bytes );
+        }
+    }
+
+    SECTION("invalid images")
+    {
+        vector<char> image;
+        b.write(image);
+
+        string_table t;
+        REQUIRE( !t.attach(rcstring(image.size() - 1, image.data())) );
+        REQUIRE( !t.attach(rcstring(10, image.data())) );
+        image[0] = 'X';
+        REQUIRE( !t.attach(rcstring(image.size(), image.data())) );
+        REQUIRE( t.empty() );
+        REQUIRE( t.find(ntba("key_1")) == string_table::npos );
+    }
+
+    SECTION("corrupt images are rejected or stay in bounds")
+    {
+        for(size_t restart : {0, 4})
+        {
+            vector<char> image;
+            b.write(image, restart);
+            auto h = reinterpret_cast<string_table_header const*>(image.data());
+            size_t meta_end = sizeof(string_table_header) + h->group_count*sizeof(string_table_group) + h->offset_count*sizeof(uint64_t);
+
+            // truncated file with header patched to match
+            vector<uint64_t> cut((image.size() + 7)/8);
+            memcpy(cut.data(), image.data(), image.size());
+            reinterpret_cast<string_table_header*>(cut.data())->blob_size -= 100;
+            string_table t;
+            REQUIRE( !t.attach(rcstring(image.size() - 100, reinterpret_cast<char const*>(cut.data()))) );
+
+            // random damage in groups/offsets (and front-coded blob), then whatever got attached is used
+            size_t accepted = 0;
+            for(int iter = 0; iter < 2000; ++iter)
+            {
+                vector<uint64_t> buf((image.size() + 7)/8);
+                memcpy(buf.data(), image.data(), image.size());
+                char* p = reinterpret_cast<char*>(buf.data());
+                size_t range = restart ? image.size() : meta_end;
+                size_t at = sizeof(string_table_header) + rng() % (range - sizeof(string_table_header));
+                p[at] ^= char(1 << (rng() % 8));
+
+                string_table c;
+                if (!c.attach(rcstring(image.size(), p))) continue;
+                ++accepted;
+                vector<char> kb(c.max_len());
+                for(size_t i = 0; i < c.size(); i += 97) c.key(i, kb.data());
+                for(size_t i = 0; i < sorted.size(); i += 13) c.find(rcstring(sorted[i]));
+                size_t n = 0;
+                c.for_each([&](rcstring) { ++n; });
+                REQUIRE( n == c.size() );
+            }
+            REQUIRE( accepted < 2000 );
+        }
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    SECTION("file")
+    {
+        char path[] = "/tmp/parray_string_table_XXXXXX";
+        int fd = mkstemp(path);
+        REQUIRE( fd >= 0 );
+        close(fd);
+
+        REQUIRE( b.save(path, 16) );
+
+        string_table t;
+        REQUIRE( t.open(path) );
+        REQUIRE( t.size() == ref.size() );
+        REQUIRE( t.find(rcstring(sorted[7])) == 7 );
+
+        unlink(path);
+        REQUIRE( !t.open(path) );
+        REQUIRE( t.empty() );
+    }
+#endif
+}
+
+
+//------------------------------------------------------------------------------
+TEST_CASE("sort_parrays", "[sort_parrays]")
+{
+    mt19937 rng(3);
+
+    // duplicates with distinct addresses (stability), common prefixes, high bytes, sparse lengths
+    vector<string> storage;
+    for(size_t i = 0; i < 20000; ++i)
+    {
+        string s;
+        switch(rng() % 4)
+        {
+        case 0: s = to_string(rng() % 500); break;
+        case 1: s = "common/prefix/" + to_string(rng() % 3000); break;
+        case 2: s = string(rng() % 50, char(0x7F + rng() % 3)); break;
+        default: s = string(rng() % 100, 'a'); for(auto& c : s) c = char(rng() % 256); break;
+        }
+        storage.push_back(s);
+    }
+
+    vector<rcstring> keys;
+    for(auto& s : storage) keys.push_back(rcstring(s));
+
+    auto same_values = [](vector<rcstring> const& l, vector<rcstring> const& r) { return equal(l.begin(), l.end(), r.begin(), r.end()); };
+    auto same_ptrs = [](vector<rcstring> const& l, vector<rcstring> const& r) {
+        return equal(l.begin(), l.end(), r.begin(), r.end(), [](rcstring a, rcstring b) { return a.p == b.p && a.len == b.len; });
+    };
+
+    SECTION("same result as std::sort/std::stable_sort")
+    {
+        for(size_t n : {0, 1, 2, 31, 33, 1000, 20000})
+        {
+            vector<rcstring> v(keys.begin(), keys.begin() + n);
+            vector<rcstring> ref = v, s1 = v, s2 = v;
+
+            std::stable_sort(ref.begin(), ref.end());
+            sort_parrays(s1.begin(), s1.end());
+            stable_sort_parrays(s2.begin(), s2.end());
+
+            REQUIRE( same_values(s1, ref) );
+            REQUIRE( same_ptrs(s2, ref) );
+        }
+    }
+
+    SECTION("unsigned chars, sparse lengths, other types")
+    {
+        vector<rcbytes> b;
+        for(rcstring k : keys) b.push_back(rcbytes(k.len, reinterpret_cast<unsigned char const*>(k.p)));
+        vector<rcbytes> ref = b;
+        std::stable_sort(ref.begin(), ref.end());
+        stable_sort_parrays(b.begin(), b.end());
+        REQUIRE( equal(b.begin(), b.end(), ref.begin(), ref.end()) );
+
+        string huge(1000000, 'q');
+        vector<rcstring> sparse = { rcstring(huge), ntba("b"), rcstring(huge.size() - 1, huge.data()), ntba("a"), ntba("") };
+        vector<rcstring> sref = sparse;
+        std::sort(sref.begin(), sref.end());
+        sort_parrays(sparse.begin(), sparse.end());
+        REQUIRE( equal(sparse.begin(), sparse.end(), sref.begin(), sref.end()) );
+
+        vector<int> i1{3, 2, 1}, i2{1}, i3{2, 2};
+        vector<parray<int const>> ints = { parray<int const>(i1), parray<int const>(i2), parray<int const>(i3) };
+        sort_parrays(ints.begin(), ints.end());
+        REQUIRE( ints[0].len == 1 );
+        REQUIRE( ints[2].len == 3 );
+    }
+
+    SECTION("long shared prefixes")                             // every byte position splits off one key
+    {
+        size_t const n = 3000;
+        vector<string> deep(n, string(n, 'a'));
+        for(size_t i = 0; i < n; ++i) deep[i][i] = 'b';
+
+        vector<rcstring> v;
+        for(auto& s : deep) v.push_back(rcstring(s));
+        shuffle(v.begin(), v.end(), rng);
+
+        vector<rcstring> ref = v;
+        std::stable_sort(ref.begin(), ref.end());
+        sort_parrays(v.begin(), v.end());
+        REQUIRE( same_ptrs(v, ref) );
+        REQUIRE( v.front().p == deep.back().data() );
+    }
+}
+
+
+//------------------------------------------------------------------------------
+TEST_CASE("parallel_sort_unique", "[parallel_sort_unique]")
+{
+    mt19937 rng(9);
+
+    // lots of duplicates (some share memory), one dominant length group with common prefix
+    vector<string> storage;
+    for(size_t i = 0; i < 150000; ++i)
+    {
+        switch(rng() % 3)
+        {
+        case 0: storage.push_back("dictionary/entry/" + to_string(100000 + rng() % 50000)); break;
+        case 1: storage.push_back(to_string(rng() % 20000)); break;
+        default: storage.push_back(string(rng() % 20, char('a' + rng() % 3))); break;
+        }
+    }
+
+    vector<rcstring> keys;
+    for(auto& s : storage) keys.push_back(rcstring(s));
+    for(size_t i = 0; i < 10000; ++i) keys.push_back(keys[rng() % keys.size()]);     // same pointer duplicates
+
+    vector<rcstring> ref = keys;
+    std::sort(ref.begin(), ref.end());
+    ref.erase(std::unique(ref.begin(), ref.end()), ref.end());
+
+    for(unsigned threads : {1, 2, 3, 8})
+        for(size_t n : {size_t(0), size_t(1), size_t(1000), keys.size()})
+        {
+            vector<rcstring> v(keys.begin(), keys.begin() + n);
+            vector<rcstring> r = v;
+            std::sort(r.begin(), r.end());
+            r.erase(std::unique(r.begin(), r.end()), r.end());
+
+            parallel_sort_unique(v, threads);
+            REQUIRE( equal(v.begin(), v.end(), r.begin(), r.end()) );
+        }
+
+    vector<rcstring> v = keys;
+    parallel_sort_unique(v);
+    REQUIRE( equal(v.begin(), v.end(), ref.begin(), ref.end()) );
+
+    vector<int> i1{1, 2}, i2{1};
+    vector<parray<int const>> ints = { parray<int const>(i1), parray<int const>(i2), parray<int const>(i1) };
+    parallel_sort_unique(ints, 4);
+    REQUIRE( ints.size() == 2 );
+    REQUIRE( ints[0].len == 1 );
+
+    // long shared prefixes: windows a..ab..b of (a * len + b * len), every byte position splits off one key
+    size_t const len = 4000;
+    string ab = string(len, 'a') + string(len, 'b');
+    vector<rcstring> deep(keys.begin(), keys.begin() + 70000);
+    for(size_t i = 0; i <= len; ++i)
+    {
+        deep.push_back(rcstring(len, ab.data() + i));
+        if (i % 3 == 0) deep.push_back(deep.back());
+    }
+    shuffle(deep.begin(), deep.end(), rng);
+
+    vector<rcstring> dref = deep;
+    std::sort(dref.begin(), dref.end());
+    dref.erase(std::unique(dref.begin(), dref.end()), dref.end());
+
+    for(unsigned threads : {2, 4})
+    {
+        vector<rcstring> d = deep;
+        parallel_sort_unique(d, threads);
+        REQUIRE( equal(d.begin(), d.end(), dref.begin(), dref.end()) );
+    }
+}
+
+
+//------------------------------------------------------------------------------
+TEST_CASE("parray_lex_traits", "[parray_lex_traits]")
+{
+    using lex_string = parray<char const, parray_lex_traits>;
+    auto lex = [](char const* s) { return lex_string(ntbs<parray_lex_traits>(s)); };
+
+    SECTION("arrays")
+    {
+        REQUIRE( lex("abc") < lex("b") );
+        REQUIRE( lex("ab")  < lex("abc") );
+        REQUIRE( lex("")    < lex("a") );
+        REQUIRE( !(lex("b") < lex("abc")) );
+        REQUIRE( lex("b") > lex("abc") );
+        REQUIRE( lex("abc") <= lex("abc") );
+        REQUIRE( lex("abc") == lex("abc") );
+        REQUIRE( lex("\xFF") > lex("a") );          // unsigned bytes
+
+        vector<int> a{1, 2, 3}, b{1, 3};
+        REQUIRE( (parray<int, parray_lex_traits>(a) < parray<int, parray_lex_traits>(b)) );
+        REQUIRE( !(parray<int const>(a) < parray<int const>(b)) );
+    }
+
+    SECTION("ntbs, same results as strcmp")
+    {
+        mt19937 rng(1);
+        char const alphabet[] = { 'a', 'b', '\x80' };
+        for(size_t i = 0; i < 20000; ++i)
+        {
+            string l(rng() % 40, 'a'), r(rng() % 40, 'a');
+            for(auto& c : l) c = alphabet[rng() % 3];
+            for(auto& c : r) c = alphabet[rng() % 3];
+            if (rng() % 2) r = l.substr(0, rng() % (l.size() + 1)) + r.substr(0, rng() % 3);
+
+            int expected = strcmp(l.c_str(), r.c_str());
+            lex_string lv = lex(l.c_str());
+
+            REQUIRE( (ntbs<parray_lex_traits>(l.c_str()) < ntbs<parray_lex_traits>(r.c_str())) == (expected < 0) );
+            REQUIRE( (lv <  ntbs<parray_lex_traits>(r.c_str())) == (expected < 0) );
+            REQUIRE( (lv == ntbs<parray_lex_traits>(r.c_str())) == (expected == 0) );
+            REQUIRE( (ntbs<parray_lex_traits>(r.c_str()) < lv) == (expected > 0) );
+            REQUIRE( (lv >= lex(r.c_str())) == (expected >= 0) );
+
+            wstring wl(l.begin(), l.end()), wr(r.begin(), r.end());
+            REQUIRE( (ntbs<parray_lex_traits>(wl.c_str()) < ntbs<parray_lex_traits>(wr.c_str())) == (wl < wr) );
+        }
+    }
+
+    SECTION("prefix ranges")
+    {
+        vector<lex_string> v = { lex("apple"), lex("app"), lex("banana"), lex("application"), lex("apt"), lex("b"), lex("") };
+        sort(v.begin(), v.end());
+
+        REQUIRE( v[0] == lex("") );
+        REQUIRE( v[1] == lex("app") );
+
+        auto r = prefix_range(v.begin(), v.end(), lex("app"));
+        REQUIRE( r.second - r.first == 3 );          // app, apple, application
+        REQUIRE( *r.first == lex("app") );
+
+        REQUIRE( prefix_upper_bound(v.begin(), v.end(), lex("ap")) - v.begin() == 5 );
+        REQUIRE( prefix_lower_bound(v.begin(), v.end(), lex("c")) == v.end() );
+
+        auto e = prefix_range(v.begin(), v.end(), lex("bz"));
+        REQUIRE( e.first == e.second );
+
+        auto all = prefix_range(v.begin(), v.end(), lex(""));
+        REQUIRE( all.second - all.first == ptrdiff_t(v.size()) );
+    }
+}
+
+
+//------------------------------------------------------------------------------
+TEST_CASE("parray_icase_traits", "[parray_icase_traits]")
+{
+    using icase_string = parray<char const, parray_icase_traits>;
+    auto ic = [](char const* s) { return icase_string(ntbs<parray_icase_traits>(s)); };
+
+    // reference: compare lowercased copies (length first)
+    auto ref_cmp = [](string l, string r) {
+        if (l.size() != r.size()) return (l.size() < r.size()) ? -1 : 1;
+        for(auto& c : l) if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        for(auto& c : r) if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+        int c = memcmp(l.data(), r.data(), l.size());
+        return (c < 0) ? -1 : (c > 0) ? 1 : 0;
+    };
+
+    SECTION("arrays")
+    {
+        REQUIRE( ic("Content-Length") == ic("content-length") );
+        REQUIRE( ic("CONTENT-LENGTH") == ic("content-length") );
+        REQUIRE( ic("Host") != ic("Hosts") );
+        REQUIRE( ic("zz") < ic("AAA") );               // length first
+        REQUIRE( ic("B") > ic("a") );
+        REQUIRE( ic("_") < ic("A") );                  // '_' < 'a'
+        REQUIRE( ic("@") != ic("`") );                 // only letters are folded
+        REQUIRE( ic("[") != ic("{") );
+        REQUIRE( ic("\xC0") != ic("\xE0") );           // non-ASCII bytes are compared as is
+        REQUIRE( ic("Accept") == ntba<parray_icase_traits>("ACCEPT") );
+
+        vector<int> a{'A', 'b'}, b{'a', 'B'};
+        REQUIRE( (parray<int, parray_icase_traits>(a) == parray<int, parray_icase_traits>(b)) );
+
+        unsigned char const u1[] = {'A', 'b', 'C', 0xC0}, u2[] = {'a', 'B', 'c', 0xC0};
+        REQUIRE( (parray<unsigned char const, parray_icase_traits>(u1) == parray<unsigned char const, parray_icase_traits>(u2)) );
+    }
+
+    SECTION("random arrays and ntbs")
+    {
+        mt19937 rng(1);
+        char const alphabet[] = { 'a', 'A', 'z', 'Z', '@', '[', '`', '{', '\x80', '\xC1' };
+        for(size_t i = 0; i < 20000; ++i)
+        {
+            string l(rng() % 70, 'a');
+            for(auto& c : l) c = alphabet[rng() % 10];
+            string r = l;
+            for(auto& c : r) if (rng() % 4 == 0) c = alphabet[rng() % 10];
+            if (rng() % 8 == 0) r.resize(rng() % 70, 'A');
+
+            int expected = ref_cmp(l, r);
+            icase_string lv(l.size(), l.data()), rv(r.size(), r.data());
+
+            REQUIRE( (lv == rv) == (expected == 0) );
+            REQUIRE( (lv <  rv) == (expected < 0) );
+            REQUIRE( (lv >= rv) == (expected >= 0) );
+            REQUIRE( (lv == ntbs<parray_icase_traits>(r.c_str())) == (expected == 0) );
+            REQUIRE( (ntbs<parray_icase_traits>(r.c_str()) < lv) == (expected > 0) );
+            REQUIRE( (ntbs<parray_icase_traits>(l.c_str()) < ntbs<parray_icase_traits>(r.c_str())) == (expected < 0) );
+            if (expected == 0) REQUIRE( hash<icase_string>()(lv) == hash<icase_string>()(rv) );
+        }
+    }
+
+    SECTION("hashing")
+    {
+        REQUIRE( hash<rcstring>()(ntba("abc")) == hash<rcstring>()(rcstring(string("abc"))) );
+        REQUIRE( hash<rcstring>()(ntba("abc")) != hash<rcstring>()(ntba("ABC")) );
+        REQUIRE( hash<icase_string>()(ntba<parray_icase_traits>("abc")) == hash<icase_string>()(ntba<parray_icase_traits>("ABC")) );
+        REQUIRE( hash<rcstring>()(ntba("abc")) == hash<icase_string>()(ntba<parray_icase_traits>("abc")) );
+
+        // chaining
+        size_t h = parray_traits::hash(2, "ab");
+        REQUIRE( parray_traits::hash(1, "c", h) == hash<rcstring>()(ntba("abc")) );
+
+        vector<int> v{1, 2, 3};
+        REQUIRE( hash<parray<int const>>()(parray<int const>(v)) == hash<parray<int>>()(parray<int>(v)) );
+
+        unordered_map<icase_string, int> m;
+        m[ntba<parray_icase_traits>("Content-Length")] = 1;
+        m[ntba<parray_icase_traits>("Content-Type")] = 2;
+        m[ntba<parray_icase_traits>("content-length")] = 3;
+        REQUIRE( m.size() == 2 );
+        REQUIRE( m[ntba<parray_icase_traits>("CONTENT-LENGTH")] == 3 );
+        REQUIRE( m.count(ntba<parray_icase_traits>("content-TYPE")) == 1 );
+        REQUIRE( m.count(ntba<parray_icase_traits>("Host")) == 0 );
+
+        unordered_map<rcstring, int> m2{ {ntba("a"), 1}, {ntba("A"), 2} };
+        REQUIRE( m2.size() == 2 );
+    }
+
+    SECTION("flat map key")
+    {
+        parray_flat_map<char, int, parray_icase_traits> m{ {ntba<parray_icase_traits>("Host"), 1}, {ntba<parray_icase_traits>("Accept"), 2}, {ntba<parray_icase_traits>("ACCEPT"), 3} };
+        REQUIRE( m.size() == 2 );
+        REQUIRE( m.at(icase_string(ntba<parray_icase_traits>("accept"))) == 2 );
+        REQUIRE( m.contains(icase_string(ntba<parray_icase_traits>("HOST"))) );
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    SECTION("page boundary")
+    {
+        size_t page = size_t(sysconf(_SC_PAGESIZE));
+        char* mem = static_cast<char*>(mmap(nullptr, 2*page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        REQUIRE( mem != MAP_FAILED );
+        REQUIRE( mprotect(mem + page, page, PROT_NONE) == 0 );
+
+        char other[128];
+        for(size_t len = 0; len < 70; ++len)
+        {
+            char* a = mem + page - len;
+            memset(a, 'X', len);
+            memset(other, 'x', len);
+            REQUIRE( icase_string(len, a) == icase_string(len, other) );
+            if (len)
+            {
+                other[len - 1] = 'y';
+                REQUIRE( icase_string(len, a) < icase_string(len, other) );
+            }
+        }
+
+        munmap(mem, 2*page);
+    }
+#endif
+}
+
+
+//------------------------------------------------------------------------------
+TEST_CASE("parray_ct_traits", "[parray_ct_traits]")
+{
+    using secret = parray<unsigned char const, parray_ct_traits>;
+
+    SECTION("bytes")
+    {
+        mt19937 rng(1);
+        for(size_t len = 0; len < 150; ++len)
+        {
+            vector<unsigned char> a(len), b;
+            for(auto& c : a) c = static_cast<unsigned char>(rng());
+            b = a;
+
+            REQUIRE( secret(a) == secret(b) );
+            REQUIRE( !(secret(a) != secret(b)) );
+            for(size_t i = 0; i < len; ++i)
+            {
+                b[i] ^= static_cast<unsigned char>(1 << (rng() % 8));
+                REQUIRE( secret(a) != secret(b) );
+                REQUIRE( !(secret(a) == secret(b)) );
+                b[i] = a[i];
+            }
+
+            b.push_back(0);
+            REQUIRE( secret(a) != secret(b) );
+            REQUIRE( (secret(a) < secret(b)) );                // ordering is inherited
+        }
+    }
+
+    SECTION("other element types")
+    {
+        vector<int> a{1, 2, 3, -4, 5}, b = a;
+        REQUIRE( (parray<int const, parray_ct_traits>(a) == parray<int const, parray_ct_traits>(b)) );
+        b[3] = 4;
+        REQUIRE( (parray<int const, parray_ct_traits>(a) != parray<int const, parray_ct_traits>(b)) );
+
+        char const* t = "token-123";
+        char volatile v[] = "token-123";
+        REQUIRE( (parray<char volatile, parray_ct_traits>(ntba<parray_ct_traits>(v)) == ntbs<parray_ct_traits>(t)) );
+        char const* t2 = "token-124";
+        REQUIRE( (ntbs<parray_ct_traits>(t) == ntbs<parray_ct_traits>(string(t).c_str())) );
+        REQUIRE( (ntbs<parray_ct_traits>(t) != ntbs<parray_ct_traits>(t2)) );
+        REQUIRE( (parray<char const, parray_ct_traits>(ntba<parray_ct_traits>("token-12")) != ntbs<parray_ct_traits>(t)) );
+
+        double d1[] = {0.0, 1.0}, d2[] = {-0.0, 1.0};               // compared by value, not by bytes
+        REQUIRE( (parray<double, parray_ct_traits>(d1) == parray<double, parray_ct_traits>(d2)) );
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// stateful allocator: copies of container get default-constructed (id 0) allocator, frees are checked against id;
+// it propagates on container assignment if Propagate is set, otherwise it can't be assigned at all
+struct allocator_assignable {};
+struct allocator_not_assignable
+{
+    allocator_not_assignable() = default;
+    allocator_not_assignable(allocator_not_assignable const&) = default;
+    allocator_not_assignable& operator=(allocator_not_assignable const&) = delete;
+};
+
+template<class T, bool Propagate = false>
+struct tagged_allocator : conditional_t<Propagate, allocator_assignable, allocator_not_assignable>
+{
+    using value_type = T;
+    using propagate_on_container_copy_assignment = integral_constant<bool, Propagate>;
+    using propagate_on_container_move_assignment = integral_constant<bool, Propagate>;
+    template<class U> struct rebind { using other = tagged_allocator<U, Propagate>; };
+
+    int id = 0;
+    int* live = nullptr;                                // outstanding allocations made by this id
+
+    tagged_allocator() = default;
+    tagged_allocator(int id_, int* live_) : id(id_), live(live_) {}
+    template<class U> tagged_allocator(tagged_allocator<U, Propagate> const& o) : id(o.id), live(o.live) {}
+
+    T* allocate(size_t n)               { if (live) ++*live; return static_cast<T*>(::operator new(n * sizeof(T))); }
+    void deallocate(T* p, size_t)       { if (live) --*live; ::operator delete(p); }
+
+    tagged_allocator select_on_container_copy_construction() const { return tagged_allocator(); }
+
+    template<class U> bool operator==(tagged_allocator<U, Propagate> const& o) const { return id == o.id; }
+    template<class U> bool operator!=(tagged_allocator<U, Propagate> const& o) const { return id != o.id; }
+};
+
+
+//------------------------------------------------------------------------------
+TEST_CASE("owned arrays", "[parray_owned]")
+{
+    SECTION("fixed_string")
+    {
+        fixed_string<16> k{ ntba("Content-Length") };
+        REQUIRE( k.size() == 14 );
+        REQUIRE( k.capacity() == 16 );
+        REQUIRE( k == ntba("Content-Length") );
+        REQUIRE( ntba("Content-Length") == k );
+        REQUIRE( k != ntba("Content-Type") );
+        REQUIRE( k > ntba("Content-Type") );           // length first
+        REQUIRE( k == string("Content-Length") );
+        char const* cl = "Content-Length";
+        REQUIRE( k == ntbs(cl) );
+
+        rcstring r = k;
+        REQUIRE( (r.p == k.data()) );
+        REQUIRE( r == k.view() );
+
+        fixed_string<16> k2 = k;
+        REQUIRE( k2 == k );
+        k2[0] = 'c';
+        REQUIRE( k2 != k );
+        REQUIRE( (k2 > k) );
+
+        k2.clear();
+        k2.append(ntba("abc")).append(ntba("def"));
+        k2.push_back('g');
+        REQUIRE( k2 == ntba("abcdefg") );
+        REQUIRE_THROWS_AS( k2.append(ntba("0123456789")), std::length_error const& );
+        REQUIRE( k2 == ntba("abcdefg") );
+        REQUIRE_THROWS_AS( (fixed_string<2>(ntba("abc"))), std::length_error const& );
+
+        k2.resize(3);
+        REQUIRE( k2 == ntba("abc") );
+        k2.assign(k2.view().mid(1, 2));                 // overlapping
+        REQUIRE( k2 == ntba("bc") );
+
+        ostringstream os;
+        os << k;
+        REQUIRE( os.str() == "Content-Length" );
+
+        int ints[] = {1, 2, 3};
+        fixed_string<4, int> fi{ parray<int>(ints) };
+        REQUIRE( fi == ints );
+
+        unordered_map<fixed_string<32>, int> m;
+        m[fixed_string<32>(ntba("a"))] = 1;
+        REQUIRE( m.count(fixed_string<32>(ntba("a"))) == 1 );
+        REQUIRE( hash<fixed_string<32>>()(fixed_string<32>(ntba("xyz"))) == hash<rcstring>()(ntba("xyz")) );
+    }
+
+    SECTION("owned_parray")
+    {
+        owned_parray<char> b;
+        REQUIRE( b.empty() );
+        REQUIRE( b == rcstring{} );
+
+        b.append(ntba("user="));
+        for(int i = 0; i < 100; ++i) b.append(ntba("0123456789"));
+        REQUIRE( b.size() == 1005 );
+        REQUIRE( b.view().left(5) == ntba("user=") );
+        REQUIRE( b.capacity() >= 1005 );
+
+        b.append(b.view());                             // appending itself (reallocates)
+        REQUIRE( b.size() == 2010 );
+        REQUIRE( b.view().right(1005) == b.view().left(1005) );
+
+        owned_parray<char> c = b;
+        REQUIRE( c == b );
+        REQUIRE( (c.data() != b.data()) );
+        c.push_back('x');
+        REQUIRE( c > b );
+
+        owned_parray<char> d = std::move(c);
+        REQUIRE( c.empty() );
+        REQUIRE( d.size() == 2011 );
+        c = std::move(d);
+        REQUIRE( c.size() == 2011 );
+
+        b.assign(ntba("abc"));
+        REQUIRE( b == ntba("abc") );
+        b.assign(b.view().right(2));
+        REQUIRE( b == ntba("bc") );
+        b.shrink_to_fit();
+        REQUIRE( b.capacity() == 2 );
+        b.resize(4, 'z');
+        REQUIRE( b == ntba("bczz") );
+
+        fixed_string<8> f{ ntba("bczz") };
+        REQUIRE( b == f );
+        REQUIRE( f == b );
+        REQUIRE( (b <= f) );
+
+        rstring w = b;                                  // mutable view
+        w[0] = 'B';
+        REQUIRE( b == ntba("Bczz") );
+
+        using icase_key = owned_parray<char, allocator<char>, parray_icase_traits>;
+        unordered_map<icase_key, int> m;
+        m[icase_key(ntba<parray_icase_traits>("Host"))] = 1;
+        REQUIRE( m.count(icase_key(ntba<parray_icase_traits>("HOST"))) == 1 );
+        REQUIRE( icase_key(ntba<parray_icase_traits>("Host")) == ntba<parray_icase_traits>("hOST") );
+
+        vector<owned_parray<char>> v;
+        for(auto s : {"b", "aa", "a"}) v.emplace_back(rcstring(ntbs(s)));
+        sort(v.begin(), v.end());
+        REQUIRE( v[0] == ntba("a") );
+        REQUIRE( v[2] == ntba("aa") );
+    }
+
+    SECTION("stateful allocator")
+    {
+        int live = 0;
+        {
+            owned_parray<char, tagged_allocator<char>> b(tagged_allocator<char>(7, &live));
+            b.reserve(100);
+            b.assign(ntba("abc"));
+            REQUIRE( live == 1 );
+
+            b.shrink_to_fit();                          // keeps allocator
+            REQUIRE( b.capacity() == 3 );
+            REQUIRE( b == ntba("abc") );
+            REQUIRE( b.get_allocator().id == 7 );
+            REQUIRE( live == 1 );
+
+            b.clear();
+            b.shrink_to_fit();
+            REQUIRE( b.capacity() == 0 );
+            REQUIRE( live == 0 );
+
+            b.assign(ntba("xyz"));
+            owned_parray<char, tagged_allocator<char>> c = b;
+            REQUIRE( c.get_allocator().id == 0 );
+            REQUIRE( c == b );
+
+            c.assign(ntba("copy"));                     // allocators don't propagate (and can't be assigned)
+            b = c;
+            REQUIRE( b == ntba("copy") );
+            REQUIRE( b.get_allocator().id == 7 );
+            c.assign(ntba("moved"));
+            b = std::move(c);                           // different allocators -- copies
+            REQUIRE( b == ntba("moved") );
+            REQUIRE( b.get_allocator().id == 7 );
+        }
+        REQUIRE( live == 0 );
+
+        int live1 = 0, live2 = 0;
+        {
+            using palloc = tagged_allocator<char, true>;
+            owned_parray<char, palloc> b(palloc(1, &live1)), c(palloc(2, &live2));
+            b.assign(ntba("first"));
+            c.assign(ntba("second"));
+
+            b = c;                                      // allocator is copied, old memory is freed by old one
+            REQUIRE( b == ntba("second") );
+            REQUIRE( b.get_allocator().id == 2 );
+            REQUIRE( live1 == 0 );
+            REQUIRE( live2 == 2 );
+
+            owned_parray<char, palloc> d(palloc(1, &live1));
+            d.assign(ntba("third"));
+            d = std::move(b);                           // takes memory and allocator of b
+            REQUIRE( d == ntba("second") );
+            REQUIRE( d.get_allocator().id == 2 );
+            REQUIRE( live1 == 0 );
+            REQUIRE( live2 == 2 );
+        }
+        REQUIRE( live1 == 0 );
+        REQUIRE( live2 == 0 );
+    }
+}
+
+
+//------------------------------------------------------------------------------
+TEST_CASE("shared_buffer", "[parray_shared]")
+{
+    SECTION("slices keep buffer alive")
+    {
+        shared_slice<char> user, all;
+        {
+            string received = "user=bob;id=42";
+            shared_buffer<char> msg{ rcstring(received) };
+            REQUIRE( msg.use_count() == 1 );
+            REQUIRE( msg == rcstring(received) );
+            REQUIRE( (msg.data() != received.data()) );
+
+            rcstring field = msg.view().mid(5, 3);      // parsed as usual
+            user = msg.share(field);
+            all = msg.slice();
+            REQUIRE( msg.use_count() == 3 );
+
+            REQUIRE_THROWS_AS( msg.share(rcstring(received)), std::out_of_range const& );
+            REQUIRE_THROWS_AS( msg.share(msg.view().right(1).mid(0, 2)), std::out_of_range const& );
+            REQUIRE( msg.share(rcstring{}).empty() );
+        }
+
+        REQUIRE( user == ntba("bob") );
+        REQUIRE( user.use_count() == 2 );
+        REQUIRE( all.size() == 14 );
+
+        shared_slice<char> id = all.right(2);
+        REQUIRE( id == ntba("42") );
+        REQUIRE( id.use_count() == 3 );
+        REQUIRE( all.left(4) == ntba("user") );
+        REQUIRE( all.mid(9, 2) == ntba("id") );
+        REQUIRE( all.share(all.view().mid(9, 2)) == ntba("id") );
+        REQUIRE_THROWS_AS( user.share(all.view()), std::out_of_range const& );
+
+        all = shared_slice<char>();
+        REQUIRE( user.use_count() == 2 );
+        REQUIRE( user == ntba("bob") );                 // still alive
+
+        shared_slice<char> moved = std::move(user);
+        REQUIRE( user.empty() );
+        REQUIRE( user.use_count() == 0 );
+        REQUIRE( moved.use_count() == 2 );
+
+        rcstring r = moved;
+        REQUIRE( r == ntba("bob") );
+    }
+
+    SECTION("comparisons and hashing")
+    {
+        auto buf = shared_buffer<char>::make(6, [](char* p, size_t n) { memcpy(p, "abcabc", n); });
+        REQUIRE( buf.slice().left(3) == buf.slice().right(3) );
+        REQUIRE( buf.slice().left(3) < buf );
+        REQUIRE( buf.slice().left(3) == fixed_string<4>(ntba("abc")) );
+        REQUIRE( ntba("abcabc") == buf );
+        REQUIRE( hash<shared_slice<char>>()(buf.slice().left(3)) == hash<rcstring>()(ntba("abc")) );
+
+        unordered_map<shared_slice<char>, int> m;
+        m[buf.slice().left(3)] = 1;
+        m[buf.slice().right(3)] = 2;
+        REQUIRE( m.size() == 1 );
+        REQUIRE( buf.use_count() == 2 );
+
+        ostringstream os;
+        os << buf.slice().mid(1, 2);
+        REQUIRE( os.str() == "bc" );
+
+        shared_buffer<char> empty;
+        REQUIRE( empty.empty() );
+        REQUIRE( empty.slice().empty() );
+        REQUIRE( empty == rcstring{} );
+    }
+
+    SECTION("threads")
+    {
+        shared_buffer<char> buf{ ntba("0123456789") };
+        vector<thread> threads;
+        for(int t = 0; t < 4; ++t)
+            threads.emplace_back([&buf]() {
+                for(int i = 0; i < 10000; ++i)
+                {
+                    shared_slice<char> s = buf.slice().mid(size_t(i % 10), 1);
+                    shared_slice<char> c = s;
+                    if (c.size() != 1) abort();
+                }
+            });
+        for(auto& t : threads) t.join();
+        REQUIRE( buf.use_count() == 1 );
+    }
+}
+
+
+//------------------------------------------------------------------------------
+TEST_CASE("parray_rope", "[parray_rope]")
+{
+    SECTION("small")
+    {
+        parray_rope<char> r;
+        REQUIRE( r.empty() );
+        REQUIRE( r.size() == 0 );
+
+        r.append(ntba("<li>")).append(ntba("")).append(ntba("item")).append(ntba("</li>"));
+        REQUIRE( r.size() == 13 );
+        REQUIRE( r.fragments() == 3 );                  // empty fragment is skipped
+        REQUIRE( r[0] == '<' );
+        REQUIRE( r[4] == 'i' );
+        REQUIRE( r[12] == '>' );
+
+        string s;
+        r.append_to(s);
+        REQUIRE( s == "<li>item</li>" );
+
+        char buf[8];
+        REQUIRE( r.copy_to(buf, 6, 3) == ntba(">item<") );
+        REQUIRE( r.copy_to(buf, 8, 10) == ntba("li>") );
+        REQUIRE( r.copy_to(buf, 8, 20).empty() );
+
+        vector<string> parts;
+        r.for_each(2, 4, [&](rcstring v) { parts.push_back(v.str()); });
+        REQUIRE( parts == (vector<string>{ "i>", "it" }) );
+
+        vector<char> arena(100);
+        size_t used = 0;
+        rstring flat = r.flatten([&](size_t n) { char* p = &arena[used]; used += n; return p; });
+        REQUIRE( flat == ntba("<li>item</li>") );
+        REQUIRE( used == 13 );
+
+        parray_rope<char> r2;
+        r2.append(r).append(r);
+        REQUIRE( r2.size() == 26 );
+
+        r.clear();
+        REQUIRE( r.empty() );
+        r.append(ntba("x"));
+        REQUIRE( r.size() == 1 );
+        REQUIRE( r[0] == 'x' );
+
+        parray_rope<char> m = std::move(r2);
+        REQUIRE( m.size() == 26 );
+
+        // appending itself (fragments span several chunks)
+        for(size_t n : {3, 64, 100})
+        {
+            parray_rope<char> s;
+            string ref;
+            for(size_t i = 0; i < n; ++i) { s.append(ntba("ab")).append(ntba("c")); ref += "abc"; }
+            s.append(s);
+            REQUIRE( s.fragments() == 4*n );
+            REQUIRE( s.size() == 2*ref.size() );
+            string flat(s.size(), '\0');
+            s.flatten(&flat[0]);
+            REQUIRE( flat == ref + ref );
+        }
+    }
+
+    SECTION("join")
+    {
+        rcstring items[] = { ntba("a"), ntba(""), ntba("bc") };
+        parray_rope<char> r;
+        {
+            char d = ',';
+            r.join(begin(items), end(items), d);        // single value delimiter is copied
+        }
+        r.append(ntba(";"));
+        r.rjoin_se(begin(items), end(items), ntba("--"));
+
+        string s;
+        r.append_to(s);
+        REQUIRE( s == "a,,bc;bc--a" );
+    }
+
+    SECTION("many fragments")
+    {
+        mt19937 rng(1);
+        string blob(4096, 0);
+        for(auto& c : blob) c = char('a' + rng() % 26);
+
+        parray_rope<char> r;
+        string expected;
+        for(size_t i = 0; i < 5000; ++i)
+        {
+            size_t pos = rng() % 4000, len = rng() % 20;
+            r.append(rcstring(len, blob.data() + pos));
+            expected.append(blob.data() + pos, len);
+        }
+        REQUIRE( r.size() == expected.size() );
+
+        for(size_t i = 0; i < expected.size(); i += 7) REQUIRE( r[i] == expected[i] );
+
+        vector<char> buf(r.size());
+        r.flatten(buf.data());
+        REQUIRE( string(buf.begin(), buf.end()) == expected );
+
+        for(size_t i = 0; i < 200; ++i)
+        {
+            size_t pos = rng() % expected.size(), cnt = rng() % 300;
+            char tmp[300];
+            rcstring part = r.copy_to(tmp, cnt, pos);
+            REQUIRE( part.str() == expected.substr(pos, cnt) );
+        }
+    }
+}
+
+
+TEST_CASE("concat_view", "[parray_concat]")
+{
+    SECTION("basics")
+    {
+        rcstring host = ntba("example"), tld = ntba("com");
+        auto v = concat(host, ntba("."), tld);
+        REQUIRE( v.size() == 11 );
+        REQUIRE( v.pieces() == 3 );
+        REQUIRE( v.piece(1) == ntba(".") );
+        REQUIRE( v.str() == "example.com" );
+
+        char buf[16];
+        REQUIRE( (v.copy_to(buf) == buf + 11) );
+        REQUIRE( rcstring(11, buf) == ntba("example.com") );
+
+        ostringstream os;
+        os << v;
+        REQUIRE( os.str() == "example.com" );
+
+        size_t n = 0;
+        v.for_each([&](rcstring p) { n += p.len; });
+        REQUIRE( n == 11 );
+
+        auto e = concat(ntba(""), ntba(""));
+        REQUIRE( e.empty() );
+        REQUIRE( e == ntba("") );
+        REQUIRE( e.hash() == parray_traits::hash(0, (char const*)nullptr) );
+    }
+
+    SECTION("comparisons")
+    {
+        auto v = concat(ntba("ab"), ntba(""), ntba("cde"));
+        char const* s = "abcde";
+
+        REQUIRE( v == ntba("abcde") );
+        REQUIRE( ntba("abcde") == v );
+        REQUIRE( v == string("abcde") );
+        REQUIRE( string("abcde") == v );
+        REQUIRE( v == ntbs(s) );
+        REQUIRE( ntbs(s) == v );
+        REQUIRE( v != ntba("abcdf") );
+        REQUIRE( v != ntba("abcd") );
+        REQUIRE( v != string("abcdef") );
+
+        // length first
+        REQUIRE( v < ntba("aaaaaa") );
+        REQUIRE( v > ntba("zzzz") );
+        REQUIRE( v < ntba("abcdf") );
+        REQUIRE( v > ntba("abcdd") );
+        REQUIRE( v <= ntba("abcde") );
+        REQUIRE( v >= ntba("abcde") );
+        REQUIRE( ntba("abcdd") < v );
+        REQUIRE( ntba("zzzz") < v );
+        REQUIRE( ntbs(s) <= v );
+        REQUIRE( !(v < ntbs(s)) );
+
+        // against another concatenation with different split
+        REQUIRE( v == concat(ntba("a"), ntba("bcd"), ntba("e")) );
+        REQUIRE( v != concat(ntba("a"), ntba("bcx"), ntba("e")) );
+        REQUIRE( v < concat(ntba("a"), ntba("bcx"), ntba("e")) );
+        REQUIRE( concat(ntba("abcd"), ntba("")) < v );
+        REQUIRE( v >= concat(ntba("abcde")) );
+    }
+
+    SECTION("icase")
+    {
+        auto v = concat(ntba<parray_icase_traits>("Content-"), ntba<parray_icase_traits>("Length"));
+        REQUIRE( v == ntba<parray_icase_traits>("content-length") );
+        REQUIRE( v < ntba<parray_icase_traits>("CONTENT-LENGTX") );
+        REQUIRE( v.hash() == parray_icase_traits::hash(14, "CONTENT-LENGTH") );
+    }
+
+    SECTION("hash matches flattened array")
+    {
+        auto v = concat(ntba("user"), ntba(":"), ntba("42"));
+        REQUIRE( v.hash() == std::hash<rcstring>()(ntba("user:42")) );
+        REQUIRE( std::hash<decltype(v)>()(v) == std::hash<rcstring>()(ntba("user:42")) );
+
+        std::unordered_map<rcstring, int> m{ {ntba("user:42"), 1} };
+        REQUIRE( m.hash_function()(m.begin()->first) == v.hash() );
+        REQUIRE( m.begin()->first == v );
+    }
+
+    SECTION("random splits")
+    {
+        mt19937 rng(7);
+        for(size_t i = 0; i < 2000; ++i)
+        {
+            string a(rng() % 6, 0), b(rng() % 6, 0), c(rng() % 6, 0), t(rng() % 16, 0);
+            for(auto* x : { &a, &b, &c, &t }) for(auto& ch : *x) ch = char('a' + rng() % 3);
+            if (rng() % 2) t = (a + b + c).substr(0, t.size());
+
+            auto v = concat(rcstring(a), rcstring(b), rcstring(c));
+            rcstring rt(t);
+            string fs = a + b + c;
+            rcstring f(fs);
+
+            REQUIRE( (v == rt) == (f == rt) );
+            REQUIRE( (v <  rt) == (f <  rt) );
+            REQUIRE( (v >  rt) == (f >  rt) );
+            REQUIRE( (v <= rt) == (f <= rt) );
+            REQUIRE( (v >= rt) == (f >= rt) );
+            REQUIRE( (v == concat(rt.left(t.size() / 2), rt.right(t.size() - t.size() / 2))) == (f == rt) );
+            REQUIRE( v.hash() == parray_traits::hash(f.len, f.p) );
+        }
+    }
+}
+
+
+TEST_CASE("parray_utf", "[parray_utf]")
+{
+    SECTION("validation")
+    {
+        REQUIRE( utf8_valid(ntba("")) );
+        REQUIRE( utf8_valid(ntba("plain ASCII text that is longer than one chunk of bytes")) );
+        REQUIRE( utf8_valid(ntba("\xC2\xA9 caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80 \xF4\x8F\xBF\xBF")) );   // U+00A9 U+00E9 U+20AC U+1F600 U+10FFFF
+
+        char const* bad[] = {
+            "\x80",                    // stray continuation byte
+            "\xC0\xAF",               // overlong '/'
+            "\xC1\xBF",
+            "\xE0\x80\xAF",          // overlong 3-byte
+            "\xED\xA0\x80",          // surrogate U+D800
+            "\xF0\x80\x80\xAF",     // overlong 4-byte
+            "\xF4\x90\x80\x80",     // U+110000
+            "\xF5\x80\x80\x80",
+            "\xFF",
+            "\xC3",                    // truncated
+            "\xE2\x82",
+            "\xE2\x28\xA1",          // bad continuation
+        };
+        for(char const* b : bad)
+        {
+            string s = string("0123456789abcdefghijklmnopqrstuvwxyz") + b + "tail";
+            rcstring v(s);
+            REQUIRE( !utf8_valid(v) );
+            REQUIRE( utf8_find_invalid(v) == v.p + 36 );
+        }
+
+        unsigned char const u[] = { 'a', 0xC3, 0xA9 };
+        REQUIRE( utf8_valid(parray<unsigned char const>(3, u)) );
+    }
+
+    SECTION("utf8 <--> utf16/utf32")
+    {
+        rcstring s = ntba("a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80z");
+        REQUIRE( utf16_length(s) == 6 );
+        REQUIRE( utf32_length(s) == 5 );
+
+        char16_t b16[16];
+        auto r16 = utf8_to_utf16(s, b16, 16);
+        REQUIRE( r16 );
+        REQUIRE( r16.consumed == s.len );
+        REQUIRE( r16.value == ntba(u"a\u00E9\u20AC\U0001F600z") );
+        REQUIRE( utf8_length(r16.value) == s.len );
+
+        char32_t b32[16];
+        auto r32 = utf8_to_utf32(s, b32, 16);
+        REQUIRE( r32 );
+        REQUIRE( r32.value == ntba(U"a\u00E9\u20AC\U0001F600z") );
+        REQUIRE( utf8_length(r32.value) == s.len );
+
+        char b8[16];
+        auto r8 = utf16_to_utf8(r16.value, b8, 16);
+        REQUIRE( r8 );
+        REQUIRE( r8.value == s );
+        r8 = utf32_to_utf8(r32.value, b8, 16);
+        REQUIRE( r8 );
+        REQUIRE( r8.value == s );
+
+        // errors
+        auto e = utf8_to_utf16(s, b16, 4);                          // surrogate pair doesn't fit
+        REQUIRE( e.error == utf_error::no_room );
+        REQUIRE( e.consumed == 6 );
+        REQUIRE( e.value.len == 3 );
+
+        e = utf8_to_utf16(s.left(8), b16, 16);                      // cut in the middle of U+1F600
+        REQUIRE( e.error == utf_error::incomplete );
+        REQUIRE( e.consumed == 6 );
+
+        e = utf8_to_utf16(ntba("ab\xC0\x80"), b16, 16);
+        REQUIRE( e.error == utf_error::invalid );
+        REQUIRE( e.consumed == 2 );
+
+        char16_t const lone[] = { u'x', 0xDC00, u'y' };
+        auto e8 = utf16_to_utf8(parray<char16_t const>(3, lone), b8, 16);
+        REQUIRE( e8.error == utf_error::invalid );
+        REQUIRE( e8.consumed == 1 );
+        REQUIRE( utf16_to_utf8(parray<char16_t const>(1, r16.value.p + 3), b8, 16).error == utf_error::incomplete );
+
+        char32_t const big[] = { 0x110000 };
+        REQUIRE( utf32_to_utf8(parray<char32_t const>(1, big), b8, 16).error == utf_error::invalid );
+
+        REQUIRE( utf16_to_utf8(r16.value, b8, 3).error == utf_error::no_room );
+    }
+
+    SECTION("arena allocation")
+    {
+        string text;
+        for(int i = 0; i < 50; ++i) text += "pr\xC3\xBC" "fen \xE6\x97\xA5\xE6\x9C\xAC ";
+
+        vector<char16_t> arena(1000);
+        size_t used = 0;
+        auto r = utf8_to_utf16(rcstring(text), [&](size_t n) { char16_t* p = &arena[used]; used += n; return p; });
+        REQUIRE( r );
+        REQUIRE( used == r.value.len );
+        REQUIRE( r.value.len == 50 * 10 );
+
+        vector<char> out(1000);
+        size_t used8 = 0;
+        auto back = utf16_to_utf8(r.value, [&](size_t n) { char* p = &out[used8]; used8 += n; return p; });
+        REQUIRE( back );
+        REQUIRE( back.value == rcstring(text) );
+        REQUIRE( used8 == text.size() );
+    }
+
+    SECTION("random round trip")
+    {
+        mt19937 rng(3);
+        for(int iter = 0; iter < 300; ++iter)
+        {
+            vector<char32_t> cps(rng() % 100);
+            for(auto& c : cps)
+            {
+                switch(rng() % 4)
+                {
+                case 0:  c = rng() % 0x80; break;
+                case 1:  c = 0x80 + rng() % 0x780; break;
+                case 2:  c = 0x800 + rng() % 0xF800; if (c >= 0xD800 && c < 0xE000) c -= 0x800; break;
+                default: c = 0x10000 + rng() % 0x100000; break;
+                }
+            }
+            parray<char32_t const> v32(cps.size(), cps.data());
+            vector<char> s8(utf8_length(v32));
+            auto r8 = utf32_to_utf8(v32, s8.data(), s8.size());
+            REQUIRE( r8 );
+            REQUIRE( r8.value.len == s8.size() );
+            REQUIRE( utf8_valid(r8.value) );
+
+            vector<char16_t> s16(utf16_length(r8.value));
+            auto r16 = utf8_to_utf16(r8.value, s16.data(), s16.size());
+            REQUIRE( r16 );
+            REQUIRE( r16.value.len == s16.size() );
+
+            vector<char> s8b(utf8_length(r16.value));
+            auto r8b = utf16_to_utf8(r16.value, s8b.data(), s8b.size());
+            REQUIRE( r8b.value == r8.value );
+
+            vector<char32_t> back(utf32_length(r8.value));
+            auto r32 = utf8_to_utf32(r8.value, back.data(), back.size());
+            REQUIRE( r32.value == v32 );
+
+            if (r8.value.len > 1)                                   // damage one byte
+            {
+                string bad(r8.value.p, r8.value.len);
+                size_t pos = rng() % bad.size();
+                bad[pos] = char(0x80 | rng() % 0x80);
+                rcstring b(bad);
+                char const* p = utf8_find_invalid(b);
+                auto r = utf8_to_utf32(b, back.data(), back.size());
+                REQUIRE( (p == nullptr) == bool(r) );
+                if (p) REQUIRE( size_t(p - b.p) == r.consumed );
+            }
+        }
+    }
+
+    SECTION("trim and split")
+    {
+        rcstring s = ntba("\xE3\x80\x80 \xC2\xA0text\xE2\x80\x83\n");        // U+3000, NBSP ... EM SPACE
+        REQUIRE( utf8_trim(s) == ntba("text") );
+        REQUIRE( utf8_trim_left(s) == ntba("text\xE2\x80\x83\n") );
+        REQUIRE( utf8_trim_right(s) == ntba("\xE3\x80\x80 \xC2\xA0text") );
+        REQUIRE( utf8_trim(ntba(" \xC2\xA0 ")).empty() );
+
+        // U+0120 ends with 0xA0 byte, must not be mistaken for NBSP
+        REQUIRE( utf8_trim(ntba("\xC4\xA0")) == ntba("\xC4\xA0") );
+        REQUIRE( utf8_trim(ntba("x\xC4\xA0 ")) == ntba("x\xC4\xA0") );
+
+        rcstring t = ntba("a\xE3\x80\x81" "b\xE3\x80\x82\xE3\x80\x82" "c");         // a U+3001 b U+3002 U+3002 c
+        utf8_delim d{ ntba("\xE3\x80\x81\xE3\x80\x82") };
+        REQUIRE( split(t, d) == (deque<rcstring>{ ntba("a"), ntba("b"), ntba(""), ntba("c") }) );
+        REQUIRE( split_se(t, d) == (deque<rcstring>{ ntba("a"), ntba("b"), ntba("c") }) );
+        REQUIRE( rsplit(t, d) == (deque<rcstring>{ ntba("c"), ntba(""), ntba("b"), ntba("a") }) );
+        REQUIRE( rsplit_se(t, d) == (deque<rcstring>{ ntba("c"), ntba("b"), ntba("a") }) );
+
+        // delimiter U+3002 shares lead/continuation bytes with U+3001 -- no partial matches
+        rcstring u = ntba("\xE3\x80\x81\xE3\x80\x82");
+        REQUIRE( split(u, utf8_delim{ ntba("\xE3\x80\x82") }) == (deque<rcstring>{ ntba("\xE3\x80\x81"), ntba("") }) );
+        REQUIRE( rsplit(u, utf8_delim{ ntba("\xE3\x80\x82") }) == (deque<rcstring>{ ntba(""), ntba("\xE3\x80\x81") }) );
+
+        rcstring w = ntba("one\xE2\x80\x83two\xC2\xA0 three");
+        REQUIRE( split_se(w, utf8_space_delim{}) == (deque<rcstring>{ ntba("one"), ntba("two"), ntba("three") }) );
+        REQUIRE( rsplit_se(w, utf8_space_delim{}) == (deque<rcstring>{ ntba("three"), ntba("two"), ntba("one") }) );
+    }
+}
+
+
+TEST_CASE("wide element split and trim", "[parray_tools]")
+{
+    using rc16 = parray<char16_t const>;
+    using rc32 = parray<char32_t const>;
+
+    SECTION("trim")
+    {
+        REQUIRE( trim(ntba(u" \t\u3000text\u00A0\u2003 ")) == ntba(u"text") );
+        REQUIRE( trim_left(ntba(u"\u2028 a b ")) == ntba(u"a b ") );
+        REQUIRE( trim_right(ntba(U" a b\u205F\n")) == ntba(U" a b") );
+        REQUIRE( trim(ntba(U"\u3000\u1680")).empty() );
+        REQUIRE( trim(ntba(u"\u200B x")) == ntba(u"\u200B x") );       // zero width space is not White_Space
+        REQUIRE( is_unicode_space(0x85) );
+        REQUIRE( !is_unicode_space(0x200B) );
+    }
+
+    SECTION("single and multi value delimiters")
+    {
+        mt19937 rng(11);
+        char16_t const alphabet[] = { u'a', u',', u';', 0x3001, 0xFF0C, 0xD83D, u' ' };
+        char16_t const many[] = { u',', u';', 0x3001, 0xFF0C, u'.', u':', u'!', u'?', u'-' };     // more than 8
+        for(int iter = 0; iter < 500; ++iter)
+        {
+            u16string s(rng() % 70, u'a');
+            for(auto& c : s) if (rng() % 3 == 0) c = alphabet[rng() % 7];
+            rc16 v(s.size(), s.data());
+
+            // reference -- split by hand
+            auto ref = [&](auto is_delim, bool skip_empty) {
+                deque<rc16> r;
+                size_t start = 0;
+                for(size_t i = 0; i <= s.size(); ++i)
+                    if (i == s.size() || is_delim(s[i]))
+                    {
+                        if (!skip_empty || i != start) r.push_back(v.mid(start, i - start));
+                        start = i + 1;
+                    }
+                return r;
+            };
+            auto one = [](char16_t c) { return c == 0x3001; };
+            auto any = [](char16_t c) { return c == u',' || c == 0x3001 || c == 0xFF0C; };
+            auto lots = [&](char16_t c) { return find(begin(many), end(many), c) != end(many); };
+
+            REQUIRE( split(v, char16_t(0x3001)) == ref(one, false) );
+            REQUIRE( split_se(v, char16_t(0x3001)) == ref(one, true) );
+            REQUIRE( split(v, ntba(u",\u3001\uFF0C")) == ref(any, false) );
+            REQUIRE( split_se(v, ntba(u",\u3001\uFF0C")) == ref(any, true) );
+            REQUIRE( split(v, rc16(9, many)) == ref(lots, false) );
+            REQUIRE( split_se(v, rc16(9, many)) == ref(lots, true) );
+
+            auto r = ref(any, true);
+            reverse(r.begin(), r.end());
+            REQUIRE( rsplit_se(v, ntba(u",\u3001\uFF0C")) == r );
+        }
+
+        u32string w = U"x\U0001F600y,z\U0001F600";
+        REQUIRE( split(rc32(w.size(), w.data()), char32_t(0x1F600)) == (deque<rc32>{ ntba(U"x"), ntba(U"y,z"), ntba(U"") }) );
+        REQUIRE( split_se(ntba(U"  a  b "), ntba(U" ")) == (deque<rc32>{ ntba(U"a"), ntba(U"b") }) );
+    }
+
+    SECTION("sparse_bitset_delim")
+    {
+        sparse_bitset_delim<> d(ntba(u",\u3001\uFF0C"));
+        REQUIRE( d.is_set(u',') );
+        REQUIRE( d.is_set(char16_t(0x3001)) );
+        REQUIRE( d.is_set(char16_t(0xFF0C)) );
+        REQUIRE( !d.is_set(char16_t(0xFF0D)) );
+        REQUIRE( !d.is_set(char16_t(0x3101)) );                     // same low byte, different page
+        REQUIRE( d.footprint() < 1024 );
+
+        REQUIRE( split(ntba(u"a,b\u3001c\uFF0Cd"), d) == (deque<rc16>{ ntba(u"a"), ntba(u"b"), ntba(u"c"), ntba(u"d") }) );
+        REQUIRE( rsplit_se(ntba(u",a\u3001\u3001b"), d) == (deque<rc16>{ ntba(u"b"), ntba(u"a") }) );
+
+        d.clear_bit(u',');
+        REQUIRE( !d.is_set(u',') );
+        d.set_bit(char16_t(0xFFFF));
+        REQUIRE( d.is_set(char16_t(0xFFFF)) );
+
+        sparse_bitset_delim<char32_t> d32(ntba(U"\U0001F600 "));
+        REQUIRE( d32.is_set(char32_t(0x1F600)) );
+        REQUIRE( !d32.is_set(char32_t(0x1F601)) );
+        REQUIRE( !d32.is_set(char32_t(0xF600)) );
+        REQUIRE( split(ntba(U"a b\U0001F600c"), d32) == (deque<rc32>{ ntba(U"a"), ntba(U"b"), ntba(U"c") }) );
+        d32.clear_bit(char32_t(0x1F600));
+        REQUIRE( !d32.is_set(char32_t(0x1F600)) );
+
+        mt19937 rng(5);
+        sparse_bitset_delim<> r;
+        vector<bool> ref(0x10000);
+        for(int i = 0; i < 300; ++i) { char16_t c = char16_t(rng()); r.set_bit(c); ref[c] = true; }
+        for(unsigned c = 0; c < 0x10000; ++c) REQUIRE( r.is_set(char16_t(c)) == ref[c] );
+
+        sparse_bitset_delim<> all;                                  // every page is non-empty
+        for(unsigned hi = 0; hi < 256; ++hi) all.set_bit(char16_t(hi << 8));
+        REQUIRE( !all.is_set(char16_t(0xFF41)) );
+        all.set_bit(char16_t(0xFF41));
+        REQUIRE( all.is_set(char16_t(0xFF41)) );
+        REQUIRE( !all.is_set(char16_t(0x0041)) );
+        all.clear_bit(char16_t(0xFF41));
+        REQUIRE( !all.is_set(char16_t(0xFF41)) );
+        for(unsigned hi = 0; hi < 256; ++hi) REQUIRE( all.is_set(char16_t(hi << 8)) );
+    }
+}
+
+
+//------------------------------------------------------------------------------
+TEST_CASE("parray_counting_traits", "[parray_stats]")
+{
+    using tr = parray_counting_traits<>;
+    using cstr = parray<char const, tr>;
+
+    SECTION("classification")
+    {
+        tr::reset();
+        char const a[] = "abcdefgh", b[] = "abcdefgx";
+        cstr x(8, a), y(8, b), z(3, a);
+
+        REQUIRE( x != z );                                          // by length
+        REQUIRE( cstr() == cstr() );                                // by length (empty)
+        REQUIRE( x == x );                                          // by pointer
+        REQUIRE( !(x < x) );                                        // by pointer
+        REQUIRE( x != y );                                          // scan, 8 bytes
+        REQUIRE( x < y );                                           // scan, 8 bytes
+        REQUIRE( cstr(2, a) == cstr(2, b) );                        // scan, 2 bytes
+        REQUIRE( !(cstr(3, a) > cstr(3, a + 1)) );                  // scan, 1 byte
+
+        parray_cmp_stats s = tr::stats();
+        REQUIRE( s.eq_calls == 5 );
+        REQUIRE( s.lt_calls == 3 );
+        REQUIRE( s.by_length == 2 );
+        REQUIRE( s.by_same_ptr == 2 );
+        REQUIRE( s.scanned == 4 );
+        REQUIRE( s.bytes_scanned == 19 );
+        REQUIRE( s.scanned_hist[0] == 1 );
+        REQUIRE( s.scanned_hist[1] == 1 );
+        REQUIRE( s.scanned_hist[3] == 2 );
+        REQUIRE( s.ntbs_calls == 0 );
+        REQUIRE( s.memory_free_ratio() == 0.5 );
+
+        REQUIRE( x == ntbs<tr>("abcdefgh"+0) );
+        REQUIRE( ntbs<tr>("abc"+0) < x );
+        REQUIRE( tr::stats().ntbs_calls == 2 );
+        REQUIRE( tr::stats().calls() == 8 );
+
+        tr::reset();
+        REQUIRE( tr::stats().calls() == 0 );
+        REQUIRE( tr::stats().memory_free_ratio() == 1.0 );
+    }
+
+    SECTION("bucket")
+    {
+        REQUIRE( parray_cmp_stats::bucket(1) == 0 );
+        REQUIRE( parray_cmp_stats::bucket(2) == 1 );
+        REQUIRE( parray_cmp_stats::bucket(3) == 1 );
+        REQUIRE( parray_cmp_stats::bucket(4096) == 12 );
+        REQUIRE( parray_cmp_stats::bucket(~uint64_t(0)) == parray_cmp_stats::hist_size - 1 );
+    }
+
+    SECTION("same results as base trait")
+    {
+        mt19937 rng(3);
+        vector<string> v;
+        for(int i = 0; i < 200; ++i) v.push_back(string(rng() % 4, 'a') + char('a' + rng() % 3));
+        for(auto& l : v)
+            for(auto& r : v)
+            {
+                rcstring pl(l), pr(r);
+                cstr cl(pl.len, pl.p), cr(pr.len, pr.p);
+                REQUIRE( (cl == cr) == (pl == pr) );
+                REQUIRE( (cl < cr) == (pl < pr) );
+                REQUIRE( (cl >= cr) == (pl >= pr) );
+                REQUIRE( (cl == ntbs<tr>(r.c_str())) == (pl == ntbs(r.c_str())) );
+                REQUIRE( (cl < ntbs<tr>(r.c_str())) == (pl < ntbs(r.c_str())) );
+            }
+
+        using wtr = parray_counting_traits<parray_icase_traits>;
+        REQUIRE( (parray<char const, wtr>(ntba("ABC")) == parray<char const, wtr>(ntba("abc"))) );
+        REQUIRE( wtr::stats().scanned == 1 );
+    }
+
+    SECTION("threads")
+    {
+        tr::reset();
+        char const a[] = "abcd", b[] = "abce";
+        vector<thread> threads;
+        for(int t = 0; t < 4; ++t)
+            threads.emplace_back([&]() {
+                for(int i = 0; i < 1000; ++i) { bool volatile r = (cstr(4, a) == cstr(4, b)); (void)r; }
+            });
+        for(auto& t : threads) t.join();
+
+        REQUIRE( cstr(1, a) != cstr(2, a) );                        // this thread is still alive
+
+        parray_cmp_stats s = tr::stats();
+        REQUIRE( s.eq_calls == 4001 );
+        REQUIRE( s.scanned == 4000 );
+        REQUIRE( s.bytes_scanned == 16000 );
+        REQUIRE( s.scanned_hist[2] == 4000 );
+        REQUIRE( s.by_length == 1 );
+    }
+}
+
+
+//------------------------------------------------------------------------------
+struct generic_ref_traits : parray_traits
+{
+    using parray_traits::generic_eq;
+    using parray_traits::generic_lt;
+};
+
+TEST_CASE("runtime dispatch", "[parray_dispatch]")
+{
+    using ref = generic_ref_traits;
+    isa_level const levels[] = { isa_level::scalar, isa_level::sse2, isa_level::avx2, isa_level::avx512 };
+
+    SECTION("levels")
+    {
+        REQUIRE( kernels(isa_level::scalar).level == isa_level::scalar );
+        for(isa_level l : levels)
+        {
+            if (l > detected_isa()) continue;
+            REQUIRE( kernels(l).level == l );
+            REQUIRE( set_isa(l) == l );
+            REQUIRE( active_isa() == l );
+        }
+        REQUIRE( set_isa(isa_level::avx512) == detected_isa() );
+        REQUIRE( string(isa_name(isa_level::avx2)) == "avx2" );
+
+#if !defined(_WIN32)
+        setenv("PARRAY_ISA", "scalar", 1);
+        REQUIRE( requested_isa() == isa_level::scalar );
+        setenv("PARRAY_ISA", "avx512", 1);
+        REQUIRE( requested_isa() == detected_isa() );
+        setenv("PARRAY_ISA", "bogus", 1);
+        REQUIRE( requested_isa() == detected_isa() );
+        unsetenv("PARRAY_ISA");
+        REQUIRE( requested_isa() == detected_isa() );
+#endif
+    }
+
+    SECTION("kernels match generic_eq/generic_lt")
+    {
+        mt19937 rng(17);
+        vector<unsigned char> a(300), b(300);
+        for(isa_level l : levels)
+        {
+            if (l > detected_isa()) continue;
+            byte_kernels const& k = kernels(l);
+
+            for(int iter = 0; iter < 3000; ++iter)
+            {
+                size_t len = rng() % 200, off = rng() % 64;
+                for(size_t i = 0; i < len; ++i) a[off + i] = b[off + i] = (unsigned char)(rng() % 4 ? 'a' + rng() % 3 : rng());
+                if (len && rng() % 4) b[off + rng() % len] ^= (unsigned char)(1 + rng() % 255);
+
+                unsigned char const* pa = a.data() + off;
+                unsigned char const* pb = b.data() + off;
+                size_t m = k.mismatch(len, pa, pb);
+                REQUIRE( (m == len) == ref::generic_eq(len, pa, pb) );
+                REQUIRE( ref::generic_eq(m, pa, pb) );
+                REQUIRE( (m < len && pa[m] < pb[m]) == ref::generic_lt(len, pa, pb) );
+
+                char const* ca = reinterpret_cast<char const*>(pa);
+                char const* cb = reinterpret_cast<char const*>(pb);
+                REQUIRE( (m < len && pa[m] < pb[m]) == ref::generic_lt(len, ca, cb) );      // char_traits<char> order
+
+                unsigned char set[byte_kernels::max_set];
+                size_t n = rng() % (byte_kernels::max_set + 1);
+                for(size_t i = 0; i < n; ++i) set[i] = (unsigned char)(rng() % 3 ? 'a' + rng() % 3 : rng());
+                REQUIRE( k.find_any(len, pa, set, n) == size_t(find_first_of(pa, pa + len, set, set + n) - pa) );
+                REQUIRE( k.skip_any(len, pa, set, n) == size_t(find_if(pa, pa + len, [&](unsigned char c) { return find(set, set + n, c) == set + n; }) - pa) );
+            }
+        }
+    }
+
+    SECTION("parray_dispatch_traits")
+    {
+        using dstr = parray<char const, parray_dispatch_traits>;
+        mt19937 rng(23);
+        vector<string> v;
+        for(int i = 0; i < 120; ++i) v.push_back(string(rng() % 3 * 20, 'x') + string(1, char(rng() % 3 ? 'a' + rng() % 3 : rng())) + string(rng() % 40, 'y'));
+
+        for(isa_level l : levels)
+        {
+            if (l > detected_isa()) continue;
+            set_isa(l);
+            for(auto& x : v)
+                for(auto& y : v)
+                {
+                    rcstring px(x), py(y);
+                    dstr dx(px.len, px.p), dy(py.len, py.p);
+                    REQUIRE( (dx == dy) == (px == py) );
+                    REQUIRE( (dx != dy) == (px != py) );
+                    REQUIRE( (dx < dy) == (px < py) );
+                    REQUIRE( (dx >= dy) == (px >= py) );
+                }
+        }
+
+        int a[] = {1, 2}, b[] = {1, 3};                             // not dispatched
+        REQUIRE( (parray<int, parray_dispatch_traits>(a) < parray<int, parray_dispatch_traits>(b)) );
+        set_isa(requested_isa());
+    }
+
+    SECTION("dispatch_delim")
+    {
+        string line;
+        mt19937 rng(29);
+        for(int i = 0; i < 2000; ++i) line += (rng() % 6) ? char('a' + rng() % 26) : ",; \t"[rng() % 4];
+        rcstring v(line);
+
+        for(isa_level l : levels)
+        {
+            if (l > detected_isa()) continue;
+            set_isa(l);
+
+            dispatch_delim<char> d(ntba(",; "));
+            REQUIRE( split(v, d) == split(v, ntba(",; ")) );
+            REQUIRE( split_se(v, d) == split_se(v, ntba(",; ")) );
+            REQUIRE( rsplit(v, d) == rsplit(v, ntba(",; ")) );
+            rcstring t = ntba("; ,abc, ");
+            REQUIRE( d.skip_all(t.p, t.p + t.len) == t.p + 3 );
+            REQUIRE( d.find_first(t.p + 3, t.p + t.len) == t.p + 6 );
+
+            dispatch_delim<char> wide(ntba("abcdefghijk"));                    // more than max_set values
+            REQUIRE( split(v, wide) == split(v, ntba("abcdefghijk")) );
+        }
+        set_isa(requested_isa());
+    }
+}
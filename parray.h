@@ -12,11 +12,24 @@
 
 
 #include <cstddef>
+#include <cstdint>
 #include <type_traits>
 #include <cstring>
 #include <string>
 #include <vector>
 #include <ostream>
+#include <functional>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   include <emmintrin.h>
+#   define PARRAY_HAS_SSE2_
+#endif
+#if defined(__AVX2__)
+#   include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#   include <intrin.h>
+#endif
 
 
 //------------------------------------------------------------------------------
@@ -81,6 +94,13 @@
 //      remove_cv<R> const r_nul{};
 //      l == r && l == l_nul -> r == r_nul;     // i.e. if l == r and l is NUL then r is NUL too
 //  - should probably sprinkle constexpr everywhere...
+//  - ntbs length of non-char (or char16_t/char32_t) integral arrays is calculated by reading aligned machine words (see
+//    ntbs_len_wide()); this may read past terminating NUL, but never crosses page boundary. For volatile arrays it is
+//    not done by default (every element is read exactly once), use parray_wide_traits if word-sized reads are ok
+//    (e.g. NUL-terminated records in shared memory segment)
+//  - ntbs vs parray comparisons of non-volatile char/unsigned char arrays are done 16 (32 with AVX2) elements at a time,
+//    looking for mismatch and NUL simultaneously (see ntbs_ar_cmp_chunked()); like ntbs_len_wide() it reads past the end
+//    of both arrays, but never crosses page boundary
 //
 
 
@@ -112,6 +132,107 @@ template<class T> constexpr bool is_byte = is_same<remove_cv<T>, unsigned char>;
 // relaxed version of 'is_same<remove_cv<E>, remove_cv<T>> && is_convertible<E*, T*>'
 template<class E, class T> constexpr bool is_almost_same = (sizeof(E) == sizeof(T)) && is_convertible<E*, T*>;
 
+// element types that can be scanned for NUL a word at a time
+template<class T> constexpr bool is_wide_scannable = std::is_integral<T>::value && (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4);
+
+// word-at-a-time reads deliberately touch bytes past the end of array (within the same aligned word)
+#if defined(__GNUC__)
+#   define PARRAY_NO_SANITIZE_ADDRESS_ __attribute__((no_sanitize_address))
+typedef std::uint64_t __attribute__((__may_alias__)) word_alias;     // word that can alias any type
+#else
+#   define PARRAY_NO_SANITIZE_ADDRESS_
+typedef std::uint64_t word_alias;
+#endif
+
+// index of lowest set bit (v != 0)
+inline unsigned ctz_(std::uint32_t v)
+{
+#if defined(__GNUC__)
+    return __builtin_ctz(v);
+#elif defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanForward(&idx, v);
+    return idx;
+#else
+    unsigned idx = 0;
+    for(; !(v & 1); v >>= 1) ++idx;
+    return idx;
+#endif
+}
+
+#if defined(PARRAY_HAS_SSE2_)
+// chunk of bytes compared in one step
+struct byte_chunk
+{
+    enum { page_size = 4096 };
+
+#if defined(__AVX2__)
+    enum { size = 32 };
+
+    // bit k of result: a[k] != b[k] || b[k] == 0; bit k of nul: b[k] == 0
+    PARRAY_NO_SANITIZE_ADDRESS_ static std::uint32_t diff_or_nul(void const* a, void const* b, std::uint32_t& nul)
+    {
+        __m256i va = _mm256_loadu_si256(static_cast<__m256i const*>(a));
+        __m256i vb = _mm256_loadu_si256(static_cast<__m256i const*>(b));
+        nul = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(vb, _mm256_setzero_si256())));
+        return ~static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb))) | nul;
+    }
+
+    // ASCII lowercase: 'A'..'Z' are moved to -128..-103 (signed), everything else lands above
+    static __m256i fold_(__m256i v)
+    {
+        __m256i upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(-102), _mm256_add_epi8(v, _mm256_set1_epi8(0x3F)));
+        return _mm256_or_si256(v, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+    }
+
+    // bit k of result: tolower(a[k]) != tolower(b[k]) (ASCII only)
+    PARRAY_NO_SANITIZE_ADDRESS_ static std::uint32_t folded_diff(void const* a, void const* b)
+    {
+        __m256i va = fold_(_mm256_loadu_si256(static_cast<__m256i const*>(a)));
+        __m256i vb = fold_(_mm256_loadu_si256(static_cast<__m256i const*>(b)));
+        return ~static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb)));
+    }
+
+    // bit k of result: p[k] >= 0x80 (i.e. not ASCII)
+    static std::uint32_t high_bits(void const* p)
+    {
+        return static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_loadu_si256(static_cast<__m256i const*>(p))));
+    }
+#else
+    enum { size = 16 };
+
+    PARRAY_NO_SANITIZE_ADDRESS_ static std::uint32_t diff_or_nul(void const* a, void const* b, std::uint32_t& nul)
+    {
+        __m128i va = _mm_loadu_si128(static_cast<__m128i const*>(a));
+        __m128i vb = _mm_loadu_si128(static_cast<__m128i const*>(b));
+        nul = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(vb, _mm_setzero_si128())));
+        return (~static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb))) & 0xFFFFu) | nul;
+    }
+
+    static __m128i fold_(__m128i v)
+    {
+        __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(-102), _mm_add_epi8(v, _mm_set1_epi8(0x3F)));
+        return _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+    }
+
+    PARRAY_NO_SANITIZE_ADDRESS_ static std::uint32_t folded_diff(void const* a, void const* b)
+    {
+        __m128i va = fold_(_mm_loadu_si128(static_cast<__m128i const*>(a)));
+        __m128i vb = fold_(_mm_loadu_si128(static_cast<__m128i const*>(b)));
+        return ~static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb))) & 0xFFFFu;
+    }
+
+    static std::uint32_t high_bits(void const* p)
+    {
+        return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_loadu_si128(static_cast<__m128i const*>(p))));
+    }
+#endif
+
+    // true if chunk starting at p doesn't cross page boundary
+    static bool page_safe(void const* p) { return (reinterpret_cast<std::uintptr_t>(p) & (page_size - 1)) <= page_size - size; }
+};
+#endif
+
 
 //------------------------------------------------------------------------------
 struct parray_traits
@@ -177,6 +298,37 @@ public:
     template<class L, class R> static bool lt_eq (size_t l_len, L* l, size_t r_len, R* r) { return !lt(r_len, r, l_len, l); }           // l <= r -> r >= l -> !(r < l)
     template<class L, class R> static bool gt_eq (size_t l_len, L* l, size_t r_len, R* r) { return !lt(l_len, l, r_len, r); }           // l >= r -> !(l < r)
 
+    //
+    // hashing
+    //
+
+protected:
+    enum : size_t { fnv_prime = (sizeof(size_t) == 8) ? size_t(1099511628211ull) : size_t(16777619u) };
+
+    // FNV-1a step over value bytes of integral element (lowest byte first -- result doesn't depend on byte order)
+    template<class T, enable_if< std::is_integral<T>::value>...>
+    static size_t hash_elem(size_t h, T v)
+    {
+        std::uint64_t u = static_cast<std::uint64_t>(v);
+        for(size_t i = 0; i < sizeof(T); ++i, u >>= 8) h = (h ^ size_t(u & 0xFF)) * fnv_prime;
+        return h;
+    }
+
+    // everything else is hashed with std::hash and mixed in
+    template<class T, enable_if<!std::is_integral<T>::value>...>
+    static size_t hash_elem(size_t h, T const& v) { return (h ^ std::hash<remove_cv<T>>{}(v)) * fnv_prime; }
+
+public:
+    enum : size_t { hash_seed = (sizeof(size_t) == 8) ? size_t(14695981039346656037ull) : size_t(2166136261u) };
+
+    // hash consistent with eq() (FNV-1a over elements), chainable -- pass previous result as seed
+    template<class T>
+    static size_t hash(size_t len, T* p, size_t seed = hash_seed)
+    {
+        for(; len > 0; --len, ++p) seed = hash_elem(seed, *p);
+        return seed;
+    }
+
     //
     // ntbs
     //
@@ -306,19 +458,120 @@ protected:
     template<class L, class R, enable_if<!is_scalar<L> || !is_scalar<R>>...> static bool ntbs_ar_eq_(L* l, R* r) { return ntbs_ar_eq(l, r); }
     template<class L, class R, enable_if<!is_scalar<L> || !is_scalar<R>>...> static bool ntbs_ar_lt_(L* l, R* r) { return ntbs_ar_lt(l, r); }
 
-public:
-    // length
-    template<class T, enable_if<is_char<T> && !is_volatile<T>>...>                      // char_traits doesn't handle volatile
-    static size_t ntbs_len(T* p) { return char_traits<remove_cv<T>>::length(p); }
+    // ntbs vs parray -- chunked comparison of non-volatile byte-sized chars (lexicographical order of char and unsigned
+    // char is the order of unsigned bytes)
+#if defined(PARRAY_HAS_SSE2_)
+    template<class L, class R> constexpr static bool is_chunked_ntbs = !is_volatile<L> && !is_volatile<R> && is_same<remove_cv<L>, remove_cv<R>> &&
+                                                                        (is_same<remove_cv<L>, char> || is_same<remove_cv<L>, unsigned char>);
+#else
+    template<class L, class R> constexpr static bool is_chunked_ntbs = false;
+#endif
+
+#if defined(PARRAY_HAS_SSE2_)
+    // length-first (or lexicographical if lex is set) 3-way comparison of array (a_len, a) and ntbs b: <0 if a < b, 0 if
+    // a == b, >0 if a > b; if eq_only is set -- returns non-zero result as soon as difference is found (its sign is meaningless)
+    template<bool eq_only, bool lex = false>
+    PARRAY_NO_SANITIZE_ADDRESS_ static int ntbs_ar_cmp_chunked(size_t a_len, unsigned char const* a, unsigned char const* b)
+    {
+        size_t i = 0;
+        for(;;)
+        {
+            size_t rem = a_len - i;
+            if (rem == 0) return (b[i] == 0) ? 0 : -1;                     // 'a' ended (a + i may point to unmapped page)
+
+            if (byte_chunk::page_safe(a + i) && byte_chunk::page_safe(b + i))
+            {
+                std::uint32_t nul;
+                std::uint32_t diff = byte_chunk::diff_or_nul(a + i, b + i, nul);
+                if (rem < byte_chunk::size)
+                {
+                    diff &= (std::uint32_t(1) << rem) - 1;                  // ignore everything past the end of 'a'
+                    if (!diff) return ((nul >> rem) & 1) ? 0 : -1;          // 'a' ended -- equal if 'b' ended too
+                }
+                if (diff) { i += ctz_(diff); break; }
+                i += byte_chunk::size;
+            }
+            else    // near page boundary -- one element at a time
+            {
+                if (b[i] == 0 || a[i] != b[i]) break;
+                ++i;
+            }
+        }
+
+        // i < a_len and (a[i] != b[i] or b[i] == 0)
+        if (lex) return (a[i] < b[i]) ? -1 : 1;     // NUL is less than anything
+        if (b[i] == 0 || eq_only) return 1;         // 'b' is shorter
+
+        // figure out if length of 'b' is less, equal or greater than a_len
+        void const* nul = memchr(b + i + 1, 0, a_len - i);
+        if (!nul) return -1;                        // 'b' is longer
+        if (static_cast<unsigned char const*>(nul) - b < static_cast<std::ptrdiff_t>(a_len)) return 1;
+        return (a[i] < b[i]) ? -1 : 1;              // same length, first mismatch decides
+    }
+
+    template<class T>
+    static unsigned char const* as_bytes_(T* p) { return reinterpret_cast<unsigned char const*>(p); }
+#endif
+
+#if defined(PARRAY_HAS_SSE2_)
+    template<class L, class R, enable_if< is_chunked_ntbs<L, R>>...> static bool ntbs_ar_eq_(size_t l_len, L* l, R* r) { return ntbs_ar_cmp_chunked<true >(l_len, as_bytes_(l), as_bytes_(r)) == 0; }
+    template<class L, class R, enable_if< is_chunked_ntbs<L, R>>...> static bool ntbs_ar_lt_(size_t l_len, L* l, R* r) { return ntbs_ar_cmp_chunked<false>(l_len, as_bytes_(l), as_bytes_(r)) <  0; }
+    template<class L, class R, enable_if< is_chunked_ntbs<L, R>>...> static bool ntbs_ar_lt_(L* l, size_t r_len, R* r) { return ntbs_ar_cmp_chunked<false>(r_len, as_bytes_(r), as_bytes_(l)) >  0; }
+#endif
+
+    template<class L, class R, enable_if<!is_chunked_ntbs<L, R>>...> static bool ntbs_ar_eq_(size_t l_len, L* l, R* r) { return ntbs_ar_eq(l_len, l, r); }
+    template<class L, class R, enable_if<!is_chunked_ntbs<L, R>>...> static bool ntbs_ar_lt_(size_t l_len, L* l, R* r) { return ntbs_ar_lt(l_len, l, r); }
+    template<class L, class R, enable_if<!is_chunked_ntbs<L, R>>...> static bool ntbs_ar_lt_(L* l, size_t r_len, R* r) { return ntbs_ar_lt(l, r_len, r); }
 
-    template<class T, enable_if<!is_char<T> || is_volatile<T>>...>
-    static size_t ntbs_len(T* p)
+    // length -- one element at a time (works for any T)
+    template<class T>
+    static size_t ntbs_len_scalar(T* p)
     {
         size_t count = 0;
         for(remove_cv<T> const nul{}; !elem_eq(*p, nul); ++p) ++count;
         return count;
     }
 
+    // aligned word loads (volatile arrays are read through volatile word)
+    PARRAY_NO_SANITIZE_ADDRESS_ static std::uint64_t load_word_(void const* p)          { return *reinterpret_cast<word_alias const*>(p); }
+    PARRAY_NO_SANITIZE_ADDRESS_ static std::uint64_t load_word_(void const volatile* p) { return *reinterpret_cast<word_alias const volatile*>(p); }
+
+    // length -- aligned word at a time (SWAR), reads up to 7 bytes past terminating NUL (but never crosses page boundary)
+    template<class T, enable_if<is_wide_scannable<remove_cv<T>>>...>
+    PARRAY_NO_SANITIZE_ADDRESS_ static size_t ntbs_len_wide(T* p)
+    {
+        using word = std::uint64_t;
+        constexpr word lo = ~word(0) / ((word(1) << (8*sizeof(T))) - 1);   // lowest bit of every lane
+        constexpr word hi = lo << (8*sizeof(T) - 1);                        // highest bit of every lane
+
+        T* const p0 = p;
+
+        // step to word boundary
+        for(; reinterpret_cast<std::uintptr_t>(p) % sizeof(word); ++p)
+            if (*p == 0) return p - p0;
+
+        // some lane of word is zero only if (w - lo) & ~w & hi != 0
+        for(;; p += sizeof(word)/sizeof(T))
+        {
+            word v = load_word_(p);
+            if ((v - lo) & ~v & hi) break;
+        }
+
+        while(*p != 0) ++p;     // find exact position within that word
+        return p - p0;
+    }
+
+public:
+    // length
+    template<class T, enable_if<(is_same<remove_cv<T>, char> || is_same<remove_cv<T>, wchar_t>) && !is_volatile<T>>...>  // char_traits doesn't handle volatile
+    static size_t ntbs_len(T* p) { return char_traits<remove_cv<T>>::length(p); }
+
+    template<class T, enable_if<!(is_same<remove_cv<T>, char> || is_same<remove_cv<T>, wchar_t>) && !is_volatile<T> && is_wide_scannable<remove_cv<T>>>...>
+    static size_t ntbs_len(T* p) { return ntbs_len_wide(p); }
+
+    template<class T, enable_if<is_volatile<T> || !is_wide_scannable<remove_cv<T>>>...>
+    static size_t ntbs_len(T* p) { return ntbs_len_scalar(p); }
+
     // comparisons
     template<class L, class R> static bool ntbs_eq    (L* l, R* r) { return ntbs_ar_eq_(l, r); } 
     template<class L, class R> static bool ntbs_not_eq(L* l, R* r) { return !ntbs_eq   (l, r); }                        // l != r -> !(l == r)
@@ -327,22 +580,333 @@ public:
     template<class L, class R> static bool ntbs_lt_eq (L* l, R* r) { return !ntbs_lt   (r, l); }                        // l <= r -> r >= l -> !(r < l)
     template<class L, class R> static bool ntbs_gt_eq (L* l, R* r) { return !ntbs_lt   (l, r); }                        // l >= r -> !(l < r)
 
-    template<class L, class R> static bool ntbs_eq    (size_t l_len, L* l, R* r) { return ntbs_ar_eq(l_len, l, r); }
+    template<class L, class R> static bool ntbs_eq    (size_t l_len, L* l, R* r) { return ntbs_ar_eq_(l_len, l, r); }
+    template<class L, class R> static bool ntbs_not_eq(size_t l_len, L* l, R* r) { return !ntbs_eq  (l_len, l, r); }    // l != r -> !(l == r)
+    template<class L, class R> static bool ntbs_lt    (size_t l_len, L* l, R* r) { return ntbs_ar_lt_(l_len, l, r); }
+    template<class L, class R> static bool ntbs_gt    (size_t l_len, L* l, R* r) { return ntbs_lt   (r, l_len, l); }    // l >  r -> r <  l
+    template<class L, class R> static bool ntbs_lt_eq (size_t l_len, L* l, R* r) { return !ntbs_lt  (r, l_len, l); }    // l <= r -> r >= l -> !(r < l)
+    template<class L, class R> static bool ntbs_gt_eq (size_t l_len, L* l, R* r) { return !ntbs_lt  (l_len, l, r); }    // l >= r -> !(l < r)
+
+    template<class L, class R> static bool ntbs_eq    (L* l, size_t r_len, R* r) { return ntbs_eq   (r_len, r, l); }    // l == r -> r == l
+    template<class L, class R> static bool ntbs_not_eq(L* l, size_t r_len, R* r) { return !ntbs_eq  (l, r_len, r); }    // l != r -> !(l == r)
+    template<class L, class R> static bool ntbs_lt    (L* l, size_t r_len, R* r) { return ntbs_ar_lt_(l, r_len, r); }
+    template<class L, class R> static bool ntbs_gt    (L* l, size_t r_len, R* r) { return ntbs_lt   (r_len, r, l); }    // l >  r -> r <  l
+    template<class L, class R> static bool ntbs_lt_eq (L* l, size_t r_len, R* r) { return !ntbs_lt  (r_len, r, l); }    // l <= r -> r >= l -> !(r < l)
+    template<class L, class R> static bool ntbs_gt_eq (L* l, size_t r_len, R* r) { return !ntbs_lt  (l, r_len, r); }    // l >= r -> !(l < r)
+};
+
+
+//------------------------------------------------------------------------------
+// same as parray_traits, but calculates ntbs length of volatile arrays a word at a time too (i.e. elements get read
+// more than once and bytes past terminating NUL get read); it is meant for memory that isn't changed concurrently
+// (or only 'grows' past terminating NUL), e.g. records in shared memory segment:
+//
+//      char volatile* rec = ...;
+//      parray<char volatile const> r{ ntbs<parray_wide_traits>(rec) };
+//
+struct parray_wide_traits : parray_traits
+{
+    template<class T, enable_if< is_wide_scannable<remove_cv<T>>>...> static size_t ntbs_len(T* p) { return ntbs_len_wide(p); }
+    template<class T, enable_if<!is_wide_scannable<remove_cv<T>>>...> static size_t ntbs_len(T* p) { return parray_traits::ntbs_len(p); }
+};
+
+
+//------------------------------------------------------------------------------
+// lexicographical order (like std::lexicographical_compare, strcmp(), memcmp() of equal-length arrays), e.g. for data
+// that is kept sorted outside of the program or prefix range scans (see prefix_range() in parray_tools.h):
+//
+//      using lex_string = parray<char const, parray_lex_traits>;
+//      assert( lex_string(ntba("abc")) < lex_string(ntba("b")) );
+//
+// equality is the same as in parray_traits (length is compared first)
+//
+struct parray_lex_traits : parray_traits
+{
+protected:
+    template<class L, class R>
+    static int generic_cmp(size_t len, L* l, R* r)
+    {
+        for(; len > 0; --len, ++l, ++r) { if (!elem_eq(*l, *r)) return elem_lt(*l, *r) ? -1 : 1; }
+        return 0;
+    }
+
+    // 3-way comparison of equal-length arrays (same algorithm selection as ar_lt())
+    template<class L, class R, enable_if<is_case1<L, R>>...> static int ar_cmp(size_t len, L* l, R* r) { return char_traits<remove_cv<L>>::compare(l, r, len); }
+    template<class L, class R, enable_if<is_case2<L, R>>...> static int ar_cmp(size_t len, L* l, R* r) { return len ? memcmp(l, r, len) : 0; }
+    template<class L, class R, enable_if<is_case3<L, R>>...> static int ar_cmp(size_t len, L* l, R* r) { return generic_cmp(len, l, r); }
+
+    template<class L, class R, enable_if< is_scalar<L> &&  is_scalar<R>>...> static int ar_cmp_(size_t len, L* l, R* r) { return same_ptr(l, r) ? 0 : ar_cmp(len, l, r); }
+    template<class L, class R, enable_if<!is_scalar<L> || !is_scalar<R>>...> static int ar_cmp_(size_t len, L* l, R* r) { return ar_cmp(len, l, r); }
+
+    // ntbs vs ntbs
+    template<class L, class R, enable_if<is_same<remove_cv<L>, char> && is_same<remove_cv<R>, char> && !is_volatile<L> && !is_volatile<R>>...>
+    static bool ntbs_lex_lt(L* l, R* r) { return std::strcmp(l, r) < 0; }
+
+    template<class L, class R, enable_if<!(is_same<remove_cv<L>, char> && is_same<remove_cv<R>, char> && !is_volatile<L> && !is_volatile<R>)>...>
+    static bool ntbs_lex_lt(L* l, R* r)
+    {
+        remove_cv<L> const l_nul{};
+        remove_cv<R> const r_nul{};
+        for(;; ++l, ++r)
+        {
+            bool l_done = elem_eq(*l, l_nul);
+            bool r_done = elem_eq(*r, r_nul);
+            if (l_done || r_done) return l_done && !r_done;     // prefix is less
+
+            if (!elem_eq(*l, *r)) return elem_lt(*l, *r);
+        }
+    }
+
+    // array vs ntbs -- 3-way comparison
+    template<class L, class R, enable_if<!is_chunked_ntbs<L, R>>...>
+    static int ntbs_lex_cmp(size_t l_len, L* l, R* r)
+    {
+        remove_cv<R> const r_nul{};
+        for(; l_len > 0; --l_len, ++l, ++r)
+        {
+            if (elem_eq(*r, r_nul)) return 1;                   // 'r' is a prefix of 'l'
+            if (!elem_eq(*l, *r)) return elem_lt(*l, *r) ? -1 : 1;
+        }
+        return elem_eq(*r, r_nul) ? 0 : -1;
+    }
+
+#if defined(PARRAY_HAS_SSE2_)
+    template<class L, class R, enable_if< is_chunked_ntbs<L, R>>...>
+    static int ntbs_lex_cmp(size_t l_len, L* l, R* r) { return ntbs_ar_cmp_chunked<false, true>(l_len, as_bytes_(l), as_bytes_(r)); }
+#endif
+
+public:
+    // comparisons (eq/eq_not are inherited)
+    template<class L, class R>
+    static bool lt(size_t l_len, L* l, size_t r_len, R* r)
+    {
+        int c = ar_cmp_(l_len < r_len ? l_len : r_len, l, r);
+        return c < 0 || (c == 0 && l_len < r_len);
+    }
+
+    template<class L, class R> static bool gt    (size_t l_len, L* l, size_t r_len, R* r) { return lt (r_len, r, l_len, l); }           // l >  r -> r <  l
+    template<class L, class R> static bool lt_eq (size_t l_len, L* l, size_t r_len, R* r) { return !lt(r_len, r, l_len, l); }           // l <= r -> r >= l -> !(r < l)
+    template<class L, class R> static bool gt_eq (size_t l_len, L* l, size_t r_len, R* r) { return !lt(l_len, l, r_len, r); }           // l >= r -> !(l < r)
+
+    // ntbs comparisons (ntbs_eq/ntbs_not_eq are inherited)
+    template<class L, class R> static bool ntbs_lt    (L* l, R* r) { return !same_ptr(l, r) && ntbs_lex_lt(l, r); }
+    template<class L, class R> static bool ntbs_gt    (L* l, R* r) { return ntbs_lt    (r, l); }                        // l >  r -> r <  l
+    template<class L, class R> static bool ntbs_lt_eq (L* l, R* r) { return !ntbs_lt   (r, l); }                        // l <= r -> r >= l -> !(r < l)
+    template<class L, class R> static bool ntbs_gt_eq (L* l, R* r) { return !ntbs_lt   (l, r); }                        // l >= r -> !(l < r)
+
+    template<class L, class R> static bool ntbs_lt    (size_t l_len, L* l, R* r) { return ntbs_lex_cmp(l_len, l, r) < 0; }
+    template<class L, class R> static bool ntbs_gt    (size_t l_len, L* l, R* r) { return ntbs_lt   (r, l_len, l); }    // l >  r -> r <  l
+    template<class L, class R> static bool ntbs_lt_eq (size_t l_len, L* l, R* r) { return !ntbs_lt  (r, l_len, l); }    // l <= r -> r >= l -> !(r < l)
+    template<class L, class R> static bool ntbs_gt_eq (size_t l_len, L* l, R* r) { return !ntbs_lt  (l_len, l, r); }    // l >= r -> !(l < r)
+
+    template<class L, class R> static bool ntbs_lt    (L* l, size_t r_len, R* r) { return ntbs_lex_cmp(r_len, r, l) > 0; }
+    template<class L, class R> static bool ntbs_gt    (L* l, size_t r_len, R* r) { return ntbs_lt   (r_len, r, l); }    // l >  r -> r <  l
+    template<class L, class R> static bool ntbs_lt_eq (L* l, size_t r_len, R* r) { return !ntbs_lt  (r_len, r, l); }    // l <= r -> r >= l -> !(r < l)
+    template<class L, class R> static bool ntbs_gt_eq (L* l, size_t r_len, R* r) { return !ntbs_lt  (l, r_len, r); }    // l >= r -> !(l < r)
+};
+
+
+//------------------------------------------------------------------------------
+// ASCII case-insensitive comparisons (length is still compared first), e.g. HTTP header names:
+//
+//      using icase_string = parray<char const, parray_icase_traits>;
+//      assert( icase_string(ntba("Content-Length")) == icase_string(ntba("content-length")) );
+//      std::unordered_map<icase_string, int> m;       // hash() folds case too
+//
+// only 'A'-'Z' are folded (to 'a'-'z'), everything else (incl. non-ASCII bytes) is compared as is; arrays of same length
+// are ordered by their folded elements. Equal-length char/unsigned char arrays are folded and compared 16 (32 with AVX2)
+// bytes at a time without copying (see fold_cmp_chunked()); like other chunked comparisons it may read past the end of
+// both arrays, but never crosses page boundary
+//
+struct parray_icase_traits : parray_traits
+{
+protected:
+    template<class T> constexpr static T fold(T c) { return (c >= 'A' && c <= 'Z') ? T(c + ('a' - 'A')) : c; }
+
+    // 3-way comparison of folded equal-length arrays
+    template<class L, class R>
+    static int fold_cmp_generic(size_t len, L* l, R* r)
+    {
+        for(; len > 0; --len, ++l, ++r)
+        {
+            auto a = fold(*l);
+            auto b = fold(*r);
+            if (!elem_eq(a, b)) return elem_lt(a, b) ? -1 : 1;
+        }
+        return 0;
+    }
+
+#if defined(PARRAY_HAS_SSE2_)
+    PARRAY_NO_SANITIZE_ADDRESS_ static int fold_cmp_chunked(size_t len, unsigned char const* a, unsigned char const* b)
+    {
+        for(size_t i = 0; i < len; )
+        {
+            size_t rem = len - i;
+            if (rem >= byte_chunk::size || (byte_chunk::page_safe(a + i) && byte_chunk::page_safe(b + i)))
+            {
+                std::uint32_t diff = byte_chunk::folded_diff(a + i, b + i);
+                if (rem < byte_chunk::size) diff &= (std::uint32_t(1) << rem) - 1;    // ignore everything past the end
+                if (diff)
+                {
+                    i += ctz_(diff);
+                    return (fold(a[i]) < fold(b[i])) ? -1 : 1;
+                }
+                i += byte_chunk::size;
+            }
+            else    // tail near page boundary -- one element at a time
+            {
+                if (fold(a[i]) != fold(b[i])) return (fold(a[i]) < fold(b[i])) ? -1 : 1;
+                ++i;
+            }
+        }
+        return 0;
+    }
+#endif
+
+    // same element types that are chunked in ntbs comparisons (non-volatile char/unsigned char)
+#if defined(PARRAY_HAS_SSE2_)
+    template<class L, class R, enable_if< is_chunked_ntbs<L, R>>...> static int fold_cmp(size_t len, L* l, R* r) { return fold_cmp_chunked(len, as_bytes_(l), as_bytes_(r)); }
+#endif
+    template<class L, class R, enable_if<!is_chunked_ntbs<L, R>>...> static int fold_cmp(size_t len, L* l, R* r) { return fold_cmp_generic(len, l, r); }
+
+    template<class L, class R> static int fold_cmp_(size_t len, L* l, R* r) { return same_ptr(l, r) ? 0 : fold_cmp(len, l, r); }
+
+public:
+    // comparisons
+    template<class L, class R> static bool eq    (size_t l_len, L* l, size_t r_len, R* r) { return l_len == r_len && fold_cmp_(l_len, l, r) == 0; }
+    template<class L, class R> static bool eq_not(size_t l_len, L* l, size_t r_len, R* r) { return !eq(l_len, l, r_len, r); }           // l != r -> !(l == r)
+    template<class L, class R> static bool lt    (size_t l_len, L* l, size_t r_len, R* r) { return l_len < r_len || (l_len == r_len && fold_cmp_(l_len, l, r) < 0); }
+    template<class L, class R> static bool gt    (size_t l_len, L* l, size_t r_len, R* r) { return lt (r_len, r, l_len, l); }           // l >  r -> r <  l
+    template<class L, class R> static bool lt_eq (size_t l_len, L* l, size_t r_len, R* r) { return !lt(r_len, r, l_len, l); }           // l <= r -> r >= l -> !(r < l)
+    template<class L, class R> static bool gt_eq (size_t l_len, L* l, size_t r_len, R* r) { return !lt(l_len, l, r_len, r); }           // l >= r -> !(l < r)
+
+    // hash consistent with eq()
+    template<class T>
+    static size_t hash(size_t len, T* p, size_t seed = hash_seed)
+    {
+        for(; len > 0; --len, ++p) seed = hash_elem(seed, fold(*p));
+        return seed;
+    }
+
+    // ntbs comparisons -- lengths are found first (fast scan), then arrays are compared as above
+    template<class L, class R> static bool ntbs_eq    (L* l, R* r) { return eq   (ntbs_len(l), l, ntbs_len(r), r); }
+    template<class L, class R> static bool ntbs_not_eq(L* l, R* r) { return !ntbs_eq   (l, r); }                        // l != r -> !(l == r)
+    template<class L, class R> static bool ntbs_lt    (L* l, R* r) { return lt   (ntbs_len(l), l, ntbs_len(r), r); }
+    template<class L, class R> static bool ntbs_gt    (L* l, R* r) { return ntbs_lt    (r, l); }                        // l >  r -> r <  l
+    template<class L, class R> static bool ntbs_lt_eq (L* l, R* r) { return !ntbs_lt   (r, l); }                        // l <= r -> r >= l -> !(r < l)
+    template<class L, class R> static bool ntbs_gt_eq (L* l, R* r) { return !ntbs_lt   (l, r); }                        // l >= r -> !(l < r)
+
+    template<class L, class R> static bool ntbs_eq    (size_t l_len, L* l, R* r) { return eq   (l_len, l, ntbs_len(r), r); }
     template<class L, class R> static bool ntbs_not_eq(size_t l_len, L* l, R* r) { return !ntbs_eq  (l_len, l, r); }    // l != r -> !(l == r)
-    template<class L, class R> static bool ntbs_lt    (size_t l_len, L* l, R* r) { return ntbs_ar_lt(l_len, l, r); }
+    template<class L, class R> static bool ntbs_lt    (size_t l_len, L* l, R* r) { return lt   (l_len, l, ntbs_len(r), r); }
     template<class L, class R> static bool ntbs_gt    (size_t l_len, L* l, R* r) { return ntbs_lt   (r, l_len, l); }    // l >  r -> r <  l
     template<class L, class R> static bool ntbs_lt_eq (size_t l_len, L* l, R* r) { return !ntbs_lt  (r, l_len, l); }    // l <= r -> r >= l -> !(r < l)
     template<class L, class R> static bool ntbs_gt_eq (size_t l_len, L* l, R* r) { return !ntbs_lt  (l_len, l, r); }    // l >= r -> !(l < r)
 
     template<class L, class R> static bool ntbs_eq    (L* l, size_t r_len, R* r) { return ntbs_eq   (r_len, r, l); }    // l == r -> r == l
     template<class L, class R> static bool ntbs_not_eq(L* l, size_t r_len, R* r) { return !ntbs_eq  (l, r_len, r); }    // l != r -> !(l == r)
-    template<class L, class R> static bool ntbs_lt    (L* l, size_t r_len, R* r) { return ntbs_ar_lt(l, r_len, r); }
+    template<class L, class R> static bool ntbs_lt    (L* l, size_t r_len, R* r) { return lt   (ntbs_len(l), l, r_len, r); }
     template<class L, class R> static bool ntbs_gt    (L* l, size_t r_len, R* r) { return ntbs_lt   (r_len, r, l); }    // l >  r -> r <  l
     template<class L, class R> static bool ntbs_lt_eq (L* l, size_t r_len, R* r) { return !ntbs_lt  (r_len, r, l); }    // l <= r -> r >= l -> !(r < l)
     template<class L, class R> static bool ntbs_gt_eq (L* l, size_t r_len, R* r) { return !ntbs_lt  (l, r_len, r); }    // l >= r -> !(l < r)
 };
 
 
+//------------------------------------------------------------------------------
+// constant-time equality for secrets (tokens, MACs, password hashes), e.g.:
+//
+//      using secret = parray<unsigned char const, parray_ct_traits>;
+//      if (secret(received_mac) == secret(expected_mac)) ...
+//
+// eq()/eq_not() never exit early -- time they take depends only on array length (lengths aren't secret and are
+// compared first); non-volatile integral arrays of same element type are XOR-ed and OR-reduced 16 (32 with AVX2)
+// bytes at a time, everything else one element at a time. Accumulator is hidden from optimizer after every step, so
+// compiler can't turn the loop back into early-exit one. Ordering and hash() are inherited from parray_traits (and
+// are not constant-time); ntbs comparisons scan for terminating NUL first (time depends on ntbs length too)
+//
+struct parray_ct_traits : parray_traits
+{
+protected:
+    // hides value from optimizer
+#if defined(__GNUC__)
+    template<class T> static T opaque_(T v) { asm("" : "+r"(v)); return v; }
+#else
+    template<class T> static T opaque_(T v) { T volatile t = v; return t; }
+#endif
+
+    // non-zero if arrays differ
+    static unsigned ct_diff_bytes(size_t len, unsigned char const* a, unsigned char const* b)
+    {
+        size_t i = 0;
+#if defined(__AVX2__)
+        __m256i acc = _mm256_setzero_si256();
+        for(; len - i >= 32; i += 32)
+        {
+            __m256i va = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(a + i));
+            __m256i vb = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(b + i));
+            acc = _mm256_or_si256(acc, _mm256_xor_si256(va, vb));
+#   if defined(__GNUC__)
+            asm("" : "+x"(acc));
+#   endif
+        }
+        unsigned d = unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(acc, _mm256_setzero_si256()))) ^ 0xFFFFFFFFu;
+#elif defined(PARRAY_HAS_SSE2_)
+        __m128i acc = _mm_setzero_si128();
+        for(; len - i >= 16; i += 16)
+        {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<__m128i const*>(a + i));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<__m128i const*>(b + i));
+            acc = _mm_or_si128(acc, _mm_xor_si128(va, vb));
+#   if defined(__GNUC__)
+            asm("" : "+x"(acc));
+#   endif
+        }
+        unsigned d = unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128()))) ^ 0xFFFFu;
+#else
+        unsigned d = 0;
+        for(; len - i >= 8; i += 8)
+        {
+            std::uint64_t wa, wb;
+            memcpy(&wa, a + i, 8);
+            memcpy(&wb, b + i, 8);
+            d = opaque_(d | unsigned(((wa ^ wb) | ((wa ^ wb) >> 32)) & 0xFFFFFFFFu));
+        }
+#endif
+        for(; i < len; ++i) d = opaque_(d | unsigned(a[i] ^ b[i]));
+        return d;
+    }
+
+    // one element at a time
+    template<class L, class R>
+    static unsigned ct_diff_generic(size_t len, L* l, R* r)
+    {
+        unsigned d = 0;
+        for(; len > 0; --len, ++l, ++r) d = opaque_(d | unsigned(!elem_eq(*l, *r)));
+        return d;
+    }
+
+    template<class L, class R> constexpr static bool is_ct_bytes = !is_volatile<L> && !is_volatile<R> && is_same<remove_cv<L>, remove_cv<R>> && std::is_integral<remove_cv<L>>::value;
+
+    template<class L, class R, enable_if< is_ct_bytes<L, R>>...> static bool ct_eq(size_t len, L* l, R* r) { return ct_diff_bytes(len * sizeof(L), reinterpret_cast<unsigned char const*>(l), reinterpret_cast<unsigned char const*>(r)) == 0; }
+    template<class L, class R, enable_if<!is_ct_bytes<L, R>>...> static bool ct_eq(size_t len, L* l, R* r) { return ct_diff_generic(len, l, r) == 0; }
+
+public:
+    // comparisons (ordering is inherited)
+    template<class L, class R> static bool eq    (size_t l_len, L* l, size_t r_len, R* r) { return l_len == r_len && ct_eq(l_len, l, r); }
+    template<class L, class R> static bool eq_not(size_t l_len, L* l, size_t r_len, R* r) { return !eq(l_len, l, r_len, r); }           // l != r -> !(l == r)
+
+    // ntbs comparisons (ordering is inherited)
+    template<class L, class R> static bool ntbs_eq    (L* l, R* r) { return eq   (ntbs_len(l), l, ntbs_len(r), r); }
+    template<class L, class R> static bool ntbs_not_eq(L* l, R* r) { return !ntbs_eq   (l, r); }                        // l != r -> !(l == r)
+
+    template<class L, class R> static bool ntbs_eq    (size_t l_len, L* l, R* r) { return eq   (l_len, l, ntbs_len(r), r); }
+    template<class L, class R> static bool ntbs_not_eq(size_t l_len, L* l, R* r) { return !ntbs_eq  (l_len, l, r); }    // l != r -> !(l == r)
+
+    template<class L, class R> static bool ntbs_eq    (L* l, size_t r_len, R* r) { return ntbs_eq   (r_len, r, l); }    // l == r -> r == l
+    template<class L, class R> static bool ntbs_not_eq(L* l, size_t r_len, R* r) { return !ntbs_eq  (l, r_len, r); }    // l != r -> !(l == r)
+};
+
+
 //------------------------------------------------------------------------------
 template<class T, class Traits = parray_traits>
 struct parray
@@ -488,6 +1052,7 @@ inline parray<T, Traits> ntba(T (&r)[len]) { return {len - 1, r}; }
 //      for(...)
 //          foo( rcstring(s) );     // bad, length gets calculated here repeatedly
 //  - same for comparisons: if same ntbs is going to participate in multiple comparisons -- it is better to convert it into parray
+//    (or use ntbs_cached())
 //
 template<class T, class Traits>
 struct ntbs_t
@@ -584,6 +1149,139 @@ template<class Traits = parray_traits, class T, enable_if<is_char<T>>...>
 inline ntbs_t<T, Traits> ntbs(T* const& p) { return {p}; }
 
 
+//------------------------------------------------------------------------------
+// Null-terminated string with cached length -- same as ntbs_t, but length is calculated (once) on first use that needs
+// it, every comparison after that uses length-first algorithms for arrays, e.g.:
+//
+//      auto s = ntbs_cached(name);         // cheap, length isn't known yet
+//      for(rcstring key : keys)
+//          if (s == key) ...               // first comparison calculates length, the rest don't scan 's' for NUL
+//
+// Notes:
+//  - comparison operators take it by reference -- pass it around by reference too (or length will be recalculated)
+//  - it is not thread-safe: sharing the same object between threads requires calling size() first
+//  - ntbs_cached_t vs ntbs_t comparisons use mixed algorithms (length of ntbs_t is still unknown)
+//
+template<class T, class Traits>
+struct ntbs_cached_t
+{
+    static constexpr size_t unknown_len = ~size_t(0);
+
+    T* p;
+    mutable size_t len;                     // unknown_len until calculated
+
+    size_t size() const { if (len == unknown_len) len = Traits::ntbs_len(p); return len; }
+    bool size_known() const { return len != unknown_len; }
+
+    template<class E, class Traits2, enable_if<is_almost_same<T, E>>...>
+    explicit operator parray<E, Traits2>() const { return {size(), p}; }
+
+    // comparisons
+
+    // ntbs_cached_t<T, Traits> vs ntbs_cached_t<E, Traits>
+    template<class E> friend bool operator==(ntbs_cached_t const& l, ntbs_cached_t<E, Traits> const& r) { return Traits::eq    (l.size(), l.p, r.size(), r.p); }
+    template<class E> friend bool operator!=(ntbs_cached_t const& l, ntbs_cached_t<E, Traits> const& r) { return Traits::eq_not(l.size(), l.p, r.size(), r.p); }
+    template<class E> friend bool operator< (ntbs_cached_t const& l, ntbs_cached_t<E, Traits> const& r) { return Traits::lt    (l.size(), l.p, r.size(), r.p); }
+    template<class E> friend bool operator> (ntbs_cached_t const& l, ntbs_cached_t<E, Traits> const& r) { return Traits::gt    (l.size(), l.p, r.size(), r.p); }
+    template<class E> friend bool operator<=(ntbs_cached_t const& l, ntbs_cached_t<E, Traits> const& r) { return Traits::lt_eq (l.size(), l.p, r.size(), r.p); }
+    template<class E> friend bool operator>=(ntbs_cached_t const& l, ntbs_cached_t<E, Traits> const& r) { return Traits::gt_eq (l.size(), l.p, r.size(), r.p); }
+
+    // ntbs_cached_t<T, Traits> vs ntbs_t<E, Traits> (length of the other side is unknown -- mixed comparison)
+    template<class E> friend bool operator==(ntbs_cached_t const& l, ntbs_t<E, Traits> r) { return Traits::ntbs_eq    (l.size(), l.p, r.p); }
+    template<class E> friend bool operator!=(ntbs_cached_t const& l, ntbs_t<E, Traits> r) { return Traits::ntbs_not_eq(l.size(), l.p, r.p); }
+    template<class E> friend bool operator< (ntbs_cached_t const& l, ntbs_t<E, Traits> r) { return Traits::ntbs_lt    (l.size(), l.p, r.p); }
+    template<class E> friend bool operator> (ntbs_cached_t const& l, ntbs_t<E, Traits> r) { return Traits::ntbs_gt    (l.size(), l.p, r.p); }
+    template<class E> friend bool operator<=(ntbs_cached_t const& l, ntbs_t<E, Traits> r) { return Traits::ntbs_lt_eq (l.size(), l.p, r.p); }
+    template<class E> friend bool operator>=(ntbs_cached_t const& l, ntbs_t<E, Traits> r) { return Traits::ntbs_gt_eq (l.size(), l.p, r.p); }
+    template<class E> friend bool operator==(ntbs_t<E, Traits> l, ntbs_cached_t const& r) { return Traits::ntbs_eq    (l.p, r.size(), r.p); }
+    template<class E> friend bool operator!=(ntbs_t<E, Traits> l, ntbs_cached_t const& r) { return Traits::ntbs_not_eq(l.p, r.size(), r.p); }
+    template<class E> friend bool operator< (ntbs_t<E, Traits> l, ntbs_cached_t const& r) { return Traits::ntbs_lt    (l.p, r.size(), r.p); }
+    template<class E> friend bool operator> (ntbs_t<E, Traits> l, ntbs_cached_t const& r) { return Traits::ntbs_gt    (l.p, r.size(), r.p); }
+    template<class E> friend bool operator<=(ntbs_t<E, Traits> l, ntbs_cached_t const& r) { return Traits::ntbs_lt_eq (l.p, r.size(), r.p); }
+    template<class E> friend bool operator>=(ntbs_t<E, Traits> l, ntbs_cached_t const& r) { return Traits::ntbs_gt_eq (l.p, r.size(), r.p); }
+
+    // ntbs_cached_t<T, Traits> vs parray<E, Traits>
+    template<class E> friend bool operator==(ntbs_cached_t const& l, parray<E, Traits> r) { return Traits::eq    (l.size(), l.p, r.len, r.p); }
+    template<class E> friend bool operator!=(ntbs_cached_t const& l, parray<E, Traits> r) { return Traits::eq_not(l.size(), l.p, r.len, r.p); }
+    template<class E> friend bool operator< (ntbs_cached_t const& l, parray<E, Traits> r) { return Traits::lt    (l.size(), l.p, r.len, r.p); }
+    template<class E> friend bool operator> (ntbs_cached_t const& l, parray<E, Traits> r) { return Traits::gt    (l.size(), l.p, r.len, r.p); }
+    template<class E> friend bool operator<=(ntbs_cached_t const& l, parray<E, Traits> r) { return Traits::lt_eq (l.size(), l.p, r.len, r.p); }
+    template<class E> friend bool operator>=(ntbs_cached_t const& l, parray<E, Traits> r) { return Traits::gt_eq (l.size(), l.p, r.len, r.p); }
+    template<class E> friend bool operator==(parray<E, Traits> l, ntbs_cached_t const& r) { return Traits::eq    (l.len, l.p, r.size(), r.p); }
+    template<class E> friend bool operator!=(parray<E, Traits> l, ntbs_cached_t const& r) { return Traits::eq_not(l.len, l.p, r.size(), r.p); }
+    template<class E> friend bool operator< (parray<E, Traits> l, ntbs_cached_t const& r) { return Traits::lt    (l.len, l.p, r.size(), r.p); }
+    template<class E> friend bool operator> (parray<E, Traits> l, ntbs_cached_t const& r) { return Traits::gt    (l.len, l.p, r.size(), r.p); }
+    template<class E> friend bool operator<=(parray<E, Traits> l, ntbs_cached_t const& r) { return Traits::lt_eq (l.len, l.p, r.size(), r.p); }
+    template<class E> friend bool operator>=(parray<E, Traits> l, ntbs_cached_t const& r) { return Traits::gt_eq (l.len, l.p, r.size(), r.p); }
+
+    // ntbs_cached_t<T, Traits> vs basic_string<E, Tr, A>
+    template<class E, class Tr, class A> friend bool operator==(ntbs_cached_t const& l, basic_string<E, Tr, A> const& r) { return l == parray<E const, Traits>(r); }
+    template<class E, class Tr, class A> friend bool operator!=(ntbs_cached_t const& l, basic_string<E, Tr, A> const& r) { return l != parray<E const, Traits>(r); }
+    template<class E, class Tr, class A> friend bool operator< (ntbs_cached_t const& l, basic_string<E, Tr, A> const& r) { return l <  parray<E const, Traits>(r); }
+    template<class E, class Tr, class A> friend bool operator> (ntbs_cached_t const& l, basic_string<E, Tr, A> const& r) { return l >  parray<E const, Traits>(r); }
+    template<class E, class Tr, class A> friend bool operator<=(ntbs_cached_t const& l, basic_string<E, Tr, A> const& r) { return l <= parray<E const, Traits>(r); }
+    template<class E, class Tr, class A> friend bool operator>=(ntbs_cached_t const& l, basic_string<E, Tr, A> const& r) { return l >= parray<E const, Traits>(r); }
+    template<class E, class Tr, class A> friend bool operator==(basic_string<E, Tr, A> const& l, ntbs_cached_t const& r) { return parray<E const, Traits>(l) == r; }
+    template<class E, class Tr, class A> friend bool operator!=(basic_string<E, Tr, A> const& l, ntbs_cached_t const& r) { return parray<E const, Traits>(l) != r; }
+    template<class E, class Tr, class A> friend bool operator< (basic_string<E, Tr, A> const& l, ntbs_cached_t const& r) { return parray<E const, Traits>(l) <  r; }
+    template<class E, class Tr, class A> friend bool operator> (basic_string<E, Tr, A> const& l, ntbs_cached_t const& r) { return parray<E const, Traits>(l) >  r; }
+    template<class E, class Tr, class A> friend bool operator<=(basic_string<E, Tr, A> const& l, ntbs_cached_t const& r) { return parray<E const, Traits>(l) <= r; }
+    template<class E, class Tr, class A> friend bool operator>=(basic_string<E, Tr, A> const& l, ntbs_cached_t const& r) { return parray<E const, Traits>(l) >= r; }
+
+    // ntbs_cached_t<T, Traits> vs vector<E, A>
+    template<class E, class A> friend bool operator==(ntbs_cached_t const& l, vector<E, A> const& r) { return l == parray<E const, Traits>(r); }
+    template<class E, class A> friend bool operator!=(ntbs_cached_t const& l, vector<E, A> const& r) { return l != parray<E const, Traits>(r); }
+    template<class E, class A> friend bool operator< (ntbs_cached_t const& l, vector<E, A> const& r) { return l <  parray<E const, Traits>(r); }
+    template<class E, class A> friend bool operator> (ntbs_cached_t const& l, vector<E, A> const& r) { return l >  parray<E const, Traits>(r); }
+    template<class E, class A> friend bool operator<=(ntbs_cached_t const& l, vector<E, A> const& r) { return l <= parray<E const, Traits>(r); }
+    template<class E, class A> friend bool operator>=(ntbs_cached_t const& l, vector<E, A> const& r) { return l >= parray<E const, Traits>(r); }
+    template<class E, class A> friend bool operator==(vector<E, A> const& l, ntbs_cached_t const& r) { return parray<E const, Traits>(l) == r; }
+    template<class E, class A> friend bool operator!=(vector<E, A> const& l, ntbs_cached_t const& r) { return parray<E const, Traits>(l) != r; }
+    template<class E, class A> friend bool operator< (vector<E, A> const& l, ntbs_cached_t const& r) { return parray<E const, Traits>(l) <  r; }
+    template<class E, class A> friend bool operator> (vector<E, A> const& l, ntbs_cached_t const& r) { return parray<E const, Traits>(l) >  r; }
+    template<class E, class A> friend bool operator<=(vector<E, A> const& l, ntbs_cached_t const& r) { return parray<E const, Traits>(l) <= r; }
+    template<class E, class A> friend bool operator>=(vector<E, A> const& l, ntbs_cached_t const& r) { return parray<E const, Traits>(l) >= r; }
+
+    template<class E, class A> friend bool operator==(ntbs_cached_t const& l, vector<E, A>& r) { return l == parray<E, Traits>(r); }
+    template<class E, class A> friend bool operator!=(ntbs_cached_t const& l, vector<E, A>& r) { return l != parray<E, Traits>(r); }
+    template<class E, class A> friend bool operator< (ntbs_cached_t const& l, vector<E, A>& r) { return l <  parray<E, Traits>(r); }
+    template<class E, class A> friend bool operator> (ntbs_cached_t const& l, vector<E, A>& r) { return l >  parray<E, Traits>(r); }
+    template<class E, class A> friend bool operator<=(ntbs_cached_t const& l, vector<E, A>& r) { return l <= parray<E, Traits>(r); }
+    template<class E, class A> friend bool operator>=(ntbs_cached_t const& l, vector<E, A>& r) { return l >= parray<E, Traits>(r); }
+    template<class E, class A> friend bool operator==(vector<E, A>& l, ntbs_cached_t const& r) { return parray<E, Traits>(l) == r; }
+    template<class E, class A> friend bool operator!=(vector<E, A>& l, ntbs_cached_t const& r) { return parray<E, Traits>(l) != r; }
+    template<class E, class A> friend bool operator< (vector<E, A>& l, ntbs_cached_t const& r) { return parray<E, Traits>(l) <  r; }
+    template<class E, class A> friend bool operator> (vector<E, A>& l, ntbs_cached_t const& r) { return parray<E, Traits>(l) >  r; }
+    template<class E, class A> friend bool operator<=(vector<E, A>& l, ntbs_cached_t const& r) { return parray<E, Traits>(l) <= r; }
+    template<class E, class A> friend bool operator>=(vector<E, A>& l, ntbs_cached_t const& r) { return parray<E, Traits>(l) >= r; }
+
+    // ntbs_cached_t<T, Traits> vs E[len]
+    template<class E, size_t len, enable_if<!is_char<E>>...> friend bool operator==(ntbs_cached_t const& l, E (&r)[len]) { return l == parray<E, Traits>(r); }
+    template<class E, size_t len, enable_if<!is_char<E>>...> friend bool operator!=(ntbs_cached_t const& l, E (&r)[len]) { return l != parray<E, Traits>(r); }
+    template<class E, size_t len, enable_if<!is_char<E>>...> friend bool operator< (ntbs_cached_t const& l, E (&r)[len]) { return l <  parray<E, Traits>(r); }
+    template<class E, size_t len, enable_if<!is_char<E>>...> friend bool operator> (ntbs_cached_t const& l, E (&r)[len]) { return l >  parray<E, Traits>(r); }
+    template<class E, size_t len, enable_if<!is_char<E>>...> friend bool operator<=(ntbs_cached_t const& l, E (&r)[len]) { return l <= parray<E, Traits>(r); }
+    template<class E, size_t len, enable_if<!is_char<E>>...> friend bool operator>=(ntbs_cached_t const& l, E (&r)[len]) { return l >= parray<E, Traits>(r); }
+    template<class E, size_t len, enable_if<!is_char<E>>...> friend bool operator==(E (&l)[len], ntbs_cached_t const& r) { return parray<E, Traits>(l) == r; }
+    template<class E, size_t len, enable_if<!is_char<E>>...> friend bool operator!=(E (&l)[len], ntbs_cached_t const& r) { return parray<E, Traits>(l) != r; }
+    template<class E, size_t len, enable_if<!is_char<E>>...> friend bool operator< (E (&l)[len], ntbs_cached_t const& r) { return parray<E, Traits>(l) <  r; }
+    template<class E, size_t len, enable_if<!is_char<E>>...> friend bool operator> (E (&l)[len], ntbs_cached_t const& r) { return parray<E, Traits>(l) >  r; }
+    template<class E, size_t len, enable_if<!is_char<E>>...> friend bool operator<=(E (&l)[len], ntbs_cached_t const& r) { return parray<E, Traits>(l) <= r; }
+    template<class E, size_t len, enable_if<!is_char<E>>...> friend bool operator>=(E (&l)[len], ntbs_cached_t const& r) { return parray<E, Traits>(l) >= r; }
+
+    // ostream <<
+    template<class E, class Tr, enable_if<is_almost_same<T, E const>>...> friend basic_ostream<E, Tr>& operator<<(basic_ostream<E, Tr>& os, ntbs_cached_t const& v) { return os << v.p; }
+};
+
+template<class T, class Traits> constexpr size_t ntbs_cached_t<T, Traits>::unknown_len;
+
+template<class Traits = parray_traits, class T, enable_if<is_char<T>>...>
+inline ntbs_cached_t<T, Traits> ntbs_cached(T* const& p) { return {p, ntbs_cached_t<T, Traits>::unknown_len}; }
+
+template<class T, class Traits>
+inline ntbs_cached_t<T, Traits> ntbs_cached(ntbs_t<T, Traits> v) { return {v.p, ntbs_cached_t<T, Traits>::unknown_len}; }
+
+
 //------------------------------------------------------------------------------
 } // namespace parray_pvt_
 //------------------------------------------------------------------------------
@@ -592,8 +1290,14 @@ inline ntbs_t<T, Traits> ntbs(T* const& p) { return {p}; }
 //------------------------------------------------------------------------------
 using parray_pvt_::parray;
 using parray_pvt_::parray_traits;
+using parray_pvt_::parray_wide_traits;
+using parray_pvt_::parray_lex_traits;
+using parray_pvt_::parray_icase_traits;
+using parray_pvt_::parray_ct_traits;
 using parray_pvt_::ntba;
 using parray_pvt_::ntbs;
+using parray_pvt_::ntbs_cached_t;
+using parray_pvt_::ntbs_cached;
 using rbytes    = parray<unsigned char>;
 using rcbytes   = parray<unsigned char const>;
 using rstring   = parray<char>;
@@ -624,5 +1328,19 @@ inline parray<char32_t const> operator""_rs(char32_t const* p, std::size_t len)
 //------------------------------------------------------------------------------
 
 
+//------------------------------------------------------------------------------
+// parray as a key of unordered containers (Traits::hash() is consistent with Traits::eq())
+//
+namespace std {
+
+template<class T, class Traits>
+struct hash<adv::parray<T, Traits>>
+{
+    size_t operator()(adv::parray<T, Traits> const& v) const { return Traits::hash(v.len, v.p); }
+};
+
+} // namespace std
+
+
 #endif //PARRAY_H_2016_08_30_04_03_32_135_H_
 
@@ -0,0 +1,1520 @@
+//------------------------------------------------------------------------------
+// parray benchmarks
+//
+//  usage: parray_bench [--json] [filter]
+//      runs every benchmark whose name contains 'filter' (all of them if it is omitted)
+//      --json -- print results (and build configuration) as one JSON document instead of a table
+//
+//  Datasets are generated from fixed seeds, i.e. every run measures the same data.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <thread>
+#include <algorithm>
+#if __cplusplus >= 201703L
+#   include <string_view>
+#endif
+#include "parray.h"
+#include "parray_tools.h"
+#include "parray_parse.h"
+#include "parray_format.h"
+#include "str_printf.h"
+#include "str_format.h"
+#include "parray_iovec.h"
+#include "parray_flat_map.h"
+#include "parray_string_table.h"
+#include "parray_sort.h"
+#include "parray_owned.h"
+#include "parray_shared.h"
+#include "parray_rope.h"
+#include "parray_concat.h"
+#include "parray_utf.h"
+#include "parray_stats.h"
+#include "parray_dispatch.h"
+#include <locale>
+#include <codecvt>
+#ifdef PARRAY_IOVEC_HAS_WRITEV
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
+
+//------------------------------------------------------------------------------
+using namespace std;
+using namespace adv;
+
+
+//------------------------------------------------------------------------------
+// harness
+//
+
+static char const* g_filter = nullptr;
+static bool g_json = false;
+
+struct bench_result
+{
+    string name;
+    size_t iterations;
+    double ns_per_op;
+};
+
+static vector<bench_result> g_results;     // collected for --json
+
+static void report(char const* name, size_t iterations, double ns)
+{
+    if (g_json)
+        g_results.push_back({name, iterations, ns / iterations});
+    else
+        printf("%-48s %10.2f ns/op\n", name, ns / iterations);
+}
+
+static string json_str(string const& s)
+{
+    string r = "\"";
+    for(char c : s)
+    {
+        if (c == '"' || c == '\\') r += '\\';
+        r += c;
+    }
+    return r + "\"";
+}
+
+// compiler identification (__VERSION__ is GCC/Clang extension)
+static string compiler_id()
+{
+#if defined(__VERSION__)
+    return __VERSION__;
+#elif defined(_MSC_FULL_VER)
+    return "MSVC " + std::to_string(_MSC_FULL_VER);
+#else
+    return "unknown";
+#endif
+}
+
+static void print_json()
+{
+    printf("{\n  \"build\": { \"compiler\": %s, \"cplusplus\": %ld, \"sse2\": %s, \"avx2\": %s, \"ndebug\": %s, \"hardware_concurrency\": %u },\n  \"results\": [",
+        json_str(compiler_id()).c_str(), long(__cplusplus),
+#if defined(PARRAY_HAS_SSE2_)
+        "true",
+#else
+        "false",
+#endif
+#if defined(__AVX2__)
+        "true",
+#else
+        "false",
+#endif
+#if defined(NDEBUG)
+        "true",
+#else
+        "false",
+#endif
+        std::thread::hardware_concurrency()
+    );
+
+    for(size_t i = 0; i < g_results.size(); ++i)
+        printf("%s\n    { \"name\": %s, \"iterations\": %zu, \"ns_per_op\": %.3f }", i ? "," : "",
+            json_str(g_results[i].name).c_str(), g_results[i].iterations, g_results[i].ns_per_op);
+
+    printf("\n  ]\n}\n");
+}
+
+// prevents compiler from optimizing away benchmarked code
+template<class T>
+inline void keep(T const& v)
+{
+#if defined(__GNUC__)
+    asm volatile("" : : "g"(&v) : "memory");
+#else
+    static T volatile const* volatile sink;
+    sink = &v;
+#endif
+}
+
+// true if any of given benchmarks is going to run (to skip building expensive datasets)
+static bool wanted(initializer_list<string> names)
+{
+    return !g_filter || any_of(names.begin(), names.end(), [](string const& name) { return strstr(name.c_str(), g_filter) != nullptr; });
+}
+
+// f(size_t i) is called 'iterations' times, reports average time per call
+template<class F>
+static void bench(char const* name, size_t iterations, F f)
+{
+    if (g_filter && !strstr(name, g_filter)) return;
+
+    for(size_t i = 0; i < iterations / 10; ++i) f(i);          // warm up
+
+    auto t0 = chrono::steady_clock::now();
+    for(size_t i = 0; i < iterations; ++i) f(i);
+    auto t1 = chrono::steady_clock::now();
+
+    report(name, iterations, chrono::duration<double, nano>(t1 - t0).count());
+}
+
+
+//------------------------------------------------------------------------------
+// datasets
+//
+
+static vector<string> make_numbers(size_t count, bool floating)
+{
+    mt19937_64 rng(42);
+    vector<string> res;
+    res.reserve(count);
+
+    char buf[64];
+    for(size_t i = 0; i < count; ++i)
+    {
+        if (floating)
+            snprintf(buf, sizeof(buf), "%.*g", int(rng() % 17) + 1, double(int64_t(rng())) / double(rng() % 1000000 + 1));
+        else
+            snprintf(buf, sizeof(buf), "%lld", (long long)(int64_t(rng()) >> (rng() % 64)));
+        res.emplace_back(buf);
+    }
+    return res;
+}
+
+
+// keys with skewed length distribution: mostly short, some medium, few long; a third share common prefix
+static vector<string> make_keys(size_t count)
+{
+    mt19937_64 rng(7);
+    vector<string> res;
+    res.reserve(count);
+    for(size_t i = 0; i < count; ++i)
+    {
+        unsigned r = rng() % 100;
+        size_t len = (r < 70) ? 4 + rng() % 9 : (r < 95) ? 16 + rng() % 49 : 128 + rng() % 897;
+        string k = (rng() % 3 == 0) ? "session:" : "";
+        while(k.size() < len) k += char('a' + rng() % 26);
+        res.push_back(move(k));
+    }
+    return res;
+}
+
+// CSV lines: 8-12 fields (numbers, words, quoted-less text with spaces, occasional empty ones)
+static vector<string> make_csv(size_t count)
+{
+    mt19937_64 rng(11);
+    vector<string> res;
+    res.reserve(count);
+    for(size_t i = 0; i < count; ++i)
+    {
+        string line;
+        for(size_t f = 0, fields = 8 + rng() % 5; f < fields; ++f)
+        {
+            if (f) line += ',';
+            switch(rng() % 4)
+            {
+            case 0:  line += to_string(rng() % 100000); break;
+            case 1:  for(size_t n = 3 + rng() % 10; n; --n) line += char('a' + rng() % 26); break;
+            case 2:  line += "some text " + to_string(rng() % 1000); break;
+            default: break;                                             // empty field
+            }
+        }
+        res.push_back(move(line));
+    }
+    return res;
+}
+
+// XML document: list of records with attributes and text nodes (surrounded by whitespaces)
+static string make_xml(size_t records)
+{
+    mt19937_64 rng(13);
+    string res = "<?xml version=\"1.0\"?>\n<items>\n";
+    for(size_t i = 0; i < records; ++i)
+    {
+        res += "  <item id=\"" + to_string(i) + "\" rank=\"" + to_string(rng() % 100) + "\">\n    <name>  ";
+        for(size_t n = 4 + rng() % 12; n; --n) res += char('a' + rng() % 26);
+        res += "  </name>\n    <price>" + to_string(rng() % 10000) + ".99</price>\n  </item>\n";
+    }
+    return res + "</items>\n";
+}
+
+
+//------------------------------------------------------------------------------
+// core operations: comparisons, split, join, contains, trim
+//
+
+static void bench_compare()
+{
+    size_t const n = 4096;
+    size_t const iterations = 4000000;
+
+    auto keys = make_keys(n);
+    vector<string> keys2(keys);                                         // same content, different memory
+    vector<rcstring> views, views2;
+    for(size_t i = 0; i < n; ++i) { views.push_back(rcstring(keys[i])); views2.push_back(rcstring(keys2[i])); }
+
+    // pairs: (i, i) -- equal, (i, i + 1) -- mostly different lengths
+    bench("compare/keys/==/equal/rcstring", iterations, [&](size_t i) { keep(views[i % n] == views2[i % n]); });
+    bench("compare/keys/==/equal/std::string", iterations, [&](size_t i) { keep(keys[i % n] == keys2[i % n]); });
+    bench("compare/keys/==/equal/rcstring vs std::string", iterations, [&](size_t i) { keep(views[i % n] == keys2[i % n]); });
+    bench("compare/keys/==/random/rcstring", iterations, [&](size_t i) { keep(views[i % n] == views2[(i + 1) % n]); });
+    bench("compare/keys/==/random/std::string", iterations, [&](size_t i) { keep(keys[i % n] == keys2[(i + 1) % n]); });
+    bench("compare/keys/</random/rcstring", iterations, [&](size_t i) { keep(views[i % n] < views2[(i + 1) % n]); });
+    bench("compare/keys/</random/std::string", iterations, [&](size_t i) { keep(keys[i % n] < keys2[(i + 1) % n]); });
+    bench("compare/keys/</equal/rcstring", iterations, [&](size_t i) { keep(views[i % n] < views2[i % n]); });
+    bench("compare/keys/</equal/std::string", iterations, [&](size_t i) { keep(keys[i % n] < keys2[i % n]); });
+
+#if __cplusplus >= 201703L
+    vector<string_view> svs, svs2;
+    for(size_t i = 0; i < n; ++i) { svs.push_back(keys[i]); svs2.push_back(keys2[i]); }
+
+    bench("compare/keys/==/equal/std::string_view", iterations, [&](size_t i) { keep(svs[i % n] == svs2[i % n]); });
+    bench("compare/keys/==/random/std::string_view", iterations, [&](size_t i) { keep(svs[i % n] == svs2[(i + 1) % n]); });
+    bench("compare/keys/</random/std::string_view", iterations, [&](size_t i) { keep(svs[i % n] < svs2[(i + 1) % n]); });
+    bench("compare/keys/</equal/std::string_view", iterations, [&](size_t i) { keep(svs[i % n] < svs2[i % n]); });
+#endif
+}
+
+// every form of given split function: functor, deque and fixed buffer results
+template<class D, class S>
+static void bench_split_form(string const& prefix, vector<rcstring> const& lines, D const& delim, S form)
+{
+    size_t const n = lines.size();
+    size_t const iterations = 400000;
+
+    bench((prefix + "/functor").c_str(), iterations, [&](size_t i) {
+        form(lines[i % n], delim, [](rcstring v) { keep(v); return false; });
+    });
+
+    bench((prefix + "/deque").c_str(), iterations / 4, [&](size_t i) {
+        keep(form(lines[i % n], delim));
+    });
+
+    bench((prefix + "/buf[8]").c_str(), iterations, [&](size_t i) {
+        rcstring buf[8];
+        keep(form(lines[i % n], delim, buf));
+        keep(buf);
+    });
+}
+
+template<class D>
+static void bench_split_kind(string const& prefix, vector<rcstring> const& lines, D const& delim)
+{
+    bench_split_form(prefix + "/split",     lines, delim, [](auto&&... a) { return split(a...); });
+    bench_split_form(prefix + "/split_se",  lines, delim, [](auto&&... a) { return split_se(a...); });
+    bench_split_form(prefix + "/rsplit",    lines, delim, [](auto&&... a) { return rsplit(a...); });
+    bench_split_form(prefix + "/rsplit_se", lines, delim, [](auto&&... a) { return rsplit_se(a...); });
+}
+
+static void bench_split()
+{
+    auto csv = make_csv(4096);
+    vector<rcstring> lines;
+    for(auto& l : csv) lines.push_back(rcstring(l));
+
+    bench_split_kind("split/csv/value", lines, ',');
+    bench_split_kind("split/csv/parray", lines, ntba(",;"));
+    bench_split_kind("split/csv/bitset_delim", lines, bitset_delim<>{ ntba(",;") });
+
+    bench("split/csv/baseline/std::string::find loop", 400000, [&](size_t i) {
+        string const& l = csv[i % csv.size()];
+        for(size_t p = 0, q; ; p = q + 1)
+        {
+            q = l.find(',', p);
+            keep(l.data() + p);
+            if (q == string::npos) break;
+        }
+    });
+
+    string xml = make_xml(2000);
+    rcstring doc(xml);
+    bench("split/xml/split_se(parray \"<>\")", 200, [&](size_t) {
+        split_se(doc, ntba("<>"), [](rcstring v) { keep(v); return false; });
+    });
+    bench("split/xml/split_se(bitset_delim \"<>\")", 200, [&](size_t) {
+        split_se(doc, bitset_delim<>{ ntba("<>") }, [](rcstring v) { keep(v); return false; });
+    });
+    bench("split/xml/split('\\n')", 200, [&](size_t) {
+        split(doc, '\n', [](rcstring v) { keep(v); return false; });
+    });
+}
+
+static void bench_join()
+{
+    auto csv = make_csv(4096);
+    vector<vector<rcstring>> rows;
+    for(auto& l : csv)
+    {
+        vector<rcstring> fields;
+        split(rcstring(l), ',', [&fields](rcstring v) { fields.push_back(v); return false; });
+        rows.push_back(move(fields));
+    }
+    size_t const n = rows.size();
+    size_t const iterations = 400000;
+
+    bench("join/csv/join<string>(value)", iterations, [&](size_t i) {
+        auto& r = rows[i % n];
+        keep(join<string>(r.begin(), r.end(), ';'));
+    });
+
+    bench("join/csv/join_se<string>(parray)", iterations, [&](size_t i) {
+        auto& r = rows[i % n];
+        keep(join_se<string>(r.begin(), r.end(), ntba("; ")));
+    });
+
+    bench("join/csv/rjoin<string>(value)", iterations, [&](size_t i) {
+        auto& r = rows[i % n];
+        keep(rjoin<string>(r.begin(), r.end(), ';'));
+    });
+
+    bench("join/csv/join(functor)", iterations, [&](size_t i) {
+        auto& r = rows[i % n];
+        size_t len = 0;
+        join(r.begin(), r.end(), ';', [&len](rcstring v) { len += v.len; });
+        keep(len);
+    });
+
+    bench("join/csv/baseline/std::string +=", iterations, [&](size_t i) {
+        auto& r = rows[i % n];
+        string s;
+        for(size_t k = 0; k < r.size(); ++k)
+        {
+            if (k) s += ';';
+            s.append(r[k].p, r[k].len);
+        }
+        keep(s);
+    });
+}
+
+static void bench_contains()
+{
+    string xml = make_xml(2000);
+    rcstring doc(xml);
+    size_t const iterations = 2000;
+
+    // needles are separate copies (contains() has a shortcut for subarrays of haystack)
+    string early = "<item id=\"10\"", late = "<item id=\"1990\"", missing = "<item id=\"x\"";
+
+    for(auto* needle : { &early, &late, &missing })
+    {
+        string suffix = (needle == &early) ? "early" : (needle == &late) ? "late" : "missing";
+        rcstring nv(*needle);
+
+        bench(("contains/xml/" + suffix + "/contains").c_str(), iterations, [&](size_t) {
+            keep(contains(doc, nv));
+        });
+        bench(("contains/xml/" + suffix + "/std::string::find").c_str(), iterations, [&](size_t) {
+            keep(xml.find(*needle));
+        });
+    }
+}
+
+static void bench_trim()
+{
+    mt19937_64 rng(17);
+    vector<string> texts;
+    for(size_t i = 0; i < 4096; ++i)
+        texts.push_back(string(rng() % 8, ' ') + string(4 + rng() % 30, 'x') + string(rng() % 8, (rng() % 2) ? ' ' : '\n'));
+
+    vector<rcstring> views;
+    for(auto& t : texts) views.push_back(rcstring(t));
+    size_t const n = views.size();
+    size_t const iterations = 4000000;
+
+    bench("trim/text/trim", iterations, [&](size_t i) { keep(trim(views[i % n])); });
+    bench("trim/text/trim_left", iterations, [&](size_t i) { keep(trim_left(views[i % n])); });
+    bench("trim/text/trim_right", iterations, [&](size_t i) { keep(trim_right(views[i % n])); });
+    bench("trim/text/baseline/find_first_not_of", iterations, [&](size_t i) {
+        string const& t = texts[i % n];
+        size_t b = t.find_first_not_of(" \t\n\v\f\r"), e = t.find_last_not_of(" \t\n\v\f\r");
+        keep(b);
+        keep(e);
+    });
+}
+
+
+//------------------------------------------------------------------------------
+// parse
+//
+
+static void bench_parse()
+{
+    size_t const n = 4096;
+    size_t const iterations = 2000000;
+
+    auto ints = make_numbers(n, false);
+    vector<rcstring> int_views;
+    for(auto& s : ints) int_views.push_back(rcstring(s));
+
+    bench("parse/int64/parse<T>", iterations, [&](size_t i) {
+        auto r = parse<long long>(int_views[i % n]);
+        keep(r.value);
+    });
+
+    bench("parse/int64/str()+strtoll", iterations, [&](size_t i) {
+        auto r = strtoll(int_views[i % n].str().c_str(), nullptr, 10);
+        keep(r);
+    });
+
+    auto dbls = make_numbers(n, true);
+    vector<rcstring> dbl_views;
+    for(auto& s : dbls) dbl_views.push_back(rcstring(s));
+
+    bench("parse/double/parse<T>", iterations, [&](size_t i) {
+        auto r = parse<double>(dbl_views[i % n]);
+        keep(r.value);
+    });
+
+    bench("parse/double/str()+strtod", iterations, [&](size_t i) {
+        auto r = strtod(dbl_views[i % n].str().c_str(), nullptr);
+        keep(r);
+    });
+}
+
+
+//------------------------------------------------------------------------------
+// format
+//
+
+static void bench_format()
+{
+    size_t const n = 4096;
+    size_t const iterations = 2000000;
+
+    mt19937_64 rng(42);
+    vector<int> ints(n);
+    vector<double> dbls(n);
+    for(auto& v : ints) v = int(rng() >> (32 + rng() % 32));
+    for(auto& v : dbls) v = double(int64_t(rng())) / double(rng() % 1000000 + 1);
+
+    bench("format/int/format_int", iterations, [&](size_t i) {
+        char buf[format_max<int>];
+        auto r = format_int(buf, ints[i % n]);
+        keep(r);
+    });
+
+    bench("format/int/str_printf(%d)", iterations, [&](size_t i) {
+        char buf[32];
+        auto r = common::str_printf(buf, "%d", ints[i % n]);
+        keep(r);
+    });
+
+    bench("format/double/format_double", iterations, [&](size_t i) {
+        char buf[format_max<double>];
+        auto r = format_double(buf, dbls[i % n]);
+        keep(r);
+    });
+
+    bench("format/double/str_printf(%.17g)", iterations, [&](size_t i) {
+        char buf[32];
+        auto r = common::str_printf(buf, "%.17g", dbls[i % n]);
+        keep(r);
+    });
+
+    // typical log line fragment
+    bench("format/log/format_int", iterations, [&](size_t i) {
+        char buf[128];
+        size_t len = 0;
+        for(size_t k = 0; k < 4; ++k)
+        {
+            memcpy(buf + len, " id=", 4);
+            len += 4;
+            len += format_int(buf + len, sizeof(buf) - len, ints[(i + k) % n]).len;
+        }
+        keep(len);
+    });
+
+    bench("format/log/str_printf", iterations, [&](size_t i) {
+        char buf[128];
+        auto r = common::str_printf(buf, " id=%d id=%d id=%d id=%d", ints[i % n], ints[(i + 1) % n], ints[(i + 2) % n], ints[(i + 3) % n]);
+        keep(r);
+    });
+}
+
+
+//------------------------------------------------------------------------------
+// str_format
+//
+
+static void bench_str_format()
+{
+    size_t const n = 4096;
+    size_t const iterations = 2000000;
+
+    mt19937_64 rng(42);
+    vector<int> ints(n);
+    for(auto& v : ints) v = int(rng() >> (32 + rng() % 32));
+
+    rcstring user = ntba("some_user_name");
+    rcstring path = ntba("/api/v1/objects/12345/attributes");
+
+    bench("str_format/log_line/str_format", iterations, [&](size_t i) {
+        char buf[256];
+        auto r = str_format(buf, ADV_FMT("user={} path={} status={} bytes={} id={:x}"), user, path, 200, ints[i % n], i);
+        keep(r);
+    });
+
+    bench("str_format/log_line/str_printf", iterations, [&](size_t i) {
+        char buf[256];
+        auto r = common::str_printf(buf, "user=%.*s path=%.*s status=%d bytes=%d id=%zx", (int)user.len, user.p, (int)path.len, path.p, 200, ints[i % n], i);
+        keep(r);
+    });
+
+    bench("str_format/log_line/str_aprintf", iterations, [&](size_t i) {
+        static string s;
+        s.clear();
+        auto r = common::str_aprintf(s, "user=%.*s path=%.*s status=%d bytes=%d", (int)user.len, user.p, (int)path.len, path.p, 200, ints[i % n]);
+        keep(r);
+    });
+
+    bench("str_format/log_line/probe+snprintf", iterations, [&](size_t i) {
+        static string s;
+        s.clear();
+        int len = snprintf(nullptr, 0, "user=%.*s path=%.*s status=%d bytes=%d", (int)user.len, user.p, (int)path.len, path.p, 200, ints[i % n]);
+        s.resize(len + 1);
+        snprintf(&s[0], len + 1, "user=%.*s path=%.*s status=%d bytes=%d", (int)user.len, user.p, (int)path.len, path.p, 200, ints[i % n]);
+        s.resize(len);
+        keep(s);
+    });
+}
+
+
+//------------------------------------------------------------------------------
+// iovec_builder
+//
+
+static void bench_iovec()
+{
+#ifdef PARRAY_IOVEC_HAS_WRITEV
+    size_t const iterations = 500000;
+
+    int fd = open("/dev/null", O_WRONLY);
+    if (fd < 0) return;
+
+    rcstring user = ntba("some_user_name");
+    rcstring path = ntba("/api/v1/objects/12345/attributes");
+    deque<rcstring> tags = {ntba("alpha"), ntba("beta"), ntba("gamma"), ntba("delta")};
+
+    iovec_builder b;
+    bench("iovec/log_line/iovec_builder+writev", iterations, [&](size_t i) {
+        b.append(ntba("user=")).append(user).append(ntba(" path=")).append(path).append(ntba(" id=")).append_int(i);
+        b.append(ntba(" tags=")).join(begin(tags), end(tags), ',').append(ntba("\n"));
+        keep(b.flush(fd));
+    });
+
+    bench("iovec/log_line/join+str_printf+write", iterations, [&](size_t i) {
+        string t = join<string>(begin(tags), end(tags), ',');
+        char buf[512];
+        size_t len = common::str_printf(buf, "user=%.*s path=%.*s id=%zu tags=%s\n", (int)user.len, user.p, (int)path.len, path.p, i, t.c_str());
+        keep(write(fd, buf, len));
+    });
+
+    close(fd);
+#endif
+}
+
+
+//------------------------------------------------------------------------------
+// ntbs_len
+//
+
+static void bench_ntbs_len()
+{
+    size_t const iterations = 2000000;
+
+    for(size_t len : {16, 256})
+    {
+        vector<char> s(len, 'x');
+        s.push_back('\0');
+        vector<char16_t> s16(len, u'x');
+        s16.push_back(0);
+
+        char const volatile* vp = s.data();
+        char16_t const* p16 = s16.data();
+
+        string name = "ntbs_len/" + to_string(len);
+
+        bench((name + "/volatile char/scalar").c_str(), iterations, [&](size_t) {
+            keep(parray_traits::ntbs_len(vp));
+        });
+
+        bench((name + "/volatile char/parray_wide_traits").c_str(), iterations, [&](size_t) {
+            keep(parray_wide_traits::ntbs_len(vp));
+        });
+
+        bench((name + "/char16_t/ntbs_len").c_str(), iterations, [&](size_t) {
+            keep(parray_traits::ntbs_len(p16));
+        });
+
+        bench((name + "/char16_t/char_traits").c_str(), iterations, [&](size_t) {
+            keep(char_traits<char16_t>::length(p16));
+        });
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// ntbs vs parray comparisons
+//
+
+// exposes element-at-a-time algorithms for comparison
+struct scalar_ntbs_traits : parray_traits
+{
+    using parray_traits::ntbs_ar_eq;
+    using parray_traits::ntbs_ar_lt;
+};
+
+static void bench_ntbs_cmp()
+{
+    size_t const n = 1024;
+    size_t const iterations = 2000000;
+
+    for(size_t len : {12, 40, 200})
+    {
+        // C-API strings vs keys of same length sharing long prefix (worst case for both algorithms)
+        mt19937_64 rng(42);
+        vector<string> cstrs(n), keys(n);
+        for(size_t i = 0; i < n; ++i)
+        {
+            keys[i] = string(len, 'k');
+            keys[i].back() = char('a' + rng() % 26);
+            cstrs[i] = string(len, 'k');
+            cstrs[i].back() = char('a' + rng() % 26);
+        }
+
+        vector<rcstring> key_views;
+        for(auto& s : keys) key_views.push_back(rcstring(s));
+
+        string name = "ntbs_cmp/" + to_string(len);
+
+        bench((name + "/eq/chunked").c_str(), iterations, [&](size_t i) {
+            keep(key_views[i % n] == ntbs(cstrs[i % n].c_str()));
+        });
+
+        bench((name + "/eq/scalar").c_str(), iterations, [&](size_t i) {
+            keep(scalar_ntbs_traits::ntbs_ar_eq(key_views[i % n].len, key_views[i % n].p, cstrs[i % n].c_str()));
+        });
+
+        bench((name + "/eq/strlen+eq").c_str(), iterations, [&](size_t i) {
+            keep(key_views[i % n] == rcstring(ntbs(cstrs[i % n].c_str())));
+        });
+
+        bench((name + "/lt/chunked").c_str(), iterations, [&](size_t i) {
+            keep(key_views[i % n] < ntbs(cstrs[i % n].c_str()));
+        });
+
+        bench((name + "/lt/scalar").c_str(), iterations, [&](size_t i) {
+            keep(scalar_ntbs_traits::ntbs_ar_lt(key_views[i % n].len, key_views[i % n].p, cstrs[i % n].c_str()));
+        });
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// ntbs_cached -- one C-API string looked up in a table of keys
+//
+
+static void bench_ntbs_cached()
+{
+    size_t const n = 64;
+    size_t const iterations = 200000;
+
+    mt19937_64 rng(42);
+    vector<string> keys(n);
+    for(auto& k : keys) k = string(8 + rng() % 32, char('a' + rng() % 26));
+    vector<rcstring> key_views;
+    for(auto& k : keys) key_views.push_back(rcstring(k));
+
+    string cstr(24, 'q');
+
+    bench("ntbs_cached/lookup64/ntbs", iterations, [&](size_t) {
+        auto s = ntbs(cstr.c_str());
+        size_t found = 0;
+        for(rcstring k : key_views) found += (k == s);
+        keep(found);
+    });
+
+    bench("ntbs_cached/lookup64/ntbs_cached", iterations, [&](size_t) {
+        auto s = ntbs_cached(cstr.c_str());
+        size_t found = 0;
+        for(rcstring k : key_views) found += (k == s);
+        keep(found);
+    });
+}
+
+
+//------------------------------------------------------------------------------
+// parray_flat_set/map lookups
+//
+
+static void bench_flat_map()
+{
+    size_t const n = 1000;
+    size_t const iterations = 2000000;
+
+    // identifiers of various lengths, half of the queries miss
+    mt19937_64 rng(42);
+    vector<string> keys, queries;
+    for(size_t i = 0; i < 2*n; ++i)
+    {
+        string s(4 + rng() % 20, ' ');
+        for(auto& c : s) c = char('a' + rng() % 26);
+        (i % 2 ? queries : keys).push_back(s);
+    }
+    for(size_t i = 0; i < n; i += 2) queries[i] = keys[(i * 7) % n];
+
+    vector<rcstring> qviews;
+    for(auto& q : queries) qviews.push_back(rcstring(q));
+
+    parray_flat_set<char> fs(keys.begin(), keys.end());
+    std::set<rcstring> ss;
+    for(auto& k : keys) ss.insert(rcstring(k));
+
+    bench("flat_map/lookup1000/parray_flat_set", iterations, [&](size_t i) {
+        keep(fs.contains(qviews[i % n]));
+    });
+
+    bench("flat_map/lookup1000/std::set<rcstring>", iterations, [&](size_t i) {
+        keep(ss.count(qviews[i % n]));
+    });
+
+    vector<pair<string, int>> kv;
+    for(size_t i = 0; i < n; ++i) kv.emplace_back(keys[i], int(i));
+    parray_flat_map<char, int> fm(kv.begin(), kv.end());
+    std::map<string, int> sm(kv.begin(), kv.end());
+
+    bench("flat_map/lookup1000/parray_flat_map", iterations, [&](size_t i) {
+        int const* v = fm.find(qviews[i % n]);
+        keep(v ? *v : 0);
+    });
+
+    bench("flat_map/lookup1000/std::map<string>", iterations, [&](size_t i) {
+        auto it = sm.find(queries[i % n]);
+        keep(it != sm.end() ? it->second : 0);
+    });
+}
+
+
+//------------------------------------------------------------------------------
+// string_table lookups (in-memory image)
+//
+
+static void bench_string_table()
+{
+    size_t const n = 100000;
+    size_t const iterations = 1000000;
+
+    mt19937_64 rng(42);
+    vector<string> keys;
+    for(size_t i = 0; i < n; ++i) keys.push_back("dict/word/" + to_string(rng() % (4*n)));
+
+    vector<rcstring> queries;
+    for(size_t i = 0; i < 4096; ++i) queries.push_back(rcstring(keys[rng() % n]));
+
+    string_table_builder b;
+    for(auto& k : keys) b.add(rcstring(k));
+
+    for(size_t restart : {0, 16})
+    {
+        vector<char> image;
+        b.write(image, restart);
+
+        string_table t;
+        t.attach(rcstring(image.size(), image.data()));
+
+        string name = "string_table/lookup100k/restart=" + to_string(restart) + " (" + to_string(image.size() / 1024) + " KiB)";
+        bench(name.c_str(), iterations, [&](size_t i) {
+            keep(t.find(queries[i % queries.size()]));
+        });
+    }
+
+    std::set<rcstring> ss;
+    for(auto& k : keys) ss.insert(rcstring(k));
+    bench("string_table/lookup100k/std::set<rcstring>", iterations, [&](size_t i) {
+        keep(ss.count(queries[i % queries.size()]));
+    });
+}
+
+
+//------------------------------------------------------------------------------
+// sorting of key vectors (100M keys only if PARRAY_BENCH_LARGE is set -- needs few GB of memory)
+//
+
+// n keys in one blob: identifiers with shared prefixes (e.g. "user:12345:q"), numbers are in [0, range)
+static vector<rcstring> make_keys(size_t n, size_t range, string& blob)
+{
+    mt19937_64 rng(42);
+    vector<pair<size_t, size_t>> pos;
+    char buf[64];
+    for(size_t i = 0; i < n; ++i)
+    {
+        size_t len = common::str_printf(buf, "%s:%llu:%c", (rng() % 2) ? "user" : "session", (unsigned long long)(rng() % range), char('a' + rng() % 26));
+        pos.emplace_back(blob.size(), len);
+        blob.append(buf, len);
+    }
+
+    vector<rcstring> keys;
+    keys.reserve(n);
+    for(auto& p : pos) keys.push_back(rcstring(p.second, blob.data() + p.first));
+    return keys;
+}
+
+static void bench_sort()
+{
+    vector<size_t> sizes = {1000000, 10000000};
+    if (getenv("PARRAY_BENCH_LARGE")) sizes.push_back(100000000);
+
+    for(size_t n : sizes)
+    {
+        string name = "sort/" + to_string(n / 1000000) + "M";
+        if (!wanted({name + "/copy only", name + "/std::sort", name + "/sort_parrays", name + "/std::stable_sort", name + "/stable_sort_parrays"}))
+            continue;
+
+        string blob;
+        vector<rcstring> keys = make_keys(n, n * 4, blob);
+
+        vector<rcstring> work(n);
+        size_t const iterations = 1;
+
+        bench((name + "/copy only").c_str(), iterations, [&](size_t) {
+            work = keys;
+            keep(work);
+        });
+
+        bench((name + "/std::sort").c_str(), iterations, [&](size_t) {
+            work = keys;
+            std::sort(work.begin(), work.end());
+            keep(work);
+        });
+
+        bench((name + "/sort_parrays").c_str(), iterations, [&](size_t) {
+            work = keys;
+            sort_parrays(work.begin(), work.end());
+            keep(work);
+        });
+
+        bench((name + "/std::stable_sort").c_str(), iterations, [&](size_t) {
+            work = keys;
+            std::stable_sort(work.begin(), work.end());
+            keep(work);
+        });
+
+        bench((name + "/stable_sort_parrays").c_str(), iterations, [&](size_t) {
+            work = keys;
+            stable_sort_parrays(work.begin(), work.end());
+            keep(work);
+        });
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// parallel_sort_unique scaling (10M keys, ~40% duplicates)
+//
+
+static void bench_parallel_sort()
+{
+    size_t const n = 10000000;
+    if (!wanted({"parallel_sort/10M/std::sort+unique", "parallel_sort/10M/threads=1", "parallel_sort/10M/threads=2", "parallel_sort/10M/threads=4", "parallel_sort/10M/threads=8"}))
+        return;
+
+    string blob;
+    vector<rcstring> keys = make_keys(n, n / 8, blob);
+    vector<rcstring> work;
+
+    bench("parallel_sort/10M/std::sort+unique", 1, [&](size_t) {
+        work = keys;
+        std::sort(work.begin(), work.end());
+        work.erase(std::unique(work.begin(), work.end()), work.end());
+        keep(work);
+    });
+
+    for(unsigned threads : {1, 2, 4, 8})
+    {
+        string name = "parallel_sort/10M/threads=" + to_string(threads);
+        bench(name.c_str(), 1, [&](size_t) {
+            work = keys;
+            parallel_sort_unique(work, threads);
+            keep(work);
+        });
+    }
+
+    if (!g_json) printf("(hardware concurrency: %u)\n", std::thread::hardware_concurrency());
+}
+
+
+//------------------------------------------------------------------------------
+// lexicographical vs length-first order
+//
+
+static void bench_lex()
+{
+    size_t const n = 1000000;
+    if (!wanted({"lex/sort/1M/length-first std::sort", "lex/sort/1M/lexicographical std::sort", "lex/lookup/1M/length-first lower_bound",
+                 "lex/lookup/1M/lexicographical lower_bound", "lex/ntbs_lt/40/length-first", "lex/ntbs_lt/40/lexicographical"}))
+        return;
+
+    using lex_string = parray<char const, parray_lex_traits>;
+
+    string blob;
+    vector<rcstring> keys = make_keys(n, n * 4, blob);
+    vector<lex_string> lex_keys;
+    for(rcstring k : keys) lex_keys.push_back(lex_string(k));
+
+    vector<rcstring> work;
+    vector<lex_string> lex_work;
+
+    bench("lex/sort/1M/length-first std::sort", 1, [&](size_t) {
+        work = keys;
+        std::sort(work.begin(), work.end());
+        keep(work);
+    });
+
+    bench("lex/sort/1M/lexicographical std::sort", 1, [&](size_t) {
+        lex_work = lex_keys;
+        std::sort(lex_work.begin(), lex_work.end());
+        keep(lex_work);
+    });
+
+    work = keys;
+    std::sort(work.begin(), work.end());
+    lex_work = lex_keys;
+    std::sort(lex_work.begin(), lex_work.end());
+
+    bench("lex/lookup/1M/length-first lower_bound", 1000000, [&](size_t i) {
+        keep(std::lower_bound(work.begin(), work.end(), keys[(i * 7919) % n]));
+    });
+
+    bench("lex/lookup/1M/lexicographical lower_bound", 1000000, [&](size_t i) {
+        keep(std::lower_bound(lex_work.begin(), lex_work.end(), lex_keys[(i * 7919) % n]));
+    });
+
+    // array vs ntbs, strings that differ only at the end
+    string a(40, 'x'), b(40, 'x');
+    b.back() = 'y';
+    rcstring ra(a);
+    lex_string la(ra);
+
+    bench("lex/ntbs_lt/40/length-first", 10000000, [&](size_t) {
+        keep(ra < ntbs(b.c_str()));
+    });
+
+    bench("lex/ntbs_lt/40/lexicographical", 10000000, [&](size_t) {
+        keep(la < ntbs<parray_lex_traits>(b.c_str()));
+    });
+}
+
+
+//------------------------------------------------------------------------------
+// case-insensitive header names -- lowercased copies vs parray_icase_traits
+//
+
+static string lowercase(rcstring v)
+{
+    string s(v.p, v.len);
+    for(auto& c : s) if (c >= 'A' && c <= 'Z') c += 'a' - 'A';
+    return s;
+}
+
+static void bench_icase()
+{
+    using icase_string = parray<char const, parray_icase_traits>;
+
+    // header names as they come from the wire (mixed case) and known names in canonical case
+    vector<string> known = { "Accept", "Accept-Encoding", "Accept-Language", "Authorization", "Cache-Control", "Connection",
+                             "Content-Encoding", "Content-Length", "Content-Type", "Cookie", "Host", "If-Modified-Since",
+                             "If-None-Match", "Referer", "Transfer-Encoding", "User-Agent", "X-Forwarded-For", "X-Request-Id" };
+    vector<string> wire;
+    mt19937_64 rng(42);
+    for(size_t i = 0; i < 1024; ++i)
+    {
+        string s = known[rng() % known.size()];
+        for(auto& c : s) if (rng() % 2) c = char(toupper(c)); else c = char(tolower(c));
+        wire.push_back(s);
+    }
+    size_t const n = wire.size();
+
+    bench("icase/eq/lowercase copies", 2000000, [&](size_t i) {
+        keep(lowercase(rcstring(wire[i % n])) == lowercase(rcstring(known[i % known.size()])));
+    });
+
+    bench("icase/eq/parray_icase_traits", 2000000, [&](size_t i) {
+        keep(icase_string(rcstring(wire[i % n])) == icase_string(rcstring(known[i % known.size()])));
+    });
+
+    string a(200, 'x'), b(200, 'X');
+    bench("icase/eq/200/lowercase copies", 2000000, [&](size_t) {
+        keep(lowercase(rcstring(a)) == lowercase(rcstring(b)));
+    });
+
+    bench("icase/eq/200/parray_icase_traits", 2000000, [&](size_t) {
+        keep(icase_string(rcstring(a)) == icase_string(rcstring(b)));
+    });
+
+    unordered_map<string, int> m1;
+    unordered_map<icase_string, int> m2;
+    for(size_t i = 0; i < known.size(); ++i)
+    {
+        m1[lowercase(rcstring(known[i]))] = int(i);
+        m2[icase_string(rcstring(known[i]))] = int(i);
+    }
+
+    bench("icase/unordered_map/lowercase copies", 2000000, [&](size_t i) {
+        keep(m1.find(lowercase(rcstring(wire[i % n]))));
+    });
+
+    bench("icase/unordered_map/parray_icase_traits", 2000000, [&](size_t i) {
+        keep(m2.find(icase_string(rcstring(wire[i % n]))));
+    });
+}
+
+
+//------------------------------------------------------------------------------
+// timing of MAC comparison depending on position of first mismatch -- parray_traits (memcmp, exits early) should
+// get faster as mismatch moves to the front, parray_ct_traits should not change
+//
+
+static void bench_ct()
+{
+    using secret = parray<unsigned char const, parray_ct_traits>;
+
+    for(size_t len : {32, 4096})
+    {
+        mt19937_64 rng(42);
+        vector<unsigned char> mac(len);
+        for(auto& c : mac) c = static_cast<unsigned char>(rng());
+
+        // candidates: equal, mismatch at the start, in the middle, at the end
+        vector<unsigned char> cand[4] = { mac, mac, mac, mac };
+        cand[1][0] ^= 1;
+        cand[2][len/2] ^= 1;
+        cand[3][len - 1] ^= 1;
+        char const* pos[4] = { "equal", "diff@0", "diff@mid", "diff@end" };
+
+        size_t const iterations = (len < 100) ? 20000000 : 1000000;
+        for(size_t k = 0; k < 4; ++k)
+        {
+            rcbytes a(mac), b(cand[k]);
+            string name = "ct/" + to_string(len) + "/" + pos[k];
+
+            bench((name + "/parray_traits").c_str(), iterations, [&](size_t) {
+                keep(a == b);
+            });
+
+            bench((name + "/parray_ct_traits").c_str(), iterations, [&](size_t) {
+                keep(secret(a) == secret(b));
+            });
+        }
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// owning keys -- building key from fragments and comparing it against stored keys
+//
+
+static void bench_owned()
+{
+    rcstring parts[] = { ntba("user:"), ntba("12345"), ntba(":session:"), ntba("abcdef") };
+    size_t const iterations = 5000000;
+
+    bench("owned/build/std::string", iterations, [&](size_t) {
+        string k;
+        for(rcstring v : parts) k.append(v.p, v.len);
+        keep(k);
+    });
+
+    bench("owned/build/owned_parray", iterations, [&](size_t) {
+        owned_parray<char> k;
+        for(rcstring v : parts) k.append(v);
+        keep(k);
+    });
+
+    bench("owned/build/fixed_string<32>", iterations, [&](size_t) {
+        fixed_string<32> k;
+        for(rcstring v : parts) k.append(v);
+        keep(k);
+    });
+
+    // comparisons against a table of keys of different lengths
+    vector<string> s_keys;
+    vector<owned_parray<char>> o_keys;
+    vector<fixed_string<32>> f_keys;
+    for(size_t i = 0; i < 64; ++i)
+    {
+        string k = "user:" + to_string(i * 7919) + ":session:" + string(i % 9, 'x');
+        s_keys.push_back(k);
+        o_keys.emplace_back(rcstring(k));
+        f_keys.emplace_back(rcstring(k));
+    }
+    string q = "user:12345:session:abcdef";
+    rcstring rq(q);
+
+    bench("owned/lookup64/std::string", iterations / 10, [&](size_t) {
+        size_t found = 0;
+        for(auto& k : s_keys) found += (k == q);
+        keep(found);
+    });
+
+    bench("owned/lookup64/owned_parray", iterations / 10, [&](size_t) {
+        size_t found = 0;
+        for(auto& k : o_keys) found += (k == rq);
+        keep(found);
+    });
+
+    bench("owned/lookup64/fixed_string<32>", iterations / 10, [&](size_t) {
+        size_t found = 0;
+        for(auto& k : f_keys) found += (k == rq);
+        keep(found);
+    });
+}
+
+
+//------------------------------------------------------------------------------
+// shared_slice refcount cost -- every thread keeps copying slices of the same buffer (all of them hit one counter)
+//
+
+static void bench_shared()
+{
+    size_t const iterations = 2000000;
+    if (!wanted({"shared/fan-out/threads=1", "shared/fan-out/threads=2", "shared/fan-out/threads=4", "shared/fan-out/threads=8",
+                 "shared/copy/shared_slice", "shared/copy/shared_ptr<string>+rcstring"}))
+        return;
+
+    string msg(1 << 20, 'm');
+    shared_buffer<char> buf{ rcstring(msg) };
+    shared_slice<char> root = buf.slice();
+    auto sp = make_shared<string>(msg);
+
+    // fan-out: same number of copies split between threads (all of them hit one counter), time per copy
+    for(unsigned threads : {1, 2, 4, 8})
+    {
+        string name = "shared/fan-out/threads=" + to_string(threads);
+        if (g_filter && !strstr(name.c_str(), g_filter)) continue;
+
+        auto t0 = chrono::steady_clock::now();
+        vector<thread> ts;
+        for(unsigned t = 0; t < threads; ++t)
+            ts.emplace_back([&root, threads]() {
+                for(size_t i = 0; i < iterations / threads; ++i)
+                {
+                    shared_slice<char> s = root.mid(i % 1000, 16);
+                    keep(s);
+                }
+            });
+        for(auto& t : ts) t.join();
+        auto t1 = chrono::steady_clock::now();
+
+        report(name.c_str(), iterations, chrono::duration<double, nano>(t1 - t0).count());
+    }
+
+    // single thread (run after threads were started -- otherwise shared_ptr may skip atomic operations)
+    bench("shared/copy/shared_slice", iterations, [&](size_t i) {
+        shared_slice<char> s = root.mid(i % 1000, 16);
+        keep(s);
+    });
+
+    bench("shared/copy/shared_ptr<string>+rcstring", iterations, [&](size_t i) {
+        pair<shared_ptr<string>, rcstring> s{ sp, rcstring(16, sp->data() + i % 1000) };
+        keep(s);
+    });
+
+    if (!g_json) printf("(hardware concurrency: %u)\n", std::thread::hardware_concurrency());
+}
+
+
+//------------------------------------------------------------------------------
+// templating output -- thousands of fragments, only length and a prefix are needed
+//
+
+static void bench_rope()
+{
+    size_t const n = 5000;
+    mt19937_64 rng(42);
+    string blob(4096, 'x');
+    vector<rcstring> frags;
+    for(size_t i = 0; i < n; ++i) frags.push_back(rcstring(1 + rng() % 30, blob.data() + rng() % 4000));
+
+    bench("rope/5000/std::string append + size + prefix", 2000, [&](size_t) {
+        string s;
+        for(rcstring v : frags) s.append(v.p, v.len);
+        keep(s.size());
+        keep(s.substr(0, 64));
+    });
+
+    bench("rope/5000/join() + size + prefix", 2000, [&](size_t) {
+        string s = join_se<string>(frags.begin(), frags.end(), rcstring{});
+        keep(s.size());
+        keep(s.substr(0, 64));
+    });
+
+    parray_rope<char> r;
+    bench("rope/5000/parray_rope append + size + prefix", 2000, [&](size_t) {
+        r.clear();
+        for(rcstring v : frags) r.append(v);
+        char prefix[64];
+        keep(r.size());
+        keep(r.copy_to(prefix, sizeof(prefix)));
+    });
+
+    r.clear();
+    for(rcstring v : frags) r.append(v);
+
+    bench("rope/5000/parray_rope index", 2000000, [&](size_t i) {
+        keep(r[(i * 7919) % r.size()]);
+    });
+
+    vector<char> out(r.size());
+    bench("rope/5000/parray_rope flatten", 2000, [&](size_t) {
+        r.flatten(out.data());
+        keep(out);
+    });
+}
+
+
+//------------------------------------------------------------------------------
+static void bench_concat()
+{
+    // "host.tld" keys looked up among many candidates; half share length with the key
+    size_t const n = 1000;
+    mt19937_64 rng(42);
+    vector<string> keys;
+    for(size_t i = 0; i < n; ++i)
+    {
+        string k(8 + rng() % 3, 'a');
+        for(auto& c : k) c = char('a' + rng() % 4);
+        keys.push_back(k);
+    }
+    string host = "abcd", tld = "cda";
+
+    bench("concat/1000/std::string + then ==", 20000, [&](size_t i) {
+        string s = host + "." + tld;
+        keep(s == keys[i % n]);
+    });
+
+    bench("concat/1000/concat_view ==", 20000, [&](size_t i) {
+        keep(concat(rcstring(host), ntba("."), rcstring(tld)) == rcstring(keys[i % n]));
+    });
+
+    bench("concat/1000/std::string + then hash", 20000, [&](size_t) {
+        string s = host + "." + tld;
+        keep(parray_traits::hash(s.size(), s.data()));
+    });
+
+    bench("concat/1000/concat_view hash", 20000, [&](size_t) {
+        keep(concat(rcstring(host), ntba("."), rcstring(tld)).hash());
+    });
+}
+
+
+//------------------------------------------------------------------------------
+static void bench_utf()
+{
+    // 64KB of mostly ASCII text (1 in 40 characters is multibyte) and of CJK text
+    mt19937_64 rng(42);
+    string ascii, cjk;
+    while(ascii.size() < 65536)
+    {
+        if (rng() % 40) ascii += char('a' + rng() % 26);
+        else ascii += "\xC3\xA9";
+    }
+    while(cjk.size() < 65536)
+    {
+        char32_t cp = 0x4E00 + rng() % 0x5000;
+        char buf[4];
+        cjk.append(buf, buf + utf32_to_utf8(parray<char32_t const>(1, &cp), buf, 4).value.len);
+    }
+
+    vector<char16_t> out(65536);
+    wstring_convert<codecvt_utf8_utf16<char16_t>, char16_t> conv;
+
+    for(auto* text : { &ascii, &cjk })
+    {
+        string prefix = string("utf/64KB ") + (text == &ascii ? "ascii" : "cjk");
+        rcstring v(*text);
+
+        bench((prefix + "/utf8_valid").c_str(), 2000, [&](size_t) {
+            keep(utf8_valid(v));
+        });
+
+        bench((prefix + "/utf8_to_utf16").c_str(), 1000, [&](size_t) {
+            keep(utf8_to_utf16(v, out.data(), out.size()));
+        });
+
+        bench((prefix + "/wstring_convert from_bytes").c_str(), 100, [&](size_t) {
+            keep(conv.from_bytes(text->data(), text->data() + text->size()));
+        });
+    }
+}
+
+
+//------------------------------------------------------------------------------
+static void bench_wide_split()
+{
+    // 32K UTF-16 code units, fields of ~40 units separated by U+3001 or ','
+    mt19937_64 rng(42);
+    u16string text;
+    while(text.size() < 32768)
+    {
+        for(size_t n = 20 + rng() % 40; n; --n) text += char16_t(0x4E00 + rng() % 0x5000);
+        text += (rng() % 2) ? char16_t(0x3001) : u',';
+    }
+    parray<char16_t const> v(text.size(), text.data());
+    auto count = [](parray<char16_t const> x) { keep(x); return false; };
+
+    bench("wide_split/32K/std::find loop", 500, [&](size_t) {
+        size_t n = 0;
+        for(auto p = text.begin(); (p = find(p, text.end(), char16_t(0x3001))) != text.end(); ++p) ++n;
+        keep(n);
+    });
+
+    bench("wide_split/32K/split(single value)", 500, [&](size_t) {
+        split(v, char16_t(0x3001), count);
+    });
+
+    char16_t const d[] = { u',', 0x3001, 0xFF0C };
+    parray<char16_t const> delims(3, d);
+    bench("wide_split/32K/std::find_first_of loop", 500, [&](size_t) {
+        size_t n = 0;
+        for(auto p = text.begin(); (p = find_first_of(p, text.end(), d, d + 3)) != text.end(); ++p) ++n;
+        keep(n);
+    });
+
+    bench("wide_split/32K/split(3 values)", 500, [&](size_t) {
+        split(v, delims, count);
+    });
+
+    bitset_delim<char16_t> bd(delims);
+    bench("wide_split/32K/split(bitset_delim, 8KB)", 500, [&](size_t) {
+        split(v, bd, count);
+    });
+
+    sparse_bitset_delim<char16_t> sd(delims);
+    bench("wide_split/32K/split(sparse_bitset_delim)", 500, [&](size_t) {
+        split(v, sd, count);
+    });
+}
+
+
+//------------------------------------------------------------------------------
+static void bench_stats()
+{
+    using counted_string = parray<char const, parray_counting_traits<>>;
+
+    size_t const n = 4096;
+    auto keys = make_keys(n);
+    vector<string> keys2(keys);
+    vector<rcstring> views, views2;
+    vector<counted_string> cviews, cviews2;
+    for(size_t i = 0; i < n; ++i)
+    {
+        views.push_back(rcstring(keys[i]));
+        views2.push_back(rcstring(keys2[i]));
+        cviews.emplace_back(views[i].len, views[i].p);
+        cviews2.emplace_back(views2[i].len, views2[i].p);
+    }
+
+    // overhead of instrumentation
+    bench("stats/==/random/rcstring", 4000000, [&](size_t i) { keep(views[i % n] == views2[(i + 1) % n]); });
+    bench("stats/==/random/counted", 4000000, [&](size_t i) { keep(cviews[i % n] == cviews2[(i + 1) % n]); });
+    bench("stats/</random/rcstring", 4000000, [&](size_t i) { keep(views[i % n] < views2[(i + 1) % n]); });
+    bench("stats/</random/counted", 4000000, [&](size_t i) { keep(cviews[i % n] < cviews2[(i + 1) % n]); });
+
+    // how comparisons of typical workload (sort + lookups) were decided
+    if (g_json || !wanted({"stats/sort+lookups"})) return;
+
+    parray_counting_traits<>::reset();
+    vector<counted_string> sorted(cviews);
+    std::sort(sorted.begin(), sorted.end());
+    for(size_t i = 0; i < n; ++i) keep(std::binary_search(sorted.begin(), sorted.end(), cviews2[i]));
+
+    parray_cmp_stats s = parray_counting_traits<>::stats();
+    printf("stats/sort+lookups: %zu keys, %llu comparisons, %.1f%% decided by length, %.1f%% by pointer, avg %.1f bytes per scan\n",
+           n, (unsigned long long)s.calls(), 100.0 * s.by_length / s.calls(), 100.0 * s.by_same_ptr / s.calls(),
+           s.scanned ? double(s.bytes_scanned) / s.scanned : 0.0);
+}
+
+
+//------------------------------------------------------------------------------
+static void bench_dispatch()
+{
+    // equal 1KB buffers (worst case for comparison) and 64KB of CSV text
+    string a(1024, 'x'), b(a);
+    string text;
+    for(auto& line : make_csv(1000)) { text += line; text += '\n'; }
+    auto pa = reinterpret_cast<unsigned char const*>(a.data());
+    auto pb = reinterpret_cast<unsigned char const*>(b.data());
+    auto pt = reinterpret_cast<unsigned char const*>(text.data());
+    unsigned char const set[] = { ',', ';', '\n' };
+
+    bench("dispatch/mismatch/1K/memcmp", 200000, [&](size_t) { keep(memcmp(pa, pb, a.size())); });
+    bench("dispatch/find_any/csv/std::find_first_of", 200, [&](size_t) {
+        size_t n = 0;
+        for(auto p = pt, p_end = pt + text.size(); (p = find_first_of(p, p_end, set, set + 3)) != p_end; ++p) ++n;
+        keep(n);
+    });
+
+    for(isa_level l : { isa_level::scalar, isa_level::sse2, isa_level::avx2, isa_level::avx512 })
+    {
+        if (l > detected_isa()) continue;
+        byte_kernels const& k = kernels(l);
+        string prefix = string("dispatch/") + isa_name(l);
+
+        bench((prefix + "/mismatch/1K").c_str(), 200000, [&](size_t) { keep(k.mismatch(a.size(), pa, pb)); });
+        bench((prefix + "/find_any/csv").c_str(), 200, [&](size_t) {
+            size_t n = 0;
+            for(size_t i = 0, len = text.size(); (i += k.find_any(len - i, pt + i, set, 3)) < len; ++i) ++n;
+            keep(n);
+        });
+    }
+
+    if (!g_json && wanted({"dispatch/"})) printf("(detected: %s, active: %s)\n", isa_name(detected_isa()), isa_name(active_isa()));
+}
+
+
+//------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    for(int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--json")) g_json = true;
+        else g_filter = argv[i];
+    }
+
+    bench_compare();
+    bench_split();
+    bench_join();
+    bench_contains();
+    bench_trim();
+
+    bench_parse();
+    bench_format();
+    bench_str_format();
+    bench_iovec();
+    bench_ntbs_len();
+    bench_ntbs_cmp();
+    bench_ntbs_cached();
+    bench_flat_map();
+    bench_string_table();
+    bench_sort();
+    bench_parallel_sort();
+    bench_lex();
+    bench_icase();
+    bench_ct();
+    bench_owned();
+    bench_shared();
+    bench_rope();
+    bench_concat();
+    bench_utf();
+    bench_wide_split();
+    bench_stats();
+    bench_dispatch();
+
+    if (g_json) print_json();
+    return 0;
+}
@@ -0,0 +1,241 @@
+/*/////////////////////////////////////////////////////////////////////////////
+    ADV library
+
+  Author:
+    Michael Kilburn
+
+/////////////////////////////////////////////////////////////////////////////*/
+
+
+#ifndef PARRAY_CONCAT_H_2026_10_18_18_55_12_381_H_
+#define PARRAY_CONCAT_H_2026_10_18_18_55_12_381_H_
+
+
+#include "parray.h"
+#include <type_traits>
+#include <algorithm>
+#include <string>
+#include <functional>
+#include <ostream>
+
+
+//------------------------------------------------------------------------------
+// concat_view<T, Traits, N>
+//
+//  Concatenation of N arrays that is compared and hashed as if it was one array, without building it:
+//
+//      if (concat(prefix, ntba("."), suffix) == key) ...       // instead of join<string>(...) == key
+//
+//  Comparisons use trait's rules -- total length is compared first, then pieces are compared segment by segment
+// against the other side (parray, ntbs, std::string or another concat_view). Hash is the same as Traits::hash() of
+// concatenated array (Traits::hash() is chained over pieces).
+//
+//  concat(a, b, ...)               -- view of a + b + ... (all arrays have to have same trait)
+//  size(), empty()                 -- total length
+//  piece(i), pieces()              -- i-th piece, number of pieces
+//  for_each(f)                     -- f(parray v) for every piece
+//  copy_to(buf)                    -- copy concatenation into buf (has to have room for size() elements)
+//  str()                           -- concatenation as basic_string
+//  hash()                          -- same value as Traits::hash() of concatenation
+//
+// Notes:
+//  - pieces are borrowed, concat_view is as cheap to copy as N parrays
+//  - ordering (<, >, etc) is defined only for length-first traits (parray_traits and derived from it, except
+//    parray_lex_traits); equal-length segments are compared with Traits::eq()/Traits::lt()
+//  - comparison stops at first mismatching segment, i.e. parray_ct_traits comparisons lose constant-time property
+//
+
+
+//------------------------------------------------------------------------------
+namespace adv { namespace parray_concat_pvt_ {
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+using std::size_t;
+using std::basic_string;
+using std::char_traits;
+using std::allocator;
+using adv::parray;
+using adv::parray_traits;
+using adv::parray_pvt_::ntbs_t;
+
+template<class T> using remove_cv = std::remove_cv_t<T>;
+template<bool B, class T = void> using enable_if = std::enable_if_t<B, T>;
+
+template<class Traits> constexpr bool is_length_first = !std::is_base_of<adv::parray_lex_traits, Traits>::value;
+
+
+//------------------------------------------------------------------------------
+// 3-way comparison of two sequences of pieces with equal total length, segment by segment
+//
+template<class Traits, class A, class B>
+int seg_cmp(A const* a, size_t na, B const* b, size_t nb)
+{
+    size_t ia = 0, ib = 0, oa = 0, ob = 0;
+    for(;;)
+    {
+        while(ia < na && oa == a[ia].len) { ++ia; oa = 0; }     // skip exhausted (and empty) pieces
+        while(ib < nb && ob == b[ib].len) { ++ib; ob = 0; }
+        if (ia == na || ib == nb) return 0;
+
+        size_t n = std::min(a[ia].len - oa, b[ib].len - ob);
+        auto pa = a[ia].p + oa;
+        auto pb = b[ib].p + ob;
+        if (!Traits::eq(n, pa, n, pb)) return Traits::lt(n, pa, n, pb) ? -1 : 1;
+        oa += n;
+        ob += n;
+    }
+}
+
+
+//------------------------------------------------------------------------------
+template<class T, class Traits, size_t N>
+struct concat_view
+{
+    using piece_type = parray<T, Traits>;
+    using Tc = remove_cv<T>;
+
+private:
+    template<class, class, size_t> friend struct concat_view;
+
+    piece_type pieces_[N];
+    size_t len_;
+
+public:
+    template<class... P>
+    explicit concat_view(P... p) : pieces_{ p... }, len_(0) { for(piece_type const& v : pieces_) len_ += v.len; }
+
+    // content
+    size_t size() const                     { return len_; }
+    bool empty() const                      { return len_ == 0; }
+    static constexpr size_t pieces()        { return N; }
+    piece_type piece(size_t i) const        { return pieces_[i]; }
+
+    template<class F>
+    void for_each(F f) const                { for(piece_type const& v : pieces_) f(v); }
+
+    Tc* copy_to(Tc* buf) const              { for(piece_type const& v : pieces_) buf = std::copy(v.p, v.p + v.len, buf); return buf; }
+
+    template<class Tr = char_traits<Tc>, class A = allocator<Tc>>
+    basic_string<Tc, Tr, A> str() const
+    {
+        basic_string<Tc, Tr, A> r;
+        r.reserve(len_);
+        for(piece_type const& v : pieces_) r.append(v.p, v.len);
+        return r;
+    }
+
+    size_t hash() const
+    {
+        size_t h = Traits::hash_seed;
+        for(piece_type const& v : pieces_) h = Traits::hash(v.len, v.p, h);
+        return h;
+    }
+
+    // comparisons
+
+    template<class E, size_t M>
+    static int cmp_(concat_view const& l, concat_view<E, Traits, M> const& r)
+    {
+        if (l.len_ != r.len_) return (l.len_ < r.len_) ? -1 : 1;
+        return seg_cmp<Traits>(l.pieces_, N, r.pieces_, M);
+    }
+
+    template<class E>
+    static int cmp_(concat_view const& l, parray<E, Traits> r)
+    {
+        if (l.len_ != r.len) return (l.len_ < r.len) ? -1 : 1;
+        return seg_cmp<Traits>(l.pieces_, N, &r, 1);
+    }
+
+    template<class E>
+    static bool eq_(concat_view const& l, parray<E, Traits> r) { return l.len_ == r.len && seg_cmp<Traits>(l.pieces_, N, &r, 1) == 0; }
+
+    template<class E, size_t M>
+    static bool eq_(concat_view const& l, concat_view<E, Traits, M> const& r) { return l.len_ == r.len_ && seg_cmp<Traits>(l.pieces_, N, r.pieces_, M) == 0; }
+
+    // concat_view vs concat_view
+    template<class E, size_t M> friend bool operator==(concat_view const& l, concat_view<E, Traits, M> const& r) { return  eq_(l, r); }
+    template<class E, size_t M> friend bool operator!=(concat_view const& l, concat_view<E, Traits, M> const& r) { return !eq_(l, r); }
+    template<class E, size_t M, class Tr = Traits, enable_if<is_length_first<Tr>>...> friend bool operator< (concat_view const& l, concat_view<E, Traits, M> const& r) { return cmp_(l, r) <  0; }
+    template<class E, size_t M, class Tr = Traits, enable_if<is_length_first<Tr>>...> friend bool operator> (concat_view const& l, concat_view<E, Traits, M> const& r) { return cmp_(l, r) >  0; }
+    template<class E, size_t M, class Tr = Traits, enable_if<is_length_first<Tr>>...> friend bool operator<=(concat_view const& l, concat_view<E, Traits, M> const& r) { return cmp_(l, r) <= 0; }
+    template<class E, size_t M, class Tr = Traits, enable_if<is_length_first<Tr>>...> friend bool operator>=(concat_view const& l, concat_view<E, Traits, M> const& r) { return cmp_(l, r) >= 0; }
+
+    // concat_view vs parray<E, Traits>
+    template<class E> friend bool operator==(concat_view const& l, parray<E, Traits> r) { return  eq_(l, r); }
+    template<class E> friend bool operator!=(concat_view const& l, parray<E, Traits> r) { return !eq_(l, r); }
+    template<class E, class Tr = Traits, enable_if<is_length_first<Tr>>...> friend bool operator< (concat_view const& l, parray<E, Traits> r) { return cmp_(l, r) <  0; }
+    template<class E, class Tr = Traits, enable_if<is_length_first<Tr>>...> friend bool operator> (concat_view const& l, parray<E, Traits> r) { return cmp_(l, r) >  0; }
+    template<class E, class Tr = Traits, enable_if<is_length_first<Tr>>...> friend bool operator<=(concat_view const& l, parray<E, Traits> r) { return cmp_(l, r) <= 0; }
+    template<class E, class Tr = Traits, enable_if<is_length_first<Tr>>...> friend bool operator>=(concat_view const& l, parray<E, Traits> r) { return cmp_(l, r) >= 0; }
+    template<class E> friend bool operator==(parray<E, Traits> l, concat_view const& r) { return  eq_(r, l); }
+    template<class E> friend bool operator!=(parray<E, Traits> l, concat_view const& r) { return !eq_(r, l); }
+    template<class E, class Tr = Traits, enable_if<is_length_first<Tr>>...> friend bool operator< (parray<E, Traits> l, concat_view const& r) { return cmp_(r, l) >  0; }
+    template<class E, class Tr = Traits, enable_if<is_length_first<Tr>>...> friend bool operator> (parray<E, Traits> l, concat_view const& r) { return cmp_(r, l) <  0; }
+    template<class E, class Tr = Traits, enable_if<is_length_first<Tr>>...> friend bool operator<=(parray<E, Traits> l, concat_view const& r) { return cmp_(r, l) >= 0; }
+    template<class E, class Tr = Traits, enable_if<is_length_first<Tr>>...> friend bool operator>=(parray<E, Traits> l, concat_view const& r) { return cmp_(r, l) <= 0; }
+
+    // concat_view vs basic_string<E, Tr, A>
+    template<class E, class Tr, class A> friend bool operator==(concat_view const& l, basic_string<E, Tr, A> const& r) { return l == parray<E const, Traits>(r); }
+    template<class E, class Tr, class A> friend bool operator!=(concat_view const& l, basic_string<E, Tr, A> const& r) { return l != parray<E const, Traits>(r); }
+    template<class E, class Tr, class A> friend bool operator==(basic_string<E, Tr, A> const& l, concat_view const& r) { return parray<E const, Traits>(l) == r; }
+    template<class E, class Tr, class A> friend bool operator!=(basic_string<E, Tr, A> const& l, concat_view const& r) { return parray<E const, Traits>(l) != r; }
+
+    // concat_view vs ntbs_t<E, Traits> (length is calculated once)
+    template<class E> friend bool operator==(concat_view const& l, ntbs_t<E, Traits> r) { return l == parray<E, Traits>(r); }
+    template<class E> friend bool operator!=(concat_view const& l, ntbs_t<E, Traits> r) { return l != parray<E, Traits>(r); }
+    template<class E, class Tr = Traits, enable_if<is_length_first<Tr>>...> friend bool operator< (concat_view const& l, ntbs_t<E, Traits> r) { return l <  parray<E, Traits>(r); }
+    template<class E, class Tr = Traits, enable_if<is_length_first<Tr>>...> friend bool operator> (concat_view const& l, ntbs_t<E, Traits> r) { return l >  parray<E, Traits>(r); }
+    template<class E, class Tr = Traits, enable_if<is_length_first<Tr>>...> friend bool operator<=(concat_view const& l, ntbs_t<E, Traits> r) { return l <= parray<E, Traits>(r); }
+    template<class E, class Tr = Traits, enable_if<is_length_first<Tr>>...> friend bool operator>=(concat_view const& l, ntbs_t<E, Traits> r) { return l >= parray<E, Traits>(r); }
+    template<class E> friend bool operator==(ntbs_t<E, Traits> l, concat_view const& r) { return r == parray<E, Traits>(l); }
+    template<class E> friend bool operator!=(ntbs_t<E, Traits> l, concat_view const& r) { return r != parray<E, Traits>(l); }
+    template<class E, class Tr = Traits, enable_if<is_length_first<Tr>>...> friend bool operator< (ntbs_t<E, Traits> l, concat_view const& r) { return r >  parray<E, Traits>(l); }
+    template<class E, class Tr = Traits, enable_if<is_length_first<Tr>>...> friend bool operator> (ntbs_t<E, Traits> l, concat_view const& r) { return r <  parray<E, Traits>(l); }
+    template<class E, class Tr = Traits, enable_if<is_length_first<Tr>>...> friend bool operator<=(ntbs_t<E, Traits> l, concat_view const& r) { return r >= parray<E, Traits>(l); }
+    template<class E, class Tr = Traits, enable_if<is_length_first<Tr>>...> friend bool operator>=(ntbs_t<E, Traits> l, concat_view const& r) { return r <= parray<E, Traits>(l); }
+
+    // ostream <<
+    template<class E, class Tr, enable_if<std::is_convertible<T*, E const*>::value>...>
+    friend std::basic_ostream<E, Tr>& operator<<(std::basic_ostream<E, Tr>& os, concat_view const& v) { for(piece_type const& p : v.pieces_) os.write(p.p, p.len); return os; }
+};
+
+
+//------------------------------------------------------------------------------
+template<class T, class Traits, class... P>
+inline concat_view<T, Traits, 1 + sizeof...(P)> concat(parray<T, Traits> first, P... rest)
+{
+    return concat_view<T, Traits, 1 + sizeof...(P)>(first, parray<T, Traits>(rest)...);
+}
+
+
+//------------------------------------------------------------------------------
+} // namespace parray_concat_pvt_
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+using parray_concat_pvt_::concat_view;
+using parray_concat_pvt_::concat;
+
+
+//------------------------------------------------------------------------------
+} // namespace adv
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+namespace std {
+
+template<class T, class Traits, size_t N>
+struct hash<adv::concat_view<T, Traits, N>>
+{
+    size_t operator()(adv::concat_view<T, Traits, N> const& v) const { return v.hash(); }
+};
+
+} // namespace std
+
+
+#endif //PARRAY_CONCAT_H_2026_10_18_18_55_12_381_H_
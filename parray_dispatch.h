@@ -0,0 +1,446 @@
+/*/////////////////////////////////////////////////////////////////////////////
+    ADV library
+
+  Author:
+    Michael Kilburn
+
+/////////////////////////////////////////////////////////////////////////////*/
+
+
+#ifndef PARRAY_DISPATCH_H_2026_10_18_20_41_09_572_H_
+#define PARRAY_DISPATCH_H_2026_10_18_20_41_09_572_H_
+
+
+#include "parray.h"
+#include "parray_tools.h"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#   include <immintrin.h>
+#   include <cpuid.h>
+#   define PARRAY_DISPATCH_X86_
+#   define PARRAY_TARGET_(isa) __attribute__((target(isa)))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#   include <immintrin.h>
+#   include <intrin.h>
+#   define PARRAY_DISPATCH_X86_
+#   define PARRAY_TARGET_(isa)
+#endif
+
+
+//------------------------------------------------------------------------------
+// Runtime CPU dispatch
+//
+//  Kernels in parray.h are selected at compile time (SSE2/AVX2 -- depending on compiler flags). This header provides
+// byte kernels selected at run time, i.e. one binary built for baseline ISA uses AVX2/AVX-512 where available:
+//
+//  isa_level                   -- scalar, sse2, avx2, avx512 (AVX-512BW)
+//  detected_isa()              -- best level supported by CPU and OS (cpuid/xgetbv), detected once
+//  requested_isa()             -- level named by PARRAY_ISA environment variable (scalar, sse2, avx2, avx512) capped by
+//                                 detected_isa(); detected_isa() if variable isn't set (or has unknown value)
+//  active_isa()                -- level in use, initially requested_isa() (chosen on first use)
+//  set_isa(level)              -- switch level (it is capped by detected_isa()), returns level in use
+//  isa_name(level)
+//
+//  byte_kernels                -- table of kernels (function pointers), all of them take unsigned bytes:
+//      mismatch(len, a, b)         -- index of first a[i] != b[i] (len if there is none)
+//      find_any(len, p, set, n)    -- index of first p[i] that is in set[0..n), n <= byte_kernels::max_set (len if none)
+//      skip_any(len, p, set, n)    -- index of first p[i] that isn't in set[0..n)
+//  kernels()                   -- table of active level
+//  kernels(level)              -- table of given level (e.g. to test them against each other)
+//
+//  parray_dispatch_traits      -- parray_traits with arrays of bytes (char, unsigned char) compared by mismatch()
+//  dispatch_delim<T>           -- delimiter for split() family: any of given bytes (find_any/skip_any)
+//
+// Example:
+//
+//      using fast_string = parray<char const, parray_dispatch_traits>;
+//      for(rcstring v : split(line, dispatch_delim<char>{ ntba(",;") })) ...
+//
+//      $ PARRAY_ISA=sse2 ./app          # force SSE2 kernels (e.g. to compare results/timings)
+//
+// Notes:
+//  - kernels never read past the end of arrays (tails are processed by scalar code or masked loads)
+//  - on non-x86 platforms only scalar level is available
+//  - with GCC/Clang kernels are compiled with target attributes, i.e. no special compiler flags are required
+//
+
+
+//------------------------------------------------------------------------------
+namespace adv { namespace parray_dispatch_pvt_ {
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+using std::size_t;
+using std::uint8_t;
+using std::uint32_t;
+using std::uint64_t;
+using adv::parray;
+using adv::parray_traits;
+
+template<class T> using remove_cv = std::remove_cv_t<T>;
+template<bool B, class T = void> using enable_if = std::enable_if_t<B, T>;
+
+
+//------------------------------------------------------------------------------
+enum class isa_level { scalar, sse2, avx2, avx512 };
+
+inline char const* isa_name(isa_level v)
+{
+    switch(v)
+    {
+    case isa_level::sse2:   return "sse2";
+    case isa_level::avx2:   return "avx2";
+    case isa_level::avx512: return "avx512";
+    default:                return "scalar";
+    }
+}
+
+struct byte_kernels
+{
+    enum : size_t { max_set = 8 };
+
+    isa_level level;
+    size_t (*mismatch)(size_t len, uint8_t const* a, uint8_t const* b);
+    size_t (*find_any)(size_t len, uint8_t const* p, uint8_t const* set, size_t n);
+    size_t (*skip_any)(size_t len, uint8_t const* p, uint8_t const* set, size_t n);
+};
+
+
+//------------------------------------------------------------------------------
+// scalar
+//
+inline size_t mismatch_scalar(size_t len, uint8_t const* a, uint8_t const* b)
+{
+    size_t i = 0;
+    while(i < len && a[i] == b[i]) ++i;
+    return i;
+}
+
+template<bool Find>
+inline size_t scan_scalar(size_t len, uint8_t const* p, uint8_t const* set, size_t n)
+{
+    size_t i = 0;
+    for(; i < len; ++i)
+        if ((std::find(set, set + n, p[i]) != set + n) == Find) break;
+    return i;
+}
+
+
+#if defined(PARRAY_DISPATCH_X86_)
+//------------------------------------------------------------------------------
+// x86
+//
+inline unsigned ctz64_(uint64_t v)
+{
+    uint32_t lo = static_cast<uint32_t>(v);
+    return lo ? adv::parray_pvt_::ctz_(lo) : 32 + adv::parray_pvt_::ctz_(static_cast<uint32_t>(v >> 32));
+}
+
+// SSE2
+PARRAY_TARGET_("sse2") inline size_t mismatch_sse2(size_t len, uint8_t const* a, uint8_t const* b)
+{
+    size_t i = 0;
+    for(; i + 16 <= len; i += 16)
+    {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<__m128i const*>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<__m128i const*>(b + i));
+        uint32_t diff = ~static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb))) & 0xFFFFu;
+        if (diff) return i + adv::parray_pvt_::ctz_(diff);
+    }
+    return i + mismatch_scalar(len - i, a + i, b + i);
+}
+
+template<bool Find>
+PARRAY_TARGET_("sse2") inline size_t scan_sse2(size_t len, uint8_t const* p, uint8_t const* set, size_t n)
+{
+    __m128i d[byte_kernels::max_set];
+    for(size_t k = 0; k < n; ++k) d[k] = _mm_set1_epi8(static_cast<char>(set[k]));
+
+    size_t i = 0;
+    for(; i + 16 <= len; i += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + i));
+        __m128i hit = _mm_setzero_si128();
+        for(size_t k = 0; k < n; ++k) hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, d[k]));
+        uint32_t m = static_cast<uint32_t>(_mm_movemask_epi8(hit));
+        if (!Find) m = ~m & 0xFFFFu;
+        if (m) return i + adv::parray_pvt_::ctz_(m);
+    }
+    return i + scan_scalar<Find>(len - i, p + i, set, n);
+}
+
+// AVX2
+PARRAY_TARGET_("avx2") inline size_t mismatch_avx2(size_t len, uint8_t const* a, uint8_t const* b)
+{
+    size_t i = 0;
+    for(; i + 32 <= len; i += 32)
+    {
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(a + i));
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(b + i));
+        uint32_t diff = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb)));
+        if (diff) return i + adv::parray_pvt_::ctz_(diff);
+    }
+    return i + mismatch_sse2(len - i, a + i, b + i);
+}
+
+template<bool Find>
+PARRAY_TARGET_("avx2") inline size_t scan_avx2(size_t len, uint8_t const* p, uint8_t const* set, size_t n)
+{
+    __m256i d[byte_kernels::max_set];
+    for(size_t k = 0; k < n; ++k) d[k] = _mm256_set1_epi8(static_cast<char>(set[k]));
+
+    size_t i = 0;
+    for(; i + 32 <= len; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p + i));
+        __m256i hit = _mm256_setzero_si256();
+        for(size_t k = 0; k < n; ++k) hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(v, d[k]));
+        uint32_t m = static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+        if (!Find) m = ~m;
+        if (m) return i + adv::parray_pvt_::ctz_(m);
+    }
+    return i + scan_sse2<Find>(len - i, p + i, set, n);
+}
+
+// AVX-512BW (tail is handled by masked loads)
+PARRAY_TARGET_("avx512f,avx512bw") inline size_t mismatch_avx512(size_t len, uint8_t const* a, uint8_t const* b)
+{
+    for(size_t i = 0; i < len; i += 64)
+    {
+        __mmask64 live = (len - i >= 64) ? ~__mmask64(0) : (__mmask64(1) << (len - i)) - 1;
+        __m512i va = _mm512_maskz_loadu_epi8(live, a + i);
+        __m512i vb = _mm512_maskz_loadu_epi8(live, b + i);
+        uint64_t diff = _mm512_cmpneq_epi8_mask(va, vb);
+        if (diff) return i + ctz64_(diff);
+    }
+    return len;
+}
+
+template<bool Find>
+PARRAY_TARGET_("avx512f,avx512bw") inline size_t scan_avx512(size_t len, uint8_t const* p, uint8_t const* set, size_t n)
+{
+    __m512i d[byte_kernels::max_set];
+    for(size_t k = 0; k < n; ++k) d[k] = _mm512_set1_epi8(static_cast<char>(set[k]));
+
+    for(size_t i = 0; i < len; i += 64)
+    {
+        __mmask64 live = (len - i >= 64) ? ~__mmask64(0) : (__mmask64(1) << (len - i)) - 1;
+        __m512i v = _mm512_maskz_loadu_epi8(live, p + i);
+        uint64_t hit = 0;
+        for(size_t k = 0; k < n; ++k) hit |= _mm512_cmpeq_epi8_mask(v, d[k]);
+        uint64_t m = (Find ? hit : ~hit) & live;
+        if (m) return i + ctz64_(m);
+    }
+    return len;
+}
+
+
+//------------------------------------------------------------------------------
+inline void cpuid_(unsigned leaf, unsigned sub, unsigned r[4])
+{
+#if defined(_MSC_VER)
+    int v[4];
+    __cpuidex(v, static_cast<int>(leaf), static_cast<int>(sub));
+    for(int i = 0; i < 4; ++i) r[i] = static_cast<unsigned>(v[i]);
+#else
+    r[0] = r[1] = r[2] = r[3] = 0;
+    if (__get_cpuid_max(0, nullptr) >= leaf) __cpuid_count(leaf, sub, r[0], r[1], r[2], r[3]);
+#endif
+}
+
+inline uint64_t xgetbv_()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return (uint64_t(hi) << 32) | lo;
+#endif
+}
+
+inline isa_level detect_isa_()
+{
+    unsigned r1[4], r7[4];
+    cpuid_(1, 0, r1);
+    cpuid_(7, 0, r7);
+
+    if (!(r1[3] & (1u << 26))) return isa_level::scalar;                // SSE2
+
+    bool os_ymm = false, os_zmm = false;
+    if ((r1[2] & (1u << 27)) && (r1[2] & (1u << 28)))                  // OSXSAVE, AVX
+    {
+        uint64_t xcr0 = xgetbv_();
+        os_ymm = (xcr0 & 0x06) == 0x06;                                 // XMM, YMM state
+        os_zmm = (xcr0 & 0xE6) == 0xE6;                                 // + opmask, ZMM state
+    }
+
+    if (os_zmm && (r7[1] & (1u << 16)) && (r7[1] & (1u << 30))) return isa_level::avx512;     // AVX512F, AVX512BW
+    if (os_ymm && (r7[1] & (1u << 5))) return isa_level::avx2;
+    return isa_level::sse2;
+}
+#else
+inline isa_level detect_isa_() { return isa_level::scalar; }
+#endif
+
+
+//------------------------------------------------------------------------------
+// kernel tables
+//
+inline byte_kernels const& kernels(isa_level v)
+{
+    static byte_kernels const tables[] = {
+        { isa_level::scalar, &mismatch_scalar, &scan_scalar<true>, &scan_scalar<false> },
+#if defined(PARRAY_DISPATCH_X86_)
+        { isa_level::sse2,   &mismatch_sse2,   &scan_sse2<true>,   &scan_sse2<false>   },
+        { isa_level::avx2,   &mismatch_avx2,   &scan_avx2<true>,   &scan_avx2<false>   },
+        { isa_level::avx512, &mismatch_avx512, &scan_avx512<true>, &scan_avx512<false> },
+#endif
+    };
+    size_t i = static_cast<size_t>(v);
+    return tables[(i < sizeof(tables)/sizeof(tables[0])) ? i : 0];
+}
+
+inline isa_level detected_isa()
+{
+    static isa_level const v = detect_isa_();
+    return v;
+}
+
+inline isa_level requested_isa()
+{
+    isa_level v = detected_isa();
+    if (char const* s = std::getenv("PARRAY_ISA"))
+        for(isa_level l : { isa_level::scalar, isa_level::sse2, isa_level::avx2, isa_level::avx512 })
+            if (std::strcmp(s, isa_name(l)) == 0) { v = std::min(l, detected_isa()); break; }
+    return v;
+}
+
+inline std::atomic<byte_kernels const*>& active_()
+{
+    static std::atomic<byte_kernels const*> p{ &kernels(requested_isa()) };
+    return p;
+}
+
+inline byte_kernels const& kernels() { return *active_().load(std::memory_order_relaxed); }
+
+inline isa_level active_isa() { return kernels().level; }
+
+inline isa_level set_isa(isa_level v)
+{
+    byte_kernels const& k = kernels(std::min(v, detected_isa()));
+    active_().store(&k, std::memory_order_relaxed);
+    return k.level;
+}
+
+
+//------------------------------------------------------------------------------
+// parray_dispatch_traits
+//
+struct parray_dispatch_traits : parray_traits
+{
+protected:
+    template<class T> constexpr static bool is_byte_elem = !std::is_volatile<T>::value && sizeof(T) == 1 &&
+                                                           (std::is_same<remove_cv<T>, char>::value || std::is_same<remove_cv<T>, unsigned char>::value);
+    template<class L, class R> constexpr static bool is_dispatched = is_byte_elem<L> && is_byte_elem<R> && std::is_same<remove_cv<L>, remove_cv<R>>::value;
+
+    template<class T> static uint8_t const* bytes_(T* p) { return reinterpret_cast<uint8_t const*>(p); }
+
+    // byte-wise order is the same as char_traits<char>::compare() and memcmp()
+    template<class L, class R>
+    static bool dispatch_lt_(size_t len, L* l, R* r)
+    {
+        size_t i = kernels().mismatch(len, bytes_(l), bytes_(r));
+        return i < len && bytes_(l)[i] < bytes_(r)[i];
+    }
+
+public:
+    template<class L, class R, enable_if< is_dispatched<L, R>>...> static bool eq(size_t l_len, L* l, size_t r_len, R* r) { return l_len == r_len && (same_ptr(l, r) || kernels().mismatch(l_len, bytes_(l), bytes_(r)) == l_len); }
+    template<class L, class R, enable_if< is_dispatched<L, R>>...> static bool lt(size_t l_len, L* l, size_t r_len, R* r) { return l_len < r_len || (l_len == r_len && !same_ptr(l, r) && dispatch_lt_(l_len, l, r)); }
+    template<class L, class R, enable_if<!is_dispatched<L, R>>...> static bool eq(size_t l_len, L* l, size_t r_len, R* r) { return parray_traits::eq(l_len, l, r_len, r); }
+    template<class L, class R, enable_if<!is_dispatched<L, R>>...> static bool lt(size_t l_len, L* l, size_t r_len, R* r) { return parray_traits::lt(l_len, l, r_len, r); }
+
+    template<class L, class R> static bool eq_not(size_t l_len, L* l, size_t r_len, R* r) { return !eq(l_len, l, r_len, r); }           // l != r -> !(l == r)
+    template<class L, class R> static bool gt    (size_t l_len, L* l, size_t r_len, R* r) { return lt (r_len, r, l_len, l); }           // l >  r -> r <  l
+    template<class L, class R> static bool lt_eq (size_t l_len, L* l, size_t r_len, R* r) { return !lt(r_len, r, l_len, l); }           // l <= r -> r >= l -> !(r < l)
+    template<class L, class R> static bool gt_eq (size_t l_len, L* l, size_t r_len, R* r) { return !lt(l_len, l, r_len, r); }           // l >= r -> !(l < r)
+};
+
+
+//------------------------------------------------------------------------------
+// dispatch_delim<T> -- any of given byte values (more than byte_kernels::max_set values are looked up in bitmap)
+//
+template<class T = char>
+class dispatch_delim
+{
+    static_assert(sizeof(T) == 1 && std::is_integral<T>::value, "dispatch_delim: byte-sized element type is expected");
+
+    uint8_t set_[byte_kernels::max_set];
+    size_t n_ = 0;
+    adv::bitset_delim<unsigned char> bits_;
+
+    template<class E> static uint8_t const* bytes_(E* p) { return reinterpret_cast<uint8_t const*>(p); }
+
+    bool wide_() const { return n_ > byte_kernels::max_set; }
+
+public:
+    enum { is_delimiter };      // mark this type for 'delim is: D' case
+
+    template<class E, class Tr>
+    explicit dispatch_delim(parray<E, Tr> v)
+    {
+        for(size_t i = 0; i < v.len; ++i)
+        {
+            uint8_t c = static_cast<uint8_t>(v[i]);
+            if (bits_.is_set(c)) continue;
+            bits_.set_bit(c);
+            if (n_ < byte_kernels::max_set) set_[n_] = c;
+            ++n_;
+        }
+    }
+
+    template<class E, enable_if<std::is_same<remove_cv<E>, T>::value>...>
+    inline E* find_first(E* p, E* p_end) const { return wide_() ? bits_.find_first(p, p_end) : p + kernels().find_any(size_t(p_end - p), bytes_(p), set_, n_); }
+
+    template<class E, enable_if<std::is_same<remove_cv<E>, T>::value>...>
+    inline E* skip_all(E* p, E* p_end) const { return wide_() ? bits_.skip_all(p, p_end) : p + kernels().skip_any(size_t(p_end - p), bytes_(p), set_, n_); }
+
+    // reverse iteration
+    template<class I> inline I find_first(I p, I p_end) const { return bits_.find_first(p, p_end); }
+    template<class I> inline I skip_all  (I p, I p_end) const { return bits_.skip_all(p, p_end); }
+
+    // pre-condition: p was produced by 'find_first()' and != p_end
+    template<class I> inline I skip_one  (I p) const { return ++p; }
+};
+
+
+//------------------------------------------------------------------------------
+} // namespace parray_dispatch_pvt_
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+using parray_dispatch_pvt_::isa_level;
+using parray_dispatch_pvt_::isa_name;
+using parray_dispatch_pvt_::byte_kernels;
+using parray_dispatch_pvt_::kernels;
+using parray_dispatch_pvt_::detected_isa;
+using parray_dispatch_pvt_::requested_isa;
+using parray_dispatch_pvt_::active_isa;
+using parray_dispatch_pvt_::set_isa;
+using parray_dispatch_pvt_::parray_dispatch_traits;
+using parray_dispatch_pvt_::dispatch_delim;
+
+
+//------------------------------------------------------------------------------
+} // namespace adv
+//------------------------------------------------------------------------------
+
+
+#endif //PARRAY_DISPATCH_H_2026_10_18_20_41_09_572_H_
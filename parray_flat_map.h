@@ -0,0 +1,278 @@
+/*/////////////////////////////////////////////////////////////////////////////
+    ADV library
+
+  Author:
+    Michael Kilburn
+
+/////////////////////////////////////////////////////////////////////////////*/
+
+
+#ifndef PARRAY_FLAT_MAP_H_2026_10_18_16_05_41_217_H_
+#define PARRAY_FLAT_MAP_H_2026_10_18_16_05_41_217_H_
+
+
+#include "parray.h"
+#include <type_traits>
+#include <algorithm>
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <stdexcept>
+#include <initializer_list>
+#include <cstdint>
+
+
+//------------------------------------------------------------------------------
+// Read-optimized sorted containers of parray keys
+//
+//  parray_flat_set<E, Traits>      -- sorted unique keys
+//  parray_flat_map<E, V, Traits>   -- sorted unique keys with associated values
+//
+//  Default trait orders arrays by length first -- sorted keys form contiguous runs of same length. Containers keep small
+// directory (length -> first key of that length), so lookup goes straight to the run for key.len and binary-searches
+// it comparing only contents (i.e. memcmp for char arrays).
+//
+//  Both are built once from a range (or initializer list) and not modified afterwards:
+//
+//      parray_flat_set<char> s{ ntba("GET"), ntba("PUT"), ntba("POST"), ntba("DELETE") };
+//      if (s.contains(method)) ...
+//
+//      parray_flat_map<char, int> m{ {ntba("info"), 1}, {ntba("warn"), 2}, {ntba("error"), 3} };
+//      if (int const* level = m.find(name)) ...
+//
+// Notes:
+//  - keys are borrowed, memory they point to has to outlive container
+//  - Traits has to order by length first (like parray_traits); keys are compared with Traits::lt/Traits::eq
+//  - duplicate keys: set keeps one of them, map keeps value of the first one in construction range
+//  - lengths above dir_max_len aren't in directory -- such keys are looked up by binary search over the tail of sorted
+//    array (still using length-first comparisons)
+//  - directory keeps 32-bit indices -- containers hold at most 2^32-1 keys (std::length_error is thrown otherwise)
+//
+
+
+//------------------------------------------------------------------------------
+namespace adv { namespace parray_flat_map_pvt_ {
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+using std::size_t;
+using std::vector;
+using adv::parray;
+using adv::parray_traits;
+
+template<class T> using remove_cv = std::remove_cv_t<T>;
+
+
+//------------------------------------------------------------------------------
+// length directory over sorted keys
+//
+template<class Key>
+class length_dir
+{
+    enum : size_t { dir_max_len = 1024 };
+
+    vector<std::uint32_t> first_;   // first_[len] -- index of first key with length >= len (len in [0, dir_len_ + 1])
+    size_t dir_len_ = 0;            // max key length covered by directory
+
+public:
+    void build(vector<Key> const& keys)
+    {
+        if (keys.size() > UINT32_MAX) throw std::length_error("parray_flat_map: too many keys");
+
+        size_t max_len = keys.empty() ? 0 : keys.back().len;
+        dir_len_ = (max_len < dir_max_len) ? max_len : size_t(dir_max_len);
+
+        first_.assign(dir_len_ + 2, 0);
+        size_t i = 0;
+        for(size_t len = 0; len <= dir_len_ + 1; ++len)
+        {
+            while(i < keys.size() && keys[i].len < len) ++i;
+            first_[len] = static_cast<std::uint32_t>(i);
+        }
+    }
+
+    // index of first key not less than k
+    template<class Traits, class K>
+    size_t lower_bound(vector<Key> const& keys, K const& k) const
+    {
+        auto lt = [](Key const& l, K const& r) { return Traits::lt(l.len, l.p, r.len, r.p); };
+
+        if (k.len > dir_len_)   // beyond directory -- search the tail
+            return std::lower_bound(keys.begin() + first_[dir_len_ + 1], keys.end(), k, lt) - keys.begin();
+
+        // all keys in the run have the same length as k
+        return std::lower_bound(keys.begin() + first_[k.len], keys.begin() + first_[k.len + 1], k, lt) - keys.begin();
+    }
+
+    // index of key equal to k or keys.size()
+    template<class Traits, class K>
+    size_t find(vector<Key> const& keys, K const& k) const
+    {
+        size_t i = lower_bound<Traits>(keys, k);
+        return (i < keys.size() && Traits::eq(keys[i].len, keys[i].p, k.len, k.p)) ? i : keys.size();
+    }
+
+    // number of keys of given length
+    size_t count_len(vector<Key> const& keys, size_t len) const
+    {
+        if (len > dir_len_)
+        {
+            size_t n = 0;
+            for(size_t i = first_[dir_len_ + 1]; i < keys.size(); ++i) n += (keys[i].len == len);
+            return n;
+        }
+        return first_[len + 1] - first_[len];
+    }
+};
+
+
+//------------------------------------------------------------------------------
+template<class E, class Traits = parray_traits>
+class parray_flat_set
+{
+public:
+    using key_type = parray<E const, Traits>;
+    using const_iterator = typename vector<key_type>::const_iterator;
+
+private:
+    vector<key_type> keys_;
+    length_dir<key_type> dir_;
+
+    void build_()
+    {
+        std::sort(keys_.begin(), keys_.end(), [](key_type const& l, key_type const& r) { return l < r; });
+        keys_.erase(std::unique(keys_.begin(), keys_.end(), [](key_type const& l, key_type const& r) { return l == r; }), keys_.end());
+        dir_.build(keys_);
+    }
+
+public:
+    parray_flat_set() { dir_.build(keys_); }
+
+    template<class I>
+    parray_flat_set(I it, I it_end)
+    {
+        for(; it != it_end; ++it) keys_.push_back(key_type(*it));
+        build_();
+    }
+
+    parray_flat_set(std::initializer_list<key_type> keys) : keys_(keys) { build_(); }
+
+    size_t size() const  { return keys_.size(); }
+    bool empty() const   { return keys_.empty(); }
+
+    const_iterator begin() const { return keys_.begin(); }
+    const_iterator end() const   { return keys_.end(); }
+
+    key_type const& operator[](size_t i) const { return keys_[i]; }
+
+    template<class T> const_iterator find(parray<T, Traits> k) const        { return begin() + dir_.template find<Traits>(keys_, k); }
+    template<class T> const_iterator lower_bound(parray<T, Traits> k) const { return begin() + dir_.template lower_bound<Traits>(keys_, k); }
+    template<class T> bool contains(parray<T, Traits> k) const              { return find(k) != end(); }
+    template<class T> size_t count(parray<T, Traits> k) const               { return contains(k) ? 1 : 0; }
+
+    // number of keys of given length
+    size_t count_len(size_t len) const { return dir_.count_len(keys_, len); }
+};
+
+
+//------------------------------------------------------------------------------
+template<class E, class V, class Traits = parray_traits>
+class parray_flat_map
+{
+public:
+    using key_type = parray<E const, Traits>;
+    using mapped_type = V;
+
+private:
+    vector<key_type> keys_;
+    vector<V> values_;
+    length_dir<key_type> dir_;
+
+    template<class P>
+    void build_(vector<P>& items)
+    {
+        std::stable_sort(items.begin(), items.end(), [](P const& l, P const& r) { return l.first < r.first; });
+        items.erase(std::unique(items.begin(), items.end(), [](P const& l, P const& r) { return l.first == r.first; }), items.end());
+
+        keys_.reserve(items.size());
+        values_.reserve(items.size());
+        for(auto& v : items)
+        {
+            keys_.push_back(v.first);
+            values_.push_back(std::move(v.second));
+        }
+        dir_.build(keys_);
+    }
+
+public:
+    parray_flat_map() { dir_.build(keys_); }
+
+    template<class I>
+    parray_flat_map(I it, I it_end)
+    {
+        vector<std::pair<key_type, V>> items;
+        for(; it != it_end; ++it) items.emplace_back(key_type(it->first), it->second);
+        build_(items);
+    }
+
+    parray_flat_map(std::initializer_list<std::pair<key_type, V>> init)
+    {
+        vector<std::pair<key_type, V>> items(init);
+        build_(items);
+    }
+
+    size_t size() const  { return keys_.size(); }
+    bool empty() const   { return keys_.empty(); }
+
+    // keys (sorted) and values -- same index
+    vector<key_type> const& keys() const { return keys_; }
+    vector<V> const& values() const      { return values_; }
+    vector<V>& values()                  { return values_; }
+
+    // index of key or size() if not found
+    template<class T> size_t index_of(parray<T, Traits> k) const { return dir_.template find<Traits>(keys_, k); }
+
+    // pointer to value or nullptr if not found
+    template<class T> V const* find(parray<T, Traits> k) const { size_t i = index_of(k); return (i < size()) ? &values_[i] : nullptr; }
+    template<class T> V* find(parray<T, Traits> k)             { size_t i = index_of(k); return (i < size()) ? &values_[i] : nullptr; }
+
+    template<class T> bool contains(parray<T, Traits> k) const { return index_of(k) < size(); }
+    template<class T> size_t count(parray<T, Traits> k) const  { return contains(k) ? 1 : 0; }
+
+    template<class T>
+    V const& at(parray<T, Traits> k) const
+    {
+        if (V const* v = find(k)) return *v;
+        throw std::out_of_range("parray_flat_map::at");
+    }
+
+    template<class T>
+    V& at(parray<T, Traits> k)
+    {
+        if (V* v = find(k)) return *v;
+        throw std::out_of_range("parray_flat_map::at");
+    }
+
+    // f(key_type k, V const& v) for every element in key order
+    template<class F>
+    void for_each(F f) const { for(size_t i = 0; i < keys_.size(); ++i) f(keys_[i], values_[i]); }
+};
+
+
+//------------------------------------------------------------------------------
+} // namespace parray_flat_map_pvt_
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+using parray_flat_map_pvt_::parray_flat_set;
+using parray_flat_map_pvt_::parray_flat_map;
+
+
+//------------------------------------------------------------------------------
+} // namespace adv
+//------------------------------------------------------------------------------
+
+
+#endif //PARRAY_FLAT_MAP_H_2026_10_18_16_05_41_217_H_
@@ -0,0 +1,489 @@
+/*/////////////////////////////////////////////////////////////////////////////
+    ADV library
+
+  Author:
+    Michael Kilburn
+
+/////////////////////////////////////////////////////////////////////////////*/
+
+
+#ifndef PARRAY_FORMAT_H_2026_10_18_11_40_07_862_H_
+#define PARRAY_FORMAT_H_2026_10_18_11_40_07_862_H_
+
+
+#include "parray.h"
+#include <type_traits>
+#include <limits>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+
+
+//------------------------------------------------------------------------------
+// parray<> number formatting
+//
+//  rcstring format_int(char* buf, size_t size, T v)
+//  rcstring format_int(char (&buf)[n], T v)
+//      write decimal representation of integer v into buf, return resulting array (not nul-terminated)
+//  rcstring format_double(char* buf, size_t size, double v)
+//  rcstring format_double(char (&buf)[n], double v)
+//      write shortest representation of v that round-trips (i.e. parse<double>() gives v back)
+//
+//  rcstring append_int(R& r, T v)
+//  rcstring append_double(R& r, double v)
+//      the same, but append result to container R (see join() in parray_tools.h for R requirements), returned
+//      array points into r and stays valid until r is modified
+//
+//  format_max<T>
+//      buffer size that is always enough to hold formatted value of type T
+//
+// Notes:
+//  - if buffer is too small nothing is written and empty array is returned (any number has at least one char)
+//  - integers are written two digits at a time using lookup table, no format string parsing and no locale
+//  - doubles are converted using Grisu2 algorithm (F.Loitsch, "Printing Floating-Point Numbers Quickly and
+//    Accurately with Integers"), result always round-trips and is the shortest one in vast majority of cases
+//  - double output format (similar to std::to_chars() and JavaScript):
+//      123, 1234.5, 0.001, 1e+22, 1.5e-07, -0, inf, -inf, nan
+//
+// Example:
+//
+//      char buf[format_max<int>];
+//      rcstring s = format_int(buf, 12345);        // s == ntba("12345")
+//
+
+
+//------------------------------------------------------------------------------
+namespace adv { namespace parray_format_pvt_ {
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+using std::size_t;
+using std::uint64_t;
+using std::uint32_t;
+using std::numeric_limits;
+using adv::parray;
+using rcstring = parray<char const>;
+
+template<bool B, class T = void> using enable_if = std::enable_if_t<B, T>;
+template<class T> using make_unsigned = std::make_unsigned_t<T>;
+template<class T> constexpr bool is_integral = std::is_integral<T>::value && !std::is_same<T, bool>::value;
+template<class T> constexpr bool is_signed = std::is_signed<T>::value;
+
+
+//------------------------------------------------------------------------------
+template<class T, class = void> struct FormatMax;
+template<class T> struct FormatMax<T, enable_if<is_integral<T>>> { enum { value = numeric_limits<T>::digits10 + 1 + is_signed<T> }; };
+template<class T> struct FormatMax<T, enable_if<std::is_same<T, double>::value>> { enum { value = 25 }; };  // -0.0000012345678901234567
+
+template<class T> constexpr size_t format_max = FormatMax<T>::value;
+
+
+//------------------------------------------------------------------------------
+// integers
+//
+
+inline char const* digit_pairs()
+{
+    return "00010203040506070809"
+           "10111213141516171819"
+           "20212223242526272829"
+           "30313233343536373839"
+           "40414243444546474849"
+           "50515253545556575859"
+           "60616263646566676869"
+           "70717273747576777879"
+           "80818283848586878889"
+           "90919293949596979899";
+}
+
+inline unsigned count_digits(uint64_t v)
+{
+    unsigned n = 1;
+    for(;;)
+    {
+        // four comparisons per division
+        if (v < 10) return n;
+        if (v < 100) return n + 1;
+        if (v < 1000) return n + 2;
+        if (v < 10000) return n + 3;
+        v /= 10000u;
+        n += 4;
+    }
+}
+
+// writes exactly 'n' digits of v ending at 'p_end'
+inline void write_digits(char* p_end, uint64_t v)
+{
+    char const* pairs = digit_pairs();
+    while(v >= 100)
+    {
+        unsigned i = static_cast<unsigned>(v % 100) * 2;
+        v /= 100;
+        p_end -= 2;
+        p_end[0] = pairs[i];
+        p_end[1] = pairs[i + 1];
+    }
+
+    if (v < 10)
+        p_end[-1] = char('0' + v);
+    else
+    {
+        p_end[-2] = pairs[v * 2];
+        p_end[-1] = pairs[v * 2 + 1];
+    }
+}
+
+template<class T>
+inline rcstring format_int_(char* buf, size_t size, T v)
+{
+    using U = make_unsigned<T>;
+
+    bool neg = is_signed<T> && v < 0;
+    uint64_t u = neg ? uint64_t(static_cast<U>(U(0) - static_cast<U>(v))) : uint64_t(static_cast<U>(v));
+
+    size_t len = count_digits(u) + neg;
+    if (len > size) return {0, buf};
+
+    if (neg) buf[0] = '-';
+    write_digits(buf + len, u);
+    return {len, buf};
+}
+
+
+//------------------------------------------------------------------------------
+// doubles (Grisu2, based on implementation by Milo Yip)
+//
+
+struct diy_fp
+{
+    uint64_t f;
+    int      e;
+
+    diy_fp() = default;
+    diy_fp(uint64_t f, int e) : f(f), e(e) {}
+
+    diy_fp operator-(diy_fp r) const { return {f - r.f, e}; }
+
+    diy_fp operator*(diy_fp r) const
+    {
+        uint64_t const M32 = 0xFFFFFFFFu;
+        uint64_t a = f >> 32, b = f & M32, c = r.f >> 32, d = r.f & M32;
+        uint64_t ac = a*c, bc = b*c, ad = a*d, bd = b*d;
+        uint64_t tmp = (bd >> 32) + (ad & M32) + (bc & M32);
+        tmp += 1u << 31;                                    // round
+        return {ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), e + r.e + 64};
+    }
+
+    diy_fp normalize() const
+    {
+        diy_fp r = *this;
+        while(!(r.f & (uint64_t(1) << 63))) { r.f <<= 1; --r.e; }
+        return r;
+    }
+};
+
+enum { dp_significand_size = 52, dp_exponent_bias = 0x3FF + dp_significand_size, dp_min_exponent = -dp_exponent_bias };
+constexpr uint64_t dp_hidden_bit = uint64_t(1) << dp_significand_size;
+constexpr uint64_t dp_significand_mask = dp_hidden_bit - 1;
+constexpr uint64_t dp_exponent_mask = uint64_t(0x7FF) << dp_significand_size;
+
+inline diy_fp to_diy_fp(uint64_t u)
+{
+    int biased_e = static_cast<int>((u & dp_exponent_mask) >> dp_significand_size);
+    uint64_t significand = u & dp_significand_mask;
+    return biased_e ? diy_fp(significand + dp_hidden_bit, biased_e - dp_exponent_bias) : diy_fp(significand, dp_min_exponent + 1);
+}
+
+// boundaries m- and m+ of v, both have the exponent of normalized m+
+inline void normalized_boundaries(diy_fp v, diy_fp& m_minus, diy_fp& m_plus)
+{
+    diy_fp pl(((v.f) << 1) + 1, v.e - 1);
+    while(!(pl.f & (dp_hidden_bit << 1))) { pl.f <<= 1; --pl.e; }
+    pl.f <<= (64 - dp_significand_size - 2);
+    pl.e  -= (64 - dp_significand_size - 2);
+
+    diy_fp mi = (v.f == dp_hidden_bit) ? diy_fp((v.f << 2) - 1, v.e - 2) : diy_fp((v.f << 1) - 1, v.e - 1);
+    mi.f <<= mi.e - pl.e;
+    mi.e = pl.e;
+
+    m_minus = mi;
+    m_plus = pl;
+}
+
+// 10^k for k = -348, -340, ..., 340 (normalized)
+inline diy_fp cached_power(int e, int& k)
+{
+    static struct { uint64_t f; short e; } const tbl[] = {
+        { 0xfa8fd5a0081c0288ull, -1220 }, { 0xbaaee17fa23ebf76ull, -1193 }, { 0x8b16fb203055ac76ull, -1166 },
+        { 0xcf42894a5dce35eaull, -1140 }, { 0x9a6bb0aa55653b2dull, -1113 }, { 0xe61acf033d1a45dfull, -1087 },
+        { 0xab70fe17c79ac6caull, -1060 }, { 0xff77b1fcbebcdc4full, -1034 }, { 0xbe5691ef416bd60cull, -1007 },
+        { 0x8dd01fad907ffc3cull,  -980 }, { 0xd3515c2831559a83ull,  -954 }, { 0x9d71ac8fada6c9b5ull,  -927 },
+        { 0xea9c227723ee8bcbull,  -901 }, { 0xaecc49914078536dull,  -874 }, { 0x823c12795db6ce57ull,  -847 },
+        { 0xc21094364dfb5637ull,  -821 }, { 0x9096ea6f3848984full,  -794 }, { 0xd77485cb25823ac7ull,  -768 },
+        { 0xa086cfcd97bf97f4ull,  -741 }, { 0xef340a98172aace5ull,  -715 }, { 0xb23867fb2a35b28eull,  -688 },
+        { 0x84c8d4dfd2c63f3bull,  -661 }, { 0xc5dd44271ad3cdbaull,  -635 }, { 0x936b9fcebb25c996ull,  -608 },
+        { 0xdbac6c247d62a584ull,  -582 }, { 0xa3ab66580d5fdaf6ull,  -555 }, { 0xf3e2f893dec3f126ull,  -529 },
+        { 0xb5b5ada8aaff80b8ull,  -502 }, { 0x87625f056c7c4a8bull,  -475 }, { 0xc9bcff6034c13053ull,  -449 },
+        { 0x964e858c91ba2655ull,  -422 }, { 0xdff9772470297ebdull,  -396 }, { 0xa6dfbd9fb8e5b88full,  -369 },
+        { 0xf8a95fcf88747d94ull,  -343 }, { 0xb94470938fa89bcfull,  -316 }, { 0x8a08f0f8bf0f156bull,  -289 },
+        { 0xcdb02555653131b6ull,  -263 }, { 0x993fe2c6d07b7facull,  -236 }, { 0xe45c10c42a2b3b06ull,  -210 },
+        { 0xaa242499697392d3ull,  -183 }, { 0xfd87b5f28300ca0eull,  -157 }, { 0xbce5086492111aebull,  -130 },
+        { 0x8cbccc096f5088ccull,  -103 }, { 0xd1b71758e219652cull,   -77 }, { 0x9c40000000000000ull,   -50 },
+        { 0xe8d4a51000000000ull,   -24 }, { 0xad78ebc5ac620000ull,     3 }, { 0x813f3978f8940984ull,    30 },
+        { 0xc097ce7bc90715b3ull,    56 }, { 0x8f7e32ce7bea5c70ull,    83 }, { 0xd5d238a4abe98068ull,   109 },
+        { 0x9f4f2726179a2245ull,   136 }, { 0xed63a231d4c4fb27ull,   162 }, { 0xb0de65388cc8ada8ull,   189 },
+        { 0x83c7088e1aab65dbull,   216 }, { 0xc45d1df942711d9aull,   242 }, { 0x924d692ca61be758ull,   269 },
+        { 0xda01ee641a708deaull,   295 }, { 0xa26da3999aef774aull,   322 }, { 0xf209787bb47d6b85ull,   348 },
+        { 0xb454e4a179dd1877ull,   375 }, { 0x865b86925b9bc5c2ull,   402 }, { 0xc83553c5c8965d3dull,   428 },
+        { 0x952ab45cfa97a0b3ull,   455 }, { 0xde469fbd99a05fe3ull,   481 }, { 0xa59bc234db398c25ull,   508 },
+        { 0xf6c69a72a3989f5cull,   534 }, { 0xb7dcbf5354e9beceull,   561 }, { 0x88fcf317f22241e2ull,   588 },
+        { 0xcc20ce9bd35c78a5ull,   614 }, { 0x98165af37b2153dfull,   641 }, { 0xe2a0b5dc971f303aull,   667 },
+        { 0xa8d9d1535ce3b396ull,   694 }, { 0xfb9b7cd9a4a7443cull,   720 }, { 0xbb764c4ca7a44410ull,   747 },
+        { 0x8bab8eefb6409c1aull,   774 }, { 0xd01fef10a657842cull,   800 }, { 0x9b10a4e5e9913129ull,   827 },
+        { 0xe7109bfba19c0c9dull,   853 }, { 0xac2820d9623bf429ull,   880 }, { 0x80444b5e7aa7cf85ull,   907 },
+        { 0xbf21e44003acdd2dull,   933 }, { 0x8e679c2f5e44ff8full,   960 }, { 0xd433179d9c8cb841ull,   986 },
+        { 0x9e19db92b4e31ba9ull,  1013 }, { 0xeb96bf6ebadf77d9ull,  1039 }, { 0xaf87023b9bf0ee6bull,  1066 },    };
+
+    double dk = (-61 - e) * 0.30102999566398114 + 347;     // dk must be positive, so can do ceiling in positive
+    int ki = static_cast<int>(dk);
+    if (dk - ki > 0.0) ++ki;
+
+    unsigned idx = static_cast<unsigned>((ki >> 3) + 1);
+    k = -(-348 + static_cast<int>(idx << 3));               // decimal exponent no need lookup table
+    return {tbl[idx].f, tbl[idx].e};
+}
+
+inline void grisu_round(char* buf, size_t len, uint64_t delta, uint64_t rest, uint64_t ten_kappa, uint64_t wp_w)
+{
+    while(rest < wp_w && delta - rest >= ten_kappa &&
+          (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w))   // closer
+    {
+        buf[len - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+inline unsigned count_digits32(uint32_t n)
+{
+    unsigned r = 1;
+    for(uint32_t t = 10; r < 10 && n >= t; t *= 10) ++r;
+    return r;
+}
+
+inline void digit_gen(diy_fp W, diy_fp Mp, uint64_t delta, char* buf, size_t& len, int& K)
+{
+    static uint64_t const pow10[] = { 1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull,
+                                      1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull,
+                                      100000000000000ull, 1000000000000000ull, 10000000000000000ull, 100000000000000000ull,
+                                      1000000000000000000ull, 10000000000000000000ull };
+
+    diy_fp const one(uint64_t(1) << -Mp.e, Mp.e);
+    diy_fp const wp_w = Mp - W;
+    uint32_t p1 = static_cast<uint32_t>(Mp.f >> -one.e);
+    uint64_t p2 = Mp.f & (one.f - 1);
+    int kappa = static_cast<int>(count_digits32(p1));
+    len = 0;
+
+    while(kappa > 0)
+    {
+        uint32_t d = static_cast<uint32_t>(p1 / pow10[kappa - 1]);
+        p1 = static_cast<uint32_t>(p1 % pow10[kappa - 1]);
+
+        if (d || len) buf[len++] = static_cast<char>('0' + d);
+        --kappa;
+
+        uint64_t tmp = (static_cast<uint64_t>(p1) << -one.e) + p2;
+        if (tmp <= delta)
+        {
+            K += kappa;
+            grisu_round(buf, len, delta, tmp, pow10[kappa] << -one.e, wp_w.f);
+            return;
+        }
+    }
+
+    for(;;)     // kappa <= 0
+    {
+        p2 *= 10;
+        delta *= 10;
+        char d = static_cast<char>(p2 >> -one.e);
+        if (d || len) buf[len++] = static_cast<char>('0' + d);
+        p2 &= one.f - 1;
+        --kappa;
+        if (p2 < delta)
+        {
+            K += kappa;
+            grisu_round(buf, len, delta, p2, one.f, (-kappa < 20) ? wp_w.f * pow10[-kappa] : 0);
+            return;
+        }
+    }
+}
+
+// writes shortest digits of positive finite v into buf (at most 17), v == digits * 10^K
+inline void grisu2(uint64_t u, char* buf, size_t& len, int& K)
+{
+    diy_fp v = to_diy_fp(u);
+    diy_fp w_m, w_p;
+    normalized_boundaries(v, w_m, w_p);
+
+    diy_fp const c_mk = cached_power(w_p.e, K);
+    diy_fp const W  = v.normalize() * c_mk;
+    diy_fp Wp = w_p * c_mk;
+    diy_fp Wm = w_m * c_mk;
+    ++Wm.f;
+    --Wp.f;
+    digit_gen(W, Wp, Wp.f - Wm.f, buf, len, K);
+}
+
+// writes "e+dd" or "e-ddd"
+inline size_t write_exponent(char* p, int k)
+{
+    char* p0 = p;
+    *p++ = 'e';
+    if (k < 0) { *p++ = '-'; k = -k; }
+    else         *p++ = '+';
+
+    unsigned n = count_digits(static_cast<unsigned>(k));
+    if (n < 2) { *p++ = '0'; }                  // printf-style, at least two digits
+    write_digits(p + n, static_cast<unsigned>(k));
+    return (p + n) - p0;
+}
+
+// converts digits (len, K) into human-readable form, buf must have 'format_max<double>' elements
+inline size_t prettify(char* buf, size_t len, int K)
+{
+    int const kk = static_cast<int>(len) + K;   // 10^(kk-1) <= v < 10^kk
+    int const n = static_cast<int>(len);
+
+    if (n <= kk && kk <= 21)                    // 1234e7 -> 12340000000
+    {
+        std::memset(buf + n, '0', kk - n);
+        return kk;
+    }
+    if (0 < kk && kk <= 21)                     // 1234e-2 -> 12.34
+    {
+        std::memmove(buf + kk + 1, buf + kk, n - kk);
+        buf[kk] = '.';
+        return n + 1;
+    }
+    if (-6 < kk && kk <= 0)                     // 1234e-6 -> 0.001234
+    {
+        size_t offset = 2 - kk;
+        std::memmove(buf + offset, buf, n);
+        buf[0] = '0';
+        buf[1] = '.';
+        std::memset(buf + 2, '0', offset - 2);
+        return n + offset;
+    }
+    if (n == 1)                                 // 1e30
+        return 1 + write_exponent(buf + 1, kk - 1);
+
+    std::memmove(buf + 2, buf + 1, n - 1);      // 1234e30 -> 1.234e+33
+    buf[1] = '.';
+    return n + 1 + write_exponent(buf + n + 1, kk - 1);
+}
+
+// buf must have 'format_max<double>' elements
+inline size_t format_double_(char* buf, double v)
+{
+    uint64_t u;
+    std::memcpy(&u, &v, sizeof(u));
+
+    char* p = buf;
+    if (u >> 63) *p++ = '-';
+
+    if ((u & dp_exponent_mask) == dp_exponent_mask)
+    {
+        if (u & dp_significand_mask)
+        {
+            std::memcpy(buf, "nan", 3);         // sign of NaN is not printed
+            return 3;
+        }
+        std::memcpy(p, "inf", 3);
+        return (p - buf) + 3;
+    }
+
+    if ((u & ~(uint64_t(1) << 63)) == 0)
+    {
+        *p = '0';
+        return (p - buf) + 1;
+    }
+
+    size_t len;
+    int K;
+    grisu2(u, p, len, K);
+    return (p - buf) + prettify(p, len, K);
+}
+
+
+//------------------------------------------------------------------------------
+// format_int() family
+//
+template<class T, enable_if<is_integral<T>>...>
+inline rcstring format_int(char* buf, size_t size, T v) { return format_int_(buf, size, v); }
+
+template<class T, size_t n, enable_if<is_integral<T>>...>
+inline rcstring format_int(char (&buf)[n], T v) { return format_int_(buf, n, v); }
+
+template<class R, class T, enable_if<is_integral<T>>...>
+inline rcstring append_int(R& r, T v)
+{
+    char buf[format_max<T>];
+    rcstring s = format_int_(buf, sizeof(buf), v);
+
+    size_t pos = r.size();
+    r.insert(end(r), s.p, s.p + s.len);
+    return {s.len, &r[0] + pos};
+}
+
+
+//------------------------------------------------------------------------------
+// format_double() family
+//
+inline rcstring format_double(char* buf, size_t size, double v)
+{
+    if (size >= format_max<double>)
+        return {format_double_(buf, v), buf};
+
+    char tmp[format_max<double>];
+    size_t len = format_double_(tmp, v);
+    if (len > size) return {0, buf};
+
+    std::memcpy(buf, tmp, len);
+    return {len, buf};
+}
+
+template<size_t n>
+inline rcstring format_double(char (&buf)[n], double v) { return format_double(buf, n, v); }
+
+template<class R>
+inline rcstring append_double(R& r, double v)
+{
+    char buf[format_max<double>];
+    size_t len = format_double_(buf, v);
+
+    size_t pos = r.size();
+    r.insert(end(r), buf, buf + len);
+    return {len, &r[0] + pos};
+}
+
+
+//------------------------------------------------------------------------------
+} // namespace parray_format_pvt_
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+using parray_format_pvt_::format_max;
+using parray_format_pvt_::format_int;
+using parray_format_pvt_::format_double;
+using parray_format_pvt_::append_int;
+using parray_format_pvt_::append_double;
+
+
+//------------------------------------------------------------------------------
+} // namespace adv
+//------------------------------------------------------------------------------
+
+
+#endif //PARRAY_FORMAT_H_2026_10_18_11_40_07_862_H_
@@ -0,0 +1,336 @@
+/*/////////////////////////////////////////////////////////////////////////////
+    ADV library
+
+  Author:
+    Michael Kilburn
+
+/////////////////////////////////////////////////////////////////////////////*/
+
+
+#ifndef PARRAY_IOVEC_H_2026_10_18_14_22_19_530_H_
+#define PARRAY_IOVEC_H_2026_10_18_14_22_19_530_H_
+
+
+#include "parray.h"
+#include "parray_tools.h"
+#include "parray_format.h"
+#include "str_format.h"
+#include <type_traits>
+#include <cstring>
+#include <vector>
+#include <memory>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#   include <sys/uio.h>
+#   include <unistd.h>
+#   include <cerrno>
+#   define PARRAY_IOVEC_HAS_WRITEV
+#endif
+
+
+//------------------------------------------------------------------------------
+// iovec_builder
+//
+//  Collects char fragments (e.g. pieces of log line) without concatenating them. Fragments are either
+// borrowed (caller guarantees they outlive the builder content) or small pieces formatted/copied into
+// builder's own storage. Result is written out with writev() or copied once into destination.
+//
+//  append(parray v)                -- borrow v
+//  append_copy(parray v)           -- copy v into builder's storage
+//  append_int(v), append_double(v) -- format number into builder's storage (see parray_format.h)
+//  append_format(ADV_FMT(...), ...)-- format into builder's storage (see str_format.h)
+//  [r]join[_se](it, it_end, delim) -- borrow range of arrays separated by delim (see join() in parray_tools.h)
+//
+//  size()                          -- total length of collected data
+//  count()                         -- number of fragments (adjacent fragments are merged)
+//  copy_to(char* buf, size_t size) -- copy data into buf, returns copied part (truncated if buf is too small)
+//  append_to(R& r)                 -- append data to container R (see join() for R requirements)
+//  flush(int fd)                   -- write data to file descriptor using writev() (POSIX only), clears builder
+//                                     on success, returns false (and leaves errno) on error -- written part is
+//                                     dropped, i.e. flush() can be retried (e.g. after EAGAIN); writev() that
+//                                     writes nothing is reported as EIO error
+//  clear()                         -- drop content, storage is retained for reuse
+//
+// Notes:
+//  - builder is neither copyable nor movable (fragments may point into its inline storage)
+//  - fragments that end up adjacent in memory are merged into one (e.g. consecutive formatted pieces)
+//
+// Example:
+//
+//      iovec_builder b;
+//      b.append(ntba("user="));
+//      b.append(user);                     // rcstring field of some parsed message, not copied
+//      b.append(ntba(" id="));
+//      b.append_int(id);
+//      b.append(ntba(" tags="));
+//      b.join(begin(tags), end(tags), ',');
+//      b.append(ntba("\n"));
+//      b.flush(fd);
+//
+
+
+//------------------------------------------------------------------------------
+namespace adv { namespace parray_iovec_pvt_ {
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+using std::size_t;
+using std::vector;
+using std::unique_ptr;
+using std::make_reverse_iterator;
+using adv::parray;
+using rcstring = parray<char const>;
+
+template<class T> using remove_cv = std::remove_cv_t<T>;
+template<bool B, class T = void> using enable_if = std::enable_if_t<B, T>;
+template<class T, class U> constexpr bool is_same = std::is_same<T, U>::value;
+
+template<class E> constexpr bool is_text = is_same<remove_cv<E>, char> && !std::is_volatile<E>::value;
+
+
+//------------------------------------------------------------------------------
+class iovec_builder
+{
+    enum { inline_size = 256, block_size = 1024, iov_batch = 64 };
+
+    vector<rcstring> pieces_;
+    size_t total_ = 0;
+
+    // storage for copied/formatted fragments
+    char local_[inline_size];
+    vector<unique_ptr<char[]>> blocks_;     // blocks_[i] has block_size chars (or more if it was allocated for large fragment)
+    vector<size_t> block_sizes_;
+    size_t cur_block_ = 0;                  // 0 -- local_, i -- blocks_[i - 1]
+    char* cur_ = local_;
+    char* cur_end_ = local_ + inline_size;
+
+    char* alloc_(size_t n)
+    {
+        if (size_t(cur_end_ - cur_) < n)
+        {
+            // try next retained block
+            for(++cur_block_; cur_block_ <= blocks_.size() && block_sizes_[cur_block_ - 1] < n; ++cur_block_) {}
+
+            if (cur_block_ > blocks_.size())
+            {
+                size_t sz = (n < block_size) ? size_t(block_size) : n;
+                blocks_.emplace_back(new char[sz]);
+                block_sizes_.push_back(sz);
+                cur_block_ = blocks_.size();
+            }
+
+            cur_ = blocks_[cur_block_ - 1].get();
+            cur_end_ = cur_ + block_sizes_[cur_block_ - 1];
+        }
+
+        char* p = cur_;
+        cur_ += n;
+        return p;
+    }
+
+    // return unused tail of last allocation
+    void unalloc_(char* p_end) { cur_ = p_end; }
+
+    void add_(rcstring v)
+    {
+        if (v.len == 0) return;
+
+        total_ += v.len;
+        if (!pieces_.empty())
+        {
+            rcstring& last = pieces_.back();
+            if (last.p + last.len == v.p)   // adjacent -- merge
+            {
+                last.len += v.len;
+                return;
+            }
+        }
+        pieces_.push_back(v);
+    }
+
+public:
+    iovec_builder() = default;
+    iovec_builder(iovec_builder const&) = delete;
+    iovec_builder& operator=(iovec_builder const&) = delete;
+
+    // borrowed fragments
+    template<class E, class Tr, enable_if<is_text<E>>...>
+    iovec_builder& append(parray<E, Tr> v) { add_(rcstring(v.len, v.p)); return *this; }
+
+    // copied/formatted fragments
+    template<class E, class Tr, enable_if<is_text<E>>...>
+    iovec_builder& append_copy(parray<E, Tr> v)
+    {
+        if (v.len)
+        {
+            char* p = alloc_(v.len);
+            std::memcpy(p, v.p, v.len);
+            add_(rcstring(v.len, p));
+        }
+        return *this;
+    }
+
+    template<class T>
+    iovec_builder& append_int(T v)
+    {
+        char* p = alloc_(format_max<T>);
+        rcstring s = format_int(p, format_max<T>, v);
+        unalloc_(p + s.len);
+        add_(s);
+        return *this;
+    }
+
+    iovec_builder& append_double(double v)
+    {
+        char* p = alloc_(format_max<double>);
+        rcstring s = format_double(p, format_max<double>, v);
+        unalloc_(p + s.len);
+        add_(s);
+        return *this;
+    }
+
+    template<class Fmt, class... Args>
+    iovec_builder& append_format(Fmt fmt, Args const&... args)
+    {
+        size_t room = size_t(cur_end_ - cur_);
+        char* p = alloc_(room);
+        auto r = str_format(p, room, fmt, args...);
+        if (r.truncated())
+        {
+            unalloc_(p);
+            p = alloc_(r.required);
+            r = str_format(p, r.required, fmt, args...);
+        }
+        unalloc_(p + r.str.len);
+        add_(r.str);
+        return *this;
+    }
+
+    // join family (single value delimiter gets copied, the rest is borrowed)
+    template<class I, class D> iovec_builder& join    (I it, I it_end, D const& delim) { adv::join    (it, it_end, delim_(delim), [this](auto v) { this->append(v); }); return *this; }
+    template<class I, class D> iovec_builder& join_se (I it, I it_end, D const& delim) { adv::join_se (it, it_end, delim_(delim), [this](auto v) { this->append(v); }); return *this; }
+    template<class I, class D> iovec_builder& rjoin   (I it, I it_end, D const& delim) { adv::rjoin   (it, it_end, delim_(delim), [this](auto v) { this->append(v); }); return *this; }
+    template<class I, class D> iovec_builder& rjoin_se(I it, I it_end, D const& delim) { adv::rjoin_se(it, it_end, delim_(delim), [this](auto v) { this->append(v); }); return *this; }
+
+private:
+    rcstring delim_(char c) { char* p = alloc_(1); *p = c; return {1, p}; }
+
+    template<class E, class Tr>
+    parray<E, Tr> delim_(parray<E, Tr> v) { return v; }
+
+public:
+    // content
+    size_t size() const  { return total_; }
+    size_t count() const { return pieces_.size(); }
+    bool empty() const   { return total_ == 0; }
+
+    template<class F>
+    void for_each(F f) const { for(rcstring const& v : pieces_) f(v); }
+
+    rcstring copy_to(char* buf, size_t size) const
+    {
+        char* p = buf;
+        for(rcstring const& v : pieces_)
+        {
+            size_t n = (v.len < size) ? v.len : size;
+            std::memcpy(p, v.p, n);
+            p += n;
+            size -= n;
+            if (size == 0) break;
+        }
+        return {size_t(p - buf), buf};
+    }
+
+    template<size_t n>
+    rcstring copy_to(char (&buf)[n]) const { return copy_to(buf, n); }
+
+    template<class R>
+    void append_to(R& r) const
+    {
+        r.reserve(r.size() + total_);
+        for(rcstring const& v : pieces_) r.insert(end(r), v.p, v.p + v.len);
+    }
+
+    void clear()
+    {
+        pieces_.clear();
+        total_ = 0;
+        cur_block_ = 0;
+        cur_ = local_;
+        cur_end_ = local_ + inline_size;
+    }
+
+#ifdef PARRAY_IOVEC_HAS_WRITEV
+    bool flush(int fd)
+    {
+        size_t i = 0;
+        size_t skip = 0;                    // bytes of pieces_[i] already written
+
+        while(i < pieces_.size())
+        {
+            iovec iov[iov_batch];
+            int cnt = 0;
+            for(size_t k = i; k < pieces_.size() && cnt < iov_batch; ++k, ++cnt)
+            {
+                size_t off = (k == i) ? skip : 0;
+                iov[cnt].iov_base = const_cast<char*>(pieces_[k].p + off);
+                iov[cnt].iov_len = pieces_[k].len - off;
+            }
+
+            ssize_t res = ::writev(fd, iov, cnt);
+            if (res <= 0)
+            {
+                if (res < 0 && errno == EINTR) continue;
+                if (res == 0) errno = EIO;  // no progress (pieces are never empty) -- don't spin
+                drop_written_(i, skip);     // next flush() continues from here
+                return false;
+            }
+
+            // advance over written data (partial writes are possible)
+            for(size_t written = size_t(res); written; )
+            {
+                size_t left = pieces_[i].len - skip;
+                if (written < left) { skip += written; break; }
+                written -= left;
+                skip = 0;
+                ++i;
+            }
+        }
+
+        clear();
+        return true;
+    }
+
+private:
+    // drop first i pieces and first skip bytes of pieces_[i]
+    void drop_written_(size_t i, size_t skip)
+    {
+        for(size_t k = 0; k < i; ++k) total_ -= pieces_[k].len;
+        pieces_.erase(pieces_.begin(), pieces_.begin() + i);
+        if (skip)
+        {
+            pieces_.front() = pieces_.front().right(pieces_.front().len - skip);
+            total_ -= skip;
+        }
+    }
+#endif
+};
+
+
+//------------------------------------------------------------------------------
+} // namespace parray_iovec_pvt_
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+using parray_iovec_pvt_::iovec_builder;
+
+
+//------------------------------------------------------------------------------
+} // namespace adv
+//------------------------------------------------------------------------------
+
+
+#endif //PARRAY_IOVEC_H_2026_10_18_14_22_19_530_H_
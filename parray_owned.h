@@ -0,0 +1,401 @@
+/*/////////////////////////////////////////////////////////////////////////////
+    ADV library
+
+  Author:
+    Michael Kilburn
+
+/////////////////////////////////////////////////////////////////////////////*/
+
+
+#ifndef PARRAY_OWNED_H_2026_10_18_17_12_08_406_H_
+#define PARRAY_OWNED_H_2026_10_18_17_12_08_406_H_
+
+
+#include "parray.h"
+#include <type_traits>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <stdexcept>
+#include <functional>
+#include <ostream>
+
+
+//------------------------------------------------------------------------------
+// Owning arrays
+//
+//  fixed_string<N, T, Traits>      -- up to N elements stored inline (no heap, no NUL maintenance)
+//  owned_parray<T, A, Traits>      -- growable array allocated with allocator A (no NUL maintenance)
+//
+//  Both are meant for places where parray content has to be kept after its source is gone (e.g. keys of a cache)
+// without paying for std::string (SSO branch on every access, NUL written on every append). Both implicitly convert
+// to parray<T const, Traits> (and parray<T, Traits> if non-const) and are compared with same trait-based operators
+// against each other, parray, ntbs and anything else parray can be compared with:
+//
+//      fixed_string<16> k{ ntba("Content-Length") };
+//      assert( k == ntba("Content-Length") );
+//      rcstring r = k;                             // view, valid while k is alive and unchanged
+//
+//      owned_parray<char> buf;
+//      buf.append(ntba("user="));
+//      buf.append(name);
+//      if (buf < k) ...
+//
+//  view()                          -- parray<T const, Traits> over content
+//  size(), empty(), capacity()
+//  data(), operator[], begin(), end()
+//  assign(v), append(v), push_back(e), resize(n), clear()
+//
+// Notes:
+//  - exceeding N in fixed_string throws std::length_error
+//  - elements have to be trivially copyable (content is moved around with memcpy)
+//  - views are invalidated by any modification (owned_parray may reallocate, fixed_string elements get overwritten)
+//  - std::hash is specialized for both (uses Traits::hash(), like parray)
+//
+
+
+//------------------------------------------------------------------------------
+namespace adv { namespace parray_owned_pvt_ {
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+using std::size_t;
+using adv::parray;
+using adv::parray_traits;
+
+template<class T> using remove_cv = std::remove_cv_t<T>;
+template<bool B, class T = void> using enable_if = std::enable_if_t<B, T>;
+
+
+//------------------------------------------------------------------------------
+template<size_t N, class T = char, class Traits = parray_traits>
+class fixed_string
+{
+    static_assert(std::is_trivially_copyable<T>::value && !std::is_const<T>::value && !std::is_volatile<T>::value, "fixed_string<N, T>: T has to be trivially copyable non-cv type");
+
+    size_t len_ = 0;
+    T data_[N ? N : 1];
+
+    void check_(size_t n) const { if (n > N) throw std::length_error("fixed_string: capacity exceeded"); }
+
+public:
+    using value_type = T;
+    using view_type = parray<T const, Traits>;
+
+    fixed_string() = default;
+
+    template<class E, enable_if<std::is_same<remove_cv<E>, T>::value>...>
+    fixed_string(parray<E, Traits> v) { assign(v); }
+
+    // copy (content only)
+    fixed_string(fixed_string const& o) : len_(o.len_) { std::memcpy(data_, o.data_, len_ * sizeof(T)); }
+    fixed_string& operator=(fixed_string const& o) { len_ = o.len_; std::memcpy(data_, o.data_, len_ * sizeof(T)); return *this; }
+
+    // content
+    size_t size() const             { return len_; }
+    bool empty() const              { return len_ == 0; }
+    static constexpr size_t capacity() { return N; }
+
+    T* data()                       { return data_; }
+    T const* data() const           { return data_; }
+    T& operator[](size_t i)         { return data_[i]; }
+    T const& operator[](size_t i) const { return data_[i]; }
+
+    T* begin()                      { return data_; }
+    T* end()                        { return data_ + len_; }
+    T const* begin() const          { return data_; }
+    T const* end() const            { return data_ + len_; }
+
+    view_type view() const          { return {len_, data_}; }
+    operator parray<T const, Traits>() const { return {len_, data_}; }
+    operator parray<T, Traits>()    { return {len_, data_}; }
+
+    // modification
+    template<class E, enable_if<std::is_same<remove_cv<E>, T>::value>...>
+    fixed_string& assign(parray<E, Traits> v)
+    {
+        check_(v.len);
+        if (v.len) std::memmove(data_, v.p, v.len * sizeof(T));
+        len_ = v.len;
+        return *this;
+    }
+
+    template<class E, enable_if<std::is_same<remove_cv<E>, T>::value>...>
+    fixed_string& append(parray<E, Traits> v)
+    {
+        check_(len_ + v.len);
+        if (v.len) std::memmove(data_ + len_, v.p, v.len * sizeof(T));
+        len_ += v.len;
+        return *this;
+    }
+
+    void push_back(T e)             { check_(len_ + 1); data_[len_++] = e; }
+    void resize(size_t n, T e = T()){ check_(n); for(; len_ < n; ++len_) data_[len_] = e; len_ = n; }
+    void clear()                    { len_ = 0; }
+};
+
+
+//------------------------------------------------------------------------------
+template<class T, class A = std::allocator<T>, class Traits = parray_traits>
+class owned_parray
+{
+    static_assert(std::is_trivially_copyable<T>::value && !std::is_const<T>::value && !std::is_volatile<T>::value, "owned_parray<T>: T has to be trivially copyable non-cv type");
+
+    using alloc_traits = std::allocator_traits<A>;
+
+    struct impl_ : A    // empty allocator takes no space
+    {
+        T* p = nullptr;
+        size_t len = 0;
+        size_t cap = 0;
+
+        impl_(A const& a) : A(a) {}
+    } m_;
+
+    A& alloc_() { return m_; }
+    A const& alloc_() const { return m_; }
+
+    enum : size_t { min_growth = 32 };
+
+    // ensure capacity for n elements (exact -- allocate only what is asked for, otherwise -- leave room for appends)
+    void grow_(size_t n, bool exact = false)
+    {
+        if (n <= m_.cap) return;
+
+        size_t cap = exact ? n : m_.cap * 2;
+        if (cap < n) cap = n;
+        if (!exact && cap < min_growth) cap = min_growth;
+
+        realloc_(cap);
+    }
+
+    // move content into new buffer of given capacity (cap >= len, cap > 0), allocated with our allocator
+    void realloc_(size_t cap)
+    {
+        T* p = alloc_traits::allocate(alloc_(), cap);
+        if (m_.len) std::memcpy(p, m_.p, m_.len * sizeof(T));
+        if (m_.p) alloc_traits::deallocate(alloc_(), m_.p, m_.cap);
+        m_.p = p;
+        m_.cap = cap;
+    }
+
+    void release_()
+    {
+        if (m_.p) alloc_traits::deallocate(alloc_(), m_.p, m_.cap);
+        m_.p = nullptr;
+        m_.len = m_.cap = 0;
+    }
+
+public:
+    using value_type = T;
+    using allocator_type = A;
+    using view_type = parray<T const, Traits>;
+
+    explicit owned_parray(A const& a = A()) : m_(a) {}
+
+    template<class E, enable_if<std::is_same<remove_cv<E>, T>::value>...>
+    owned_parray(parray<E, Traits> v, A const& a = A()) : m_(a) { assign(v); }
+
+    owned_parray(owned_parray const& o)
+        : m_(alloc_traits::select_on_container_copy_construction(o.m_))
+    {
+        assign(o.view());
+    }
+
+    owned_parray(owned_parray&& o) noexcept : m_(std::move(o.alloc_())) { swap_(o); }
+
+    owned_parray& operator=(owned_parray const& o)
+    {
+        if (this != &o) copy_assign_(o, typename alloc_traits::propagate_on_container_copy_assignment());
+        return *this;
+    }
+
+    owned_parray& operator=(owned_parray&& o)
+    {
+        if (this != &o) move_assign_(o, typename alloc_traits::propagate_on_container_move_assignment());
+        return *this;
+    }
+
+    ~owned_parray() { release_(); }
+
+private:
+    void swap_(owned_parray& o) noexcept
+    {
+        std::swap(m_.p, o.m_.p);
+        std::swap(m_.len, o.m_.len);
+        std::swap(m_.cap, o.m_.cap);
+    }
+
+    // allocator propagation (dispatched on POCCA/POCMA, allocator assignment is used only if it propagates)
+    void copy_assign_(owned_parray const& o, std::true_type)
+    {
+        if (!(alloc_() == o.alloc_())) release_();  // our memory can't be deallocated with new allocator
+        alloc_() = o.alloc_();
+        assign(o.view());
+    }
+
+    void copy_assign_(owned_parray const& o, std::false_type) { assign(o.view()); }
+
+    void move_assign_(owned_parray& o, std::true_type)
+    {
+        release_();
+        alloc_() = std::move(o.alloc_());
+        swap_(o);
+    }
+
+    void move_assign_(owned_parray& o, std::false_type)
+    {
+        if (alloc_() == o.alloc_())
+        {
+            release_();
+            swap_(o);
+        }
+        else    // memory of 'o' can't be deallocated with our allocator
+            assign(o.view());
+    }
+
+public:
+    A get_allocator() const         { return m_; }
+
+    // content
+    size_t size() const             { return m_.len; }
+    bool empty() const              { return m_.len == 0; }
+    size_t capacity() const         { return m_.cap; }
+
+    T* data()                       { return m_.p; }
+    T const* data() const           { return m_.p; }
+    T& operator[](size_t i)         { return m_.p[i]; }
+    T const& operator[](size_t i) const { return m_.p[i]; }
+
+    T* begin()                      { return m_.p; }
+    T* end()                        { return m_.p + m_.len; }
+    T const* begin() const          { return m_.p; }
+    T const* end() const            { return m_.p + m_.len; }
+
+    view_type view() const          { return {m_.len, m_.p}; }
+    operator parray<T const, Traits>() const { return {m_.len, m_.p}; }
+    operator parray<T, Traits>()    { return {m_.len, m_.p}; }
+
+    // modification
+    void reserve(size_t n)          { grow_(n, true); }
+
+    template<class E, enable_if<std::is_same<remove_cv<E>, T>::value>...>
+    owned_parray& assign(parray<E, Traits> v)
+    {
+        if (v.len > m_.cap)     // v may point into our buffer -- copy before releasing it
+        {
+            owned_parray tmp(alloc_());
+            tmp.grow_(v.len, true);
+            std::memcpy(tmp.m_.p, v.p, v.len * sizeof(T));
+            tmp.m_.len = v.len;
+            release_();
+            swap_(tmp);
+        }
+        else
+        {
+            if (v.len) std::memmove(m_.p, v.p, v.len * sizeof(T));
+            m_.len = v.len;
+        }
+        return *this;
+    }
+
+    template<class E, enable_if<std::is_same<remove_cv<E>, T>::value>...>
+    owned_parray& append(parray<E, Traits> v)
+    {
+        if (m_.len + v.len > m_.cap)
+        {
+            if (v.len && v.p >= m_.p && v.p < m_.p + m_.len)    // appending part of itself
+            {
+                size_t off = static_cast<size_t>(v.p - m_.p);
+                grow_(m_.len + v.len);
+                v.p = m_.p + off;
+            }
+            else
+                grow_(m_.len + v.len);
+        }
+        if (v.len) std::memmove(m_.p + m_.len, v.p, v.len * sizeof(T));
+        m_.len += v.len;
+        return *this;
+    }
+
+    void push_back(T e)             { grow_(m_.len + 1); m_.p[m_.len++] = e; }
+    void resize(size_t n, T e = T()){ grow_(n); for(; m_.len < n; ++m_.len) m_.p[m_.len] = e; m_.len = n; }
+    void clear()                    { m_.len = 0; }
+    void shrink_to_fit()            { if (m_.len < m_.cap) { if (m_.len) realloc_(m_.len); else release_(); } }
+};
+
+
+//------------------------------------------------------------------------------
+// comparisons -- forwarded to parray operators (i.e. to Traits)
+//
+template<class X> struct is_owned_ : std::false_type {};
+template<size_t N, class T, class Traits> struct is_owned_<fixed_string<N, T, Traits>> : std::true_type {};
+template<class T, class A, class Traits> struct is_owned_<owned_parray<T, A, Traits>> : std::true_type {};
+
+template<class X> constexpr bool is_owned = is_owned_<X>::value;
+
+// owned vs owned
+template<class L, class R, enable_if<is_owned<L> && is_owned<R>>...> auto operator==(L const& l, R const& r) -> decltype(l.view() == r.view()) { return l.view() == r.view(); }
+template<class L, class R, enable_if<is_owned<L> && is_owned<R>>...> auto operator!=(L const& l, R const& r) -> decltype(l.view() != r.view()) { return l.view() != r.view(); }
+template<class L, class R, enable_if<is_owned<L> && is_owned<R>>...> auto operator< (L const& l, R const& r) -> decltype(l.view() <  r.view()) { return l.view() <  r.view(); }
+template<class L, class R, enable_if<is_owned<L> && is_owned<R>>...> auto operator> (L const& l, R const& r) -> decltype(l.view() >  r.view()) { return l.view() >  r.view(); }
+template<class L, class R, enable_if<is_owned<L> && is_owned<R>>...> auto operator<=(L const& l, R const& r) -> decltype(l.view() <= r.view()) { return l.view() <= r.view(); }
+template<class L, class R, enable_if<is_owned<L> && is_owned<R>>...> auto operator>=(L const& l, R const& r) -> decltype(l.view() >= r.view()) { return l.view() >= r.view(); }
+
+// owned vs anything parray can be compared with (parray, ntbs, string, vector, ...)
+template<class L, class R, enable_if<is_owned<L> && !is_owned<R>>...> auto operator==(L const& l, R const& r) -> decltype(l.view() == r) { return l.view() == r; }
+template<class L, class R, enable_if<is_owned<L> && !is_owned<R>>...> auto operator!=(L const& l, R const& r) -> decltype(l.view() != r) { return l.view() != r; }
+template<class L, class R, enable_if<is_owned<L> && !is_owned<R>>...> auto operator< (L const& l, R const& r) -> decltype(l.view() <  r) { return l.view() <  r; }
+template<class L, class R, enable_if<is_owned<L> && !is_owned<R>>...> auto operator> (L const& l, R const& r) -> decltype(l.view() >  r) { return l.view() >  r; }
+template<class L, class R, enable_if<is_owned<L> && !is_owned<R>>...> auto operator<=(L const& l, R const& r) -> decltype(l.view() <= r) { return l.view() <= r; }
+template<class L, class R, enable_if<is_owned<L> && !is_owned<R>>...> auto operator>=(L const& l, R const& r) -> decltype(l.view() >= r) { return l.view() >= r; }
+
+template<class L, class R, enable_if<!is_owned<L> && is_owned<R>>...> auto operator==(L const& l, R const& r) -> decltype(l == r.view()) { return l == r.view(); }
+template<class L, class R, enable_if<!is_owned<L> && is_owned<R>>...> auto operator!=(L const& l, R const& r) -> decltype(l != r.view()) { return l != r.view(); }
+template<class L, class R, enable_if<!is_owned<L> && is_owned<R>>...> auto operator< (L const& l, R const& r) -> decltype(l <  r.view()) { return l <  r.view(); }
+template<class L, class R, enable_if<!is_owned<L> && is_owned<R>>...> auto operator> (L const& l, R const& r) -> decltype(l >  r.view()) { return l >  r.view(); }
+template<class L, class R, enable_if<!is_owned<L> && is_owned<R>>...> auto operator<=(L const& l, R const& r) -> decltype(l <= r.view()) { return l <= r.view(); }
+template<class L, class R, enable_if<!is_owned<L> && is_owned<R>>...> auto operator>=(L const& l, R const& r) -> decltype(l >= r.view()) { return l >= r.view(); }
+
+// ostream <<
+template<class E, class Tr, class X, enable_if<is_owned<X>>...>
+auto operator<<(std::basic_ostream<E, Tr>& os, X const& v) -> decltype(os << v.view()) { return os << v.view(); }
+
+
+//------------------------------------------------------------------------------
+} // namespace parray_owned_pvt_
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+using parray_owned_pvt_::fixed_string;
+using parray_owned_pvt_::owned_parray;
+
+
+//------------------------------------------------------------------------------
+} // namespace adv
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+// owned arrays as keys of unordered containers (same hash as parray views of them)
+//
+namespace std {
+
+template<size_t N, class T, class Traits>
+struct hash<adv::fixed_string<N, T, Traits>>
+{
+    size_t operator()(adv::fixed_string<N, T, Traits> const& v) const { return Traits::hash(v.size(), v.data()); }
+};
+
+template<class T, class A, class Traits>
+struct hash<adv::owned_parray<T, A, Traits>>
+{
+    size_t operator()(adv::owned_parray<T, A, Traits> const& v) const { return Traits::hash(v.size(), v.data()); }
+};
+
+} // namespace std
+
+
+#endif //PARRAY_OWNED_H_2026_10_18_17_12_08_406_H_
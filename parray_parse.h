@@ -0,0 +1,446 @@
+/*/////////////////////////////////////////////////////////////////////////////
+    ADV library
+
+  Author:
+    Michael Kilburn
+
+/////////////////////////////////////////////////////////////////////////////*/
+
+
+#ifndef PARRAY_PARSE_H_2026_10_18_10_12_41_317_H_
+#define PARRAY_PARSE_H_2026_10_18_10_12_41_317_H_
+
+
+#include "parray.h"
+#include <type_traits>
+#include <limits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <string>
+
+
+//------------------------------------------------------------------------------
+// parray<> number parsing
+//
+//  parse_result<T> parse<T>(parray v)                  T is integral, base 10
+//  parse_result<T> parse<T>(parray v, unsigned base)   T is integral, base is in [2, 36]
+//  parse_result<T> parse<T>(parray v)                  T is floating point
+//      parse number at the beginning of v (v doesn't need to be nul-terminated)
+//
+//  parse_result<T>
+//      value       -- parsed value (0 if nothing was parsed, clamped to [min, max] on overflow)
+//      consumed    -- number of elements consumed (0 if nothing was parsed)
+//      error       -- parse_error::none, ::invalid (no number at the beginning of v) or ::overflow
+//
+// Notes:
+//  - accepted syntax is similar to strtol/strtod, but leading whitespaces are not skipped:
+//      integral:       [+|-][0x|0X]digits      ('-' only for signed T, '0x' only for base 16)
+//      floating point: [+|-]digits[.digits][(e|E)[+|-]digits], [+|-]inf, [+|-]infinity, [+|-]nan (case-insensitive)
+//  - on overflow all digits are still consumed (i.e. you can continue parsing right after the number)
+//  - base 10 integers are parsed 8 digits at a time (SWAR) on little-endian platforms
+//  - floating point numbers with no more than 19 significant digits and small exponent are converted exactly
+//    without calling library (Clinger's fast path), the rest is passed to strtod() via small stack buffer;
+//    only numbers longer than that buffer cause memory allocation
+//  - strtod() fallback is affected by current C locale (decimal point)
+//
+// Example:
+//
+//      rcstring data = ntba("123,-45.5e1");
+//      auto r1 = parse<int>(data);                     // r1.value == 123, r1.consumed == 3
+//      auto r2 = parse<double>(data.mid(4, 7));        // r2.value == -455.0, r2.consumed == 7
+//
+
+
+//------------------------------------------------------------------------------
+namespace adv { namespace parray_parse_pvt_ {
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+using std::size_t;
+using std::uint64_t;
+using std::uint32_t;
+using std::numeric_limits;
+using adv::parray;
+
+template<bool B, class T = void> using enable_if = std::enable_if_t<B, T>;
+template<class T> using make_unsigned = std::make_unsigned_t<T>;
+template<class T> constexpr bool is_integral = std::is_integral<T>::value && !std::is_same<T, bool>::value;
+template<class T> constexpr bool is_floating_point = std::is_floating_point<T>::value;
+template<class T> constexpr bool is_signed = std::is_signed<T>::value;
+template<class F, class T> constexpr bool is_convertible = std::is_convertible<F, T>::value;
+
+// we parse any non-volatile char array
+template<class E> constexpr bool is_text = (sizeof(E) == 1) && is_convertible<E*, char const*>;
+
+
+//------------------------------------------------------------------------------
+enum class parse_error { none, invalid, overflow };
+
+template<class T>
+struct parse_result
+{
+    T           value;
+    size_t      consumed;
+    parse_error error;
+
+    explicit operator bool() const { return error == parse_error::none; }
+};
+
+
+//------------------------------------------------------------------------------
+// Helpers
+//
+
+// value of digit in base 36 or 36 if c is not a digit
+inline unsigned digit_val(char c)
+{
+    unsigned u = static_cast<unsigned char>(c);
+    if (u - '0' < 10u) return u - '0';
+    u |= 0x20;                                  // to lower case
+    if (u - 'a' < 26u) return u - 'a' + 10;
+    return 36;
+}
+
+inline bool is_digit(char c) { return unsigned(static_cast<unsigned char>(c)) - '0' < 10u; }
+
+inline bool ieq_prefix(char const* p, size_t len, char const* lower_word, size_t word_len)
+{
+    if (len < word_len) return false;
+    for(size_t i = 0; i < word_len; ++i)
+        if ((p[i] | 0x20) != lower_word[i]) return false;
+    return true;
+}
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ || defined(_M_IX86) || defined(_M_X64) || defined(_M_ARM64)
+#   define PARRAY_PARSE_SWAR_
+#endif
+
+#ifdef PARRAY_PARSE_SWAR_
+// loads 8 chars (first char ends up in the least significant byte)
+inline uint64_t load8(char const* p) { uint64_t v; std::memcpy(&v, p, sizeof(v)); return v; }
+
+inline bool all_digits8(uint64_t v)
+{
+    return ((v & 0xF0F0F0F0F0F0F0F0ull) == 0x3030303030303030ull) &&               // all bytes are in [0x30, 0x3F]
+           (((v + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) == 0x3030303030303030ull);   // ... and none of them is above 0x39
+}
+
+// see "Fast numeric string to int" by D.Lemire
+inline uint32_t digits8_val(uint64_t v)
+{
+    v -= 0x3030303030303030ull;
+    v = (v * 10) + (v >> 8);                                                        // pairs of digits
+    v = (((v & 0x000000FF000000FFull) * 0x000F424000000064ull) +                    // 100 + (1000000 << 32)
+         (((v >> 16) & 0x000000FF000000FFull) * 0x0000271000000001ull)) >> 32;      // 1 + (10000 << 32)
+    return static_cast<uint32_t>(v);
+}
+#endif
+
+
+//------------------------------------------------------------------------------
+// parse digits [p, p_end) into u, sets 'ovf' if value doesn't fit into uint64_t
+// returns pointer to first non-digit
+inline char const* parse_digits10(char const* p, char const* p_end, uint64_t& u, bool& ovf)
+{
+    constexpr uint64_t max = numeric_limits<uint64_t>::max();
+
+#ifdef PARRAY_PARSE_SWAR_
+    for(; p_end - p >= 8; p += 8)
+    {
+        uint64_t v = load8(p);
+        if (!all_digits8(v)) break;
+
+        uint64_t d = digits8_val(v);
+        if (u > (max - d) / 100000000u) ovf = true;
+        u = u * 100000000u + d;
+    }
+#endif
+
+    for(; p != p_end; ++p)
+    {
+        unsigned d = static_cast<unsigned char>(*p) - '0';
+        if (d >= 10) break;
+
+        if (u > (max - d) / 10) ovf = true;
+        u = u * 10 + d;
+    }
+    return p;
+}
+
+inline char const* parse_digits(char const* p, char const* p_end, unsigned base, uint64_t& u, bool& ovf)
+{
+    if (base == 10) return parse_digits10(p, p_end, u, ovf);
+
+    uint64_t const max = numeric_limits<uint64_t>::max();
+    for(; p != p_end; ++p)
+    {
+        unsigned d = digit_val(*p);
+        if (d >= base) break;
+
+        if (u > (max - d) / base) ovf = true;
+        u = u * base + d;
+    }
+    return p;
+}
+
+
+//------------------------------------------------------------------------------
+template<class T>
+parse_result<T> parse_int_(char const* const p_beg, char const* const p_end, unsigned base)
+{
+    using U = make_unsigned<T>;
+
+    parse_result<T> res{ T(), 0, parse_error::invalid };
+    if (base < 2 || base > 36) return res;
+
+    char const* p = p_beg;
+    bool neg = false;
+    if (p != p_end && (*p == '-' || *p == '+'))
+    {
+        neg = (*p == '-');
+        if (neg && !is_signed<T>) return res;
+        ++p;
+    }
+
+    // optional '0x' prefix, it gets consumed only if followed by hex digit
+    if (base == 16 && p_end - p > 2 && p[0] == '0' && (p[1] | 0x20) == 'x' && digit_val(p[2]) < 16)
+        p += 2;
+
+    uint64_t u = 0;
+    bool ovf = false;
+    char const* p_num = p;
+    p = parse_digits(p, p_end, base, u, ovf);
+    if (p == p_num) return res;                             // no digits
+
+    res.consumed = p - p_beg;
+    res.error = parse_error::none;
+
+    // max magnitude of representable value
+    uint64_t const lim = neg ? uint64_t(U(numeric_limits<T>::max()) + 1u) : uint64_t(numeric_limits<T>::max());
+    if (ovf || u > lim)
+    {
+        res.error = parse_error::overflow;
+        res.value = neg ? numeric_limits<T>::min() : numeric_limits<T>::max();
+    }
+    else
+        res.value = neg ? static_cast<T>(U(0) - static_cast<U>(u)) : static_cast<T>(u);
+
+    return res;
+}
+
+
+//------------------------------------------------------------------------------
+// floating point
+//
+
+inline double pow10_exact(unsigned e)       // e <= 22
+{
+    static double const tbl[] = { 1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    return tbl[e];
+}
+
+template<class T> inline T strto_(char const* p, char** p_end);
+template<> inline float       strto_<float      >(char const* p, char** p_end) { return std::strtof (p, p_end); }
+template<> inline double      strto_<double     >(char const* p, char** p_end) { return std::strtod (p, p_end); }
+template<> inline long double strto_<long double>(char const* p, char** p_end) { return std::strtold(p, p_end); }
+
+// slow path -- make a nul-terminated copy and let library deal with it
+template<class T>
+void parse_float_slow_(char const* p, size_t len, parse_result<T>& res)
+{
+    char buf[128];
+    std::string tmp;
+    char const* s = buf;
+    if (len < sizeof(buf))
+    {
+        std::memcpy(buf, p, len);
+        buf[len] = '\0';
+    }
+    else
+    {
+        tmp.assign(p, len);
+        s = tmp.c_str();
+    }
+
+    int saved_errno = errno;
+    errno = 0;
+
+    char* s_end = nullptr;
+    T v = strto_<T>(s, &s_end);
+
+    if (errno == ERANGE && (v == numeric_limits<T>::infinity() || v == -numeric_limits<T>::infinity()))
+        res.error = parse_error::overflow;
+    errno = saved_errno;
+
+    res.value = v;
+    res.consumed = s_end - s;       // should be equal to len, unless locale uses different decimal point
+    if (res.consumed == 0) res.error = parse_error::invalid;
+}
+
+template<class T>
+parse_result<T> parse_float_(char const* const p_beg, char const* const p_end)
+{
+    parse_result<T> res{ T(), 0, parse_error::invalid };
+
+    char const* p = p_beg;
+    bool neg = false;
+    if (p != p_end && (*p == '-' || *p == '+'))
+    {
+        neg = (*p == '-');
+        ++p;
+    }
+
+    // inf/nan
+    if (p != p_end && !is_digit(*p) && *p != '.')
+    {
+        size_t len = p_end - p;
+        if (ieq_prefix(p, len, "inf", 3))
+        {
+            res.value = neg ? -numeric_limits<T>::infinity() : numeric_limits<T>::infinity();
+            res.consumed = (p - p_beg) + (ieq_prefix(p, len, "infinity", 8) ? 8 : 3);
+            res.error = parse_error::none;
+        }
+        else if (ieq_prefix(p, len, "nan", 3))
+        {
+            res.value = neg ? -numeric_limits<T>::quiet_NaN() : numeric_limits<T>::quiet_NaN();
+            res.consumed = (p - p_beg) + 3;
+            res.error = parse_error::none;
+        }
+        return res;
+    }
+
+    // mantissa: collect up to 19 significant digits
+    uint64_t w = 0;
+    unsigned sig = 0;           // significant digits in w
+    bool truncated = false;     // true if we had to drop non-zero digits
+    int e10 = 0;
+    bool any = false;
+
+    for(; p != p_end && is_digit(*p); ++p, any = true)
+    {
+        unsigned d = *p - '0';
+        if (sig < 19)
+        {
+            w = w * 10 + d;
+            sig += (w != 0);
+        }
+        else
+        {
+            ++e10;
+            truncated |= (d != 0);
+        }
+    }
+
+    if (p != p_end && *p == '.')
+    {
+        char const* p_frac = ++p;
+        for(; p != p_end && is_digit(*p); ++p)
+        {
+            unsigned d = *p - '0';
+            if (sig < 19)
+            {
+                w = w * 10 + d;
+                sig += (w != 0);
+                --e10;
+            }
+            else
+                truncated |= (d != 0);
+        }
+        any |= (p != p_frac);
+    }
+
+    if (!any) return res;       // no digits in mantissa
+
+    // exponent (consumed only if it has digits)
+    if (p != p_end && (*p | 0x20) == 'e')
+    {
+        char const* q = p + 1;
+        bool e_neg = false;
+        if (q != p_end && (*q == '-' || *q == '+')) e_neg = (*q++ == '-');
+
+        if (q != p_end && is_digit(*q))
+        {
+            int e = 0;
+            for(; q != p_end && is_digit(*q); ++q)
+                if (e < 100000) e = e * 10 + (*q - '0');
+            e10 += e_neg ? -e : e;
+            p = q;
+        }
+    }
+
+    res.consumed = p - p_beg;
+    res.error = parse_error::none;
+
+    // Clinger's fast path: both w and 10^|e10| are exactly representable, result is correctly rounded (float has its
+    // own path -- rounding to double and then to float may be off by 1 ulp)
+    if (!truncated && std::is_same<T, float>::value)
+    {
+        if (w <= (uint64_t(1) << 24) && -10 <= e10 && e10 <= 10)
+        {
+            float f = static_cast<float>(w);
+            f = (e10 < 0) ? f / static_cast<float>(pow10_exact(-e10)) : f * static_cast<float>(pow10_exact(e10));
+            res.value = static_cast<T>(neg ? -f : f);
+            return res;
+        }
+    }
+    else if (!truncated && w <= (uint64_t(1) << 53) && -22 <= e10 && e10 <= 22 && std::is_same<T, double>::value)
+    {
+        double d = static_cast<double>(w);
+        d = (e10 < 0) ? d / pow10_exact(-e10) : d * pow10_exact(e10);
+        res.value = static_cast<T>(neg ? -d : d);
+        return res;
+    }
+
+    if (w == 0 && !truncated)
+    {
+        res.value = neg ? -T() : T();
+        return res;
+    }
+
+    parse_float_slow_(p_beg, res.consumed, res);
+    return res;
+}
+
+
+//------------------------------------------------------------------------------
+// parse() family
+//
+template<class T, class E, class Tr, enable_if<is_integral<T> && is_text<E>>...>
+inline parse_result<T> parse(parray<E, Tr> v, unsigned base = 10)
+{
+    char const* p = v.p;
+    return parse_int_<T>(p, p + v.len, base);
+}
+
+template<class T, class E, class Tr, enable_if<is_floating_point<T> && is_text<E>>...>
+inline parse_result<T> parse(parray<E, Tr> v)
+{
+    char const* p = v.p;
+    return parse_float_<T>(p, p + v.len);
+}
+
+
+#undef PARRAY_PARSE_SWAR_
+
+
+//------------------------------------------------------------------------------
+} // namespace parray_parse_pvt_
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+using parray_parse_pvt_::parse_error;
+using parray_parse_pvt_::parse_result;
+using parray_parse_pvt_::parse;
+
+
+//------------------------------------------------------------------------------
+} // namespace adv
+//------------------------------------------------------------------------------
+
+
+#endif //PARRAY_PARSE_H_2026_10_18_10_12_41_317_H_
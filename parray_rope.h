@@ -0,0 +1,268 @@
+/*/////////////////////////////////////////////////////////////////////////////
+    ADV library
+
+  Author:
+    Michael Kilburn
+
+/////////////////////////////////////////////////////////////////////////////*/
+
+
+#ifndef PARRAY_ROPE_H_2026_10_18_18_21_57_664_H_
+#define PARRAY_ROPE_H_2026_10_18_18_21_57_664_H_
+
+
+#include "parray.h"
+#include "parray_tools.h"
+#include <type_traits>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <iterator>
+
+
+//------------------------------------------------------------------------------
+// parray_rope<T, Traits>
+//
+//  Sequence of borrowed fragments (parray<T const, Traits>) that represents their concatenation without building it,
+// e.g. output of templating code that glues together thousands of pieces. Fragments are kept in fixed-size chunks
+// (appending never moves them) along with running offsets, so:
+//
+//  size()                          -- total length, O(1)
+//  operator[](i)                   -- i-th element of concatenation, O(log n)
+//  for_each(f)                     -- f(parray v) for every fragment (e.g. to write them out)
+//  for_each(pos, cnt, f)           -- same for [pos, pos + cnt) part of concatenation (fragments are cut accordingly)
+//  copy_to(buf, size, pos = 0)     -- copy part of concatenation starting at pos, returns copied part
+//  flatten(buf)                    -- copy entire concatenation into buf (has to have room for size() elements)
+//  flatten(alloc)                  -- same, memory is obtained once from alloc(size()) (e.g. arena), returns view of it
+//  append_to(R& r)                 -- append concatenation to container R (see join() in parray_tools.h)
+//
+//  append(parray v)                -- borrow v (empty arrays are skipped)
+//  append(rope)                    -- borrow fragments of another rope (or of itself)
+//  [r]join[_se](it, it_end, delim) -- borrow range of arrays separated by delim (see join() in parray_tools.h)
+//  fragments()                     -- number of fragments
+//  clear()                         -- drop content, chunks are retained for reuse
+//
+// Example:
+//
+//      parray_rope<char> r;
+//      r.append(ntba("<li>"));
+//      r.append(item.name);
+//      r.append(ntba("</li>"));
+//      ...
+//      if (r.size() > limit) ...               // no concatenation happened so far
+//      r.for_each([&](rcstring v) { out.write(v.p, v.len); });
+//
+// Notes:
+//  - fragments are borrowed -- memory they point to has to outlive the rope (except for single value delimiters of
+//    join(), rope keeps copies of them)
+//  - rope isn't copyable (it may own join() delimiters), but it is movable
+//
+
+
+//------------------------------------------------------------------------------
+namespace adv { namespace parray_rope_pvt_ {
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+using std::size_t;
+using std::vector;
+using std::unique_ptr;
+using std::make_reverse_iterator;
+using adv::parray;
+using adv::parray_traits;
+
+template<class T> using remove_cv = std::remove_cv_t<T>;
+template<bool B, class T = void> using enable_if = std::enable_if_t<B, T>;
+
+
+//------------------------------------------------------------------------------
+template<class T = char, class Traits = parray_traits>
+class parray_rope
+{
+public:
+    using value_type = remove_cv<T>;
+    using piece_type = parray<T const, Traits>;
+
+private:
+    enum : size_t { chunk_size = 64 };
+
+    struct chunk
+    {
+        size_t end[chunk_size];         // end[i] -- offset of the end of piece[i] within concatenation
+        piece_type piece[chunk_size];
+    };
+
+    vector<unique_ptr<chunk>> chunks_;  // chunks_[0..used_) are in use (rest is retained for reuse)
+    vector<size_t> chunk_end_;          // offset of the end of last piece in chunk (i.e. running total)
+    size_t used_ = 0;                   // chunks in use
+    size_t last_count_ = 0;             // pieces in last used chunk
+    size_t total_ = 0;
+    size_t count_ = 0;
+    std::deque<value_type> delims_;     // copies of single value join() delimiters
+
+    void add_(piece_type v)
+    {
+        if (v.len == 0) return;
+
+        if (used_ == 0 || last_count_ == chunk_size)
+        {
+            if (used_ == chunks_.size()) chunks_.emplace_back(new chunk);
+            chunk_end_.resize(used_ + 1);
+            ++used_;
+            last_count_ = 0;
+        }
+
+        total_ += v.len;
+        ++count_;
+
+        chunk& c = *chunks_[used_ - 1];
+        c.piece[last_count_] = v;
+        c.end[last_count_] = total_;
+        ++last_count_;
+        chunk_end_[used_ - 1] = total_;
+    }
+
+    size_t chunk_count_(size_t i) const { return (i + 1 == used_) ? last_count_ : size_t(chunk_size); }
+
+    // chunk and piece containing element at pos (pos < size())
+    void locate_(size_t pos, size_t& ci, size_t& pi) const
+    {
+        ci = std::upper_bound(chunk_end_.begin(), chunk_end_.begin() + used_, pos) - chunk_end_.begin();
+        chunk const& c = *chunks_[ci];
+        pi = std::upper_bound(c.end, c.end + chunk_count_(ci), pos) - c.end;
+    }
+
+    size_t start_(size_t ci, size_t pi) const   // offset of piece start
+    {
+        chunk const& c = *chunks_[ci];
+        return c.end[pi] - c.piece[pi].len;
+    }
+
+public:
+    parray_rope() = default;
+    parray_rope(parray_rope&&) = default;
+    parray_rope& operator=(parray_rope&&) = default;
+
+    // content
+    size_t size() const         { return total_; }
+    bool empty() const          { return total_ == 0; }
+    size_t fragments() const    { return count_; }
+
+    T const& operator[](size_t i) const
+    {
+        size_t ci, pi;
+        locate_(i, ci, pi);
+        return chunks_[ci]->piece[pi].p[i - start_(ci, pi)];
+    }
+
+    template<class F>
+    void for_each(F f) const
+    {
+        for(size_t ci = 0; ci < used_; ++ci)
+        {
+            chunk const& c = *chunks_[ci];
+            for(size_t pi = 0, n = chunk_count_(ci); pi < n; ++pi) f(c.piece[pi]);
+        }
+    }
+
+    template<class F>
+    void for_each(size_t pos, size_t cnt, F f) const
+    {
+        if (pos >= total_ || cnt == 0) return;
+        if (cnt > total_ - pos) cnt = total_ - pos;
+
+        size_t ci, pi;
+        locate_(pos, ci, pi);
+        size_t skip = pos - start_(ci, pi);
+        for(; ci < used_; ++ci, pi = 0)
+        {
+            chunk const& c = *chunks_[ci];
+            for(size_t n = chunk_count_(ci); pi < n; ++pi)
+            {
+                piece_type v = c.piece[pi];
+                v = v.mid(skip, (v.len - skip < cnt) ? v.len - skip : cnt);
+                skip = 0;
+                f(v);
+                cnt -= v.len;
+                if (cnt == 0) return;
+            }
+        }
+    }
+
+    parray<value_type const, Traits> copy_to(value_type* buf, size_t size, size_t pos = 0) const
+    {
+        value_type* p = buf;
+        for_each(pos, size, [&p](piece_type v) { std::copy(v.p, v.p + v.len, p); p += v.len; });
+        return {size_t(p - buf), buf};
+    }
+
+    void flatten(value_type* buf) const { copy_to(buf, total_); }
+
+    template<class A, enable_if<!std::is_pointer<A>::value>...>
+    parray<value_type, Traits> flatten(A alloc) const
+    {
+        value_type* buf = alloc(total_);
+        flatten(buf);
+        return {total_, buf};
+    }
+
+    template<class R>
+    void append_to(R& r) const
+    {
+        r.reserve(r.size() + total_);
+        for_each([&r](piece_type v) { r.insert(end(r), v.p, v.p + v.len); });
+    }
+
+    // modification
+    template<class E, class Tr, enable_if<std::is_same<remove_cv<E>, value_type>::value>...>
+    parray_rope& append(parray<E, Tr> v) { add_(piece_type(v.len, v.p)); return *this; }
+
+    parray_rope& append(parray_rope const& o)
+    {
+        // o may be *this -- iterate over fragments it had before appending
+        for(size_t ci = 0, used = o.used_, last = o.last_count_; ci < used; ++ci)
+            for(size_t pi = 0, n = (ci + 1 == used) ? last : size_t(chunk_size); pi < n; ++pi)
+                add_(o.chunks_[ci]->piece[pi]);
+        return *this;
+    }
+
+    // join family (single value delimiter gets copied, the rest is borrowed)
+    template<class I, class D> parray_rope& join    (I it, I it_end, D const& delim) { adv::join    (it, it_end, delim_(delim), [this](auto v) { this->append(v); }); return *this; }
+    template<class I, class D> parray_rope& join_se (I it, I it_end, D const& delim) { adv::join_se (it, it_end, delim_(delim), [this](auto v) { this->append(v); }); return *this; }
+    template<class I, class D> parray_rope& rjoin   (I it, I it_end, D const& delim) { adv::rjoin   (it, it_end, delim_(delim), [this](auto v) { this->append(v); }); return *this; }
+    template<class I, class D> parray_rope& rjoin_se(I it, I it_end, D const& delim) { adv::rjoin_se(it, it_end, delim_(delim), [this](auto v) { this->append(v); }); return *this; }
+
+private:
+    piece_type delim_(value_type const& v) { delims_.push_back(v); return {1, &delims_.back()}; }
+
+    template<class E, class Tr>
+    parray<E, Tr> delim_(parray<E, Tr> v) { return v; }
+
+public:
+    void clear()
+    {
+        used_ = last_count_ = total_ = count_ = 0;
+        chunk_end_.clear();
+        delims_.clear();
+    }
+};
+
+
+//------------------------------------------------------------------------------
+} // namespace parray_rope_pvt_
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+using parray_rope_pvt_::parray_rope;
+
+
+//------------------------------------------------------------------------------
+} // namespace adv
+//------------------------------------------------------------------------------
+
+
+#endif //PARRAY_ROPE_H_2026_10_18_18_21_57_664_H_
@@ -0,0 +1,277 @@
+/*/////////////////////////////////////////////////////////////////////////////
+    ADV library
+
+  Author:
+    Michael Kilburn
+
+/////////////////////////////////////////////////////////////////////////////*/
+
+
+#ifndef PARRAY_SHARED_H_2026_10_18_17_48_33_092_H_
+#define PARRAY_SHARED_H_2026_10_18_17_48_33_092_H_
+
+
+#include "parray.h"
+#include "parray_owned.h"
+#include <type_traits>
+#include <cstring>
+#include <atomic>
+#include <new>
+#include <utility>
+#include <stdexcept>
+#include <functional>
+
+
+//------------------------------------------------------------------------------
+// Reference-counted immutable buffer and slices of it
+//
+//  shared_buffer<T, Traits>        -- immutable array on the heap, shared ownership
+//  shared_slice<T, Traits>         -- part of shared_buffer that keeps the whole buffer alive
+//
+//  Meant for data (e.g. received message) that is parsed into many parray fields which have to outlive the parse
+// stage. Buffer has one atomic reference counter (stored in the same allocation as data), every slice (and buffer
+// handle) holds one reference -- so copying slice is one atomic increment and no allocation:
+//
+//      shared_buffer<char> msg{ received };                // copy of received data
+//      rcstring user = parse_user(msg.view());             // parse borrowed view as usual
+//      shared_slice<char> s = msg.share(user);             // promote field into owning slice
+//      ...                                                 // msg can go away, s keeps data alive
+//      if (s == ntba("bob")) ...
+//
+//  shared_buffer:
+//      shared_buffer(parray v)         -- copy of v
+//      shared_buffer::make(n, f)       -- buffer of n elements filled by f(T* p, size_t n) (e.g. read from socket)
+//      view(), slice()                 -- borrowed parray/shared_slice over entire content
+//      share(parray v)                 -- slice for v that points into buffer (throws std::out_of_range otherwise)
+//      use_count()                     -- number of buffer handles and slices referencing buffer
+//
+//  shared_slice:
+//      left(cnt), right(cnt), mid(pos, cnt) -- same as parray ones, resulting slices share the buffer
+//      share(parray v)                 -- slice for v that points into this slice (throws std::out_of_range otherwise)
+//      view()                          -- borrowed parray (also implicit conversion)
+//
+// Notes:
+//  - both are compared with same trait-based operators as parray (against each other, parray, ntbs, etc), std::hash is
+//    specialized for both
+//  - content is never modified after construction, so slices may be used from different threads freely
+//  - elements have to be trivially copyable
+//  - default constructed buffer/slice is empty and references nothing
+//
+
+
+//------------------------------------------------------------------------------
+namespace adv { namespace parray_shared_pvt_ {
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+using std::size_t;
+using adv::parray;
+using adv::parray_traits;
+
+template<class T> using remove_cv = std::remove_cv_t<T>;
+template<bool B, class T = void> using enable_if = std::enable_if_t<B, T>;
+
+
+//------------------------------------------------------------------------------
+// control block, elements follow it in the same allocation
+//
+struct shared_block
+{
+    std::atomic<size_t> refs;
+    size_t len;
+
+    static shared_block* create(size_t len, size_t elem_size)
+    {
+        void* mem = ::operator new(sizeof(shared_block) + len * elem_size);
+        return new(mem) shared_block{ {1}, len };
+    }
+
+    void add_ref() { refs.fetch_add(1, std::memory_order_relaxed); }
+
+    void release()
+    {
+        if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            this->~shared_block();
+            ::operator delete(this);
+        }
+    }
+
+    void* data() { return this + 1; }
+};
+
+
+template<class T, class Traits> class shared_slice;
+
+
+//------------------------------------------------------------------------------
+template<class T = char, class Traits = parray_traits>
+class shared_buffer
+{
+    static_assert(std::is_trivially_copyable<T>::value && !std::is_const<T>::value && !std::is_volatile<T>::value, "shared_buffer<T>: T has to be trivially copyable non-cv type");
+    static_assert(alignof(T) <= alignof(shared_block), "shared_buffer<T>: T is overaligned");
+
+    shared_block* b_ = nullptr;
+
+    explicit shared_buffer(shared_block* b) : b_(b) {}
+
+    T* data_() const { return b_ ? static_cast<T*>(b_->data()) : nullptr; }
+
+public:
+    using view_type = parray<T const, Traits>;
+    using slice_type = shared_slice<T, Traits>;
+
+    shared_buffer() = default;
+
+    template<class E, enable_if<std::is_same<remove_cv<E>, T>::value>...>
+    explicit shared_buffer(parray<E, Traits> v) : b_(shared_block::create(v.len, sizeof(T)))
+    {
+        if (v.len) std::memcpy(data_(), v.p, v.len * sizeof(T));
+    }
+
+    // buffer of n elements filled by f(T* p, size_t n)
+    template<class F>
+    static shared_buffer make(size_t n, F f)
+    {
+        shared_buffer r(shared_block::create(n, sizeof(T)));
+        f(r.data_(), n);
+        return r;
+    }
+
+    shared_buffer(shared_buffer const& o) : b_(o.b_) { if (b_) b_->add_ref(); }
+    shared_buffer(shared_buffer&& o) noexcept : b_(o.b_) { o.b_ = nullptr; }
+    shared_buffer& operator=(shared_buffer o) noexcept { std::swap(b_, o.b_); return *this; }
+    ~shared_buffer() { if (b_) b_->release(); }
+
+    // content
+    size_t size() const             { return b_ ? b_->len : 0; }
+    bool empty() const              { return size() == 0; }
+    T const* data() const           { return data_(); }
+    T const& operator[](size_t i) const { return data_()[i]; }
+    T const* begin() const          { return data_(); }
+    T const* end() const            { return data_() + size(); }
+
+    view_type view() const          { return {size(), data_()}; }
+    operator view_type() const      { return view(); }
+
+    size_t use_count() const        { return b_ ? b_->refs.load(std::memory_order_relaxed) : 0; }
+
+    // slices
+    slice_type slice() const        { return slice_type(b_, view()); }
+
+    template<class E>
+    slice_type share(parray<E, Traits> v) const { return slice_type(b_, slice_type::check_inside_(view(), v)); }
+};
+
+
+//------------------------------------------------------------------------------
+template<class T = char, class Traits = parray_traits>
+class shared_slice
+{
+    friend class shared_buffer<T, Traits>;
+
+    shared_block* b_ = nullptr;
+    parray<T const, Traits> v_{};
+
+    shared_slice(shared_block* b, parray<T const, Traits> v) : b_(b), v_(v) { if (b_) b_->add_ref(); }
+
+    template<class E>
+    static parray<T const, Traits> check_inside_(parray<T const, Traits> outer, parray<E, Traits> v)
+    {
+        if (v.len == 0) return {0, outer.p};
+        std::less_equal<T const*> le;   // v may point anywhere -- compare unrelated pointers safely
+        if (!(le(outer.p, v.p) && le(v.p + v.len, outer.p + outer.len))) throw std::out_of_range("shared_slice: array is outside of shared buffer");
+        return {v.len, v.p};
+    }
+
+public:
+    using view_type = parray<T const, Traits>;
+
+    shared_slice() = default;
+
+    shared_slice(shared_slice const& o) : b_(o.b_), v_(o.v_) { if (b_) b_->add_ref(); }
+    shared_slice(shared_slice&& o) noexcept : b_(o.b_), v_(o.v_) { o.b_ = nullptr; o.v_ = {}; }
+    shared_slice& operator=(shared_slice o) noexcept { std::swap(b_, o.b_); std::swap(v_, o.v_); return *this; }
+    ~shared_slice() { if (b_) b_->release(); }
+
+    // content
+    size_t size() const             { return v_.len; }
+    bool empty() const              { return v_.len == 0; }
+    T const* data() const           { return v_.p; }
+    T const& operator[](size_t i) const { return v_.p[i]; }
+    T const* begin() const          { return v_.p; }
+    T const* end() const            { return v_.p + v_.len; }
+
+    view_type view() const          { return v_; }
+    operator view_type() const      { return v_; }
+
+    size_t use_count() const        { return b_ ? b_->refs.load(std::memory_order_relaxed) : 0; }
+
+    // subparts (share the buffer)
+    shared_slice left(size_t cnt) const             { return shared_slice(b_, v_.left(cnt)); }
+    shared_slice right(size_t cnt) const            { return shared_slice(b_, v_.right(cnt)); }
+    shared_slice mid(size_t pos, size_t cnt) const  { return shared_slice(b_, v_.mid(pos, cnt)); }
+
+    template<class E>
+    shared_slice share(parray<E, Traits> v) const   { return shared_slice(b_, check_inside_(v_, v)); }
+};
+
+
+//------------------------------------------------------------------------------
+// comparisons and ostream << (see parray_owned.h)
+//
+using parray_owned_pvt_::operator==;
+using parray_owned_pvt_::operator!=;
+using parray_owned_pvt_::operator<;
+using parray_owned_pvt_::operator>;
+using parray_owned_pvt_::operator<=;
+using parray_owned_pvt_::operator>=;
+using parray_owned_pvt_::operator<<;
+
+
+//------------------------------------------------------------------------------
+} // namespace parray_shared_pvt_
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+namespace parray_owned_pvt_ {
+
+template<class T, class Traits> struct is_owned_<parray_shared_pvt_::shared_buffer<T, Traits>> : std::true_type {};
+template<class T, class Traits> struct is_owned_<parray_shared_pvt_::shared_slice<T, Traits>> : std::true_type {};
+
+} // namespace parray_owned_pvt_
+
+
+//------------------------------------------------------------------------------
+using parray_shared_pvt_::shared_buffer;
+using parray_shared_pvt_::shared_slice;
+
+
+//------------------------------------------------------------------------------
+} // namespace adv
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+// shared arrays as keys of unordered containers (same hash as parray views of them)
+//
+namespace std {
+
+template<class T, class Traits>
+struct hash<adv::shared_buffer<T, Traits>>
+{
+    size_t operator()(adv::shared_buffer<T, Traits> const& v) const { return Traits::hash(v.size(), v.data()); }
+};
+
+template<class T, class Traits>
+struct hash<adv::shared_slice<T, Traits>>
+{
+    size_t operator()(adv::shared_slice<T, Traits> const& v) const { return Traits::hash(v.size(), v.data()); }
+};
+
+} // namespace std
+
+
+#endif //PARRAY_SHARED_H_2026_10_18_17_48_33_092_H_
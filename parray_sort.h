@@ -0,0 +1,381 @@
+/*/////////////////////////////////////////////////////////////////////////////
+    ADV library
+
+  Author:
+    Michael Kilburn
+
+/////////////////////////////////////////////////////////////////////////////*/
+
+
+#ifndef PARRAY_SORT_H_2026_10_18_17_20_55_314_H_
+#define PARRAY_SORT_H_2026_10_18_17_20_55_314_H_
+
+
+#include "parray.h"
+#include <type_traits>
+#include <algorithm>
+#include <iterator>
+#include <vector>
+#include <cstring>
+#include <utility>
+#include <thread>
+#include <atomic>
+
+
+//------------------------------------------------------------------------------
+// Sorting of parray ranges
+//
+//  sort_parrays(it, it_end)            -- same result as std::sort(it, it_end) (i.e. operator<)
+//  stable_sort_parrays(it, it_end)     -- same result as std::stable_sort(it, it_end)
+//  parallel_sort_unique(vec, threads)  -- sort vector and remove duplicates (same as std::sort + std::unique + erase)
+//                                         using 'threads' threads (0 -- hardware concurrency)
+//
+//  Default trait orders arrays by length, then by elements. For char/unsigned char arrays this is the order of
+// (len, bytes) tuples -- it is sorted by radix sort instead of comparisons:
+//      - counting sort by length (or comparison sort by length if lengths are too sparse)
+//      - MSD radix sort of every length group by bytes (common prefixes are skipped, small buckets are finished by
+//        insertion sort, largest bucket is handled in a loop -- stack use doesn't grow with length of shared prefixes)
+//  elements are distributed through temporary buffer (n elements), so radix sort is stable. Other element types and
+//  traits are sorted with std::sort/std::stable_sort.
+//
+//  parallel_sort_unique() splits radix-sortable arrays into independent ranges (by length, then by leading bytes -- it
+// is the same MSD radix sort with top levels distributed in parallel), every thread sorts and deduplicates its ranges
+// (duplicates can't span ranges), then ranges are compacted. Other types are sorted and deduplicated in one thread.
+//
+// Example:
+//
+//      vector<rcstring> keys = ...;
+//      sort_parrays(keys.begin(), keys.end());
+//      assert( is_sorted(keys.begin(), keys.end()) );
+//
+
+
+//------------------------------------------------------------------------------
+namespace adv { namespace parray_sort_pvt_ {
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+using std::size_t;
+using std::vector;
+using adv::parray;
+using adv::parray_traits;
+using adv::parray_wide_traits;
+
+template<class T> using remove_cv = std::remove_cv_t<T>;
+template<bool B, class T = void> using enable_if = std::enable_if_t<B, T>;
+template<class T, class U> constexpr bool is_same = std::is_same<T, U>::value;
+template<class I> using value_type = typename std::iterator_traits<I>::value_type;
+
+// arrays with (len, unsigned bytes) order
+template<class V> struct is_radix_sortable_ : std::false_type {};
+template<class T, class Tr> struct is_radix_sortable_<parray<T, Tr>>
+    : std::integral_constant<bool, (is_same<Tr, parray_traits> || is_same<Tr, parray_wide_traits>) && !std::is_volatile<T>::value &&
+                                   (is_same<remove_cv<T>, char> || is_same<remove_cv<T>, unsigned char>)> {};
+
+template<class I> constexpr bool is_radix_sortable = is_radix_sortable_<value_type<I>>::value;
+
+
+//------------------------------------------------------------------------------
+enum : size_t
+{
+    small_sort_limit = 32,              // buckets of this size (or smaller) are sorted by comparisons
+    counting_len_limit = 1 << 16,       // max length that always uses counting sort (above it -- only if lengths are dense)
+    msd_max_levels = 48,                // msd_sort() recursion limit (remaining range is sorted by comparisons)
+};
+
+template<class V> inline unsigned byte_at(V const& v, size_t i) { return static_cast<unsigned char>(v.p[i]); }
+
+// same-length arrays that are equal up to 'depth'
+template<class V> inline bool tail_lt(V const& l, V const& r, size_t depth) { return std::memcmp(l.p + depth, r.p + depth, l.len - depth) < 0; }
+
+template<class I>
+inline void insertion_sort_tail(I first, I last, size_t depth)
+{
+    for(I it = first + 1; it < last; ++it)
+    {
+        auto v = *it;
+        I j = it;
+        for(; j != first && tail_lt(v, *(j - 1), depth); --j) *j = *(j - 1);
+        *j = v;
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// radix sort -- distribution through tmp
+//
+template<class I, class V>
+void sort_by_len(I first, I last, V* tmp)
+{
+    size_t n = size_t(last - first);
+
+    size_t max_len = 0;
+    for(I it = first; it != last; ++it) if (it->len > max_len) max_len = it->len;
+
+    if (max_len > counting_len_limit && max_len / 4 > n)
+    {
+        std::stable_sort(first, last, [](V const& l, V const& r) { return l.len < r.len; });
+        return;
+    }
+
+    vector<size_t> pos(max_len + 2, 0);
+    for(I it = first; it != last; ++it) ++pos[it->len + 1];
+    for(size_t i = 1; i < pos.size(); ++i) pos[i] += pos[i - 1];
+
+    for(I it = first; it != last; ++it) tmp[pos[it->len]++] = *it;
+    std::copy(tmp, tmp + n, first);
+}
+
+// recurses into all buckets but the largest one and continues with it in a loop, so recursion depth doesn't depend
+// on length of common prefixes (every recursive call gets at most half of elements -- depth is under log2(n))
+template<class I, class V>
+void msd_sort(I first, I last, size_t depth, V* tmp, size_t level = 0)
+{
+    size_t const len = first->len;
+    for(;;)
+    {
+        size_t n = size_t(last - first);
+        if (n < 2 || depth >= len) return;
+        if (n <= small_sort_limit) { insertion_sort_tail(first, last, depth); return; }
+        if (level >= msd_max_levels) { std::stable_sort(first, last, [depth](V const& l, V const& r) { return tail_lt(l, r, depth); }); return; }
+
+        size_t count[256] = {};
+        for(I it = first; it != last; ++it) ++count[byte_at(*it, depth)];
+
+        if (count[byte_at(*first, depth)] == n) { ++depth; continue; }     // common byte -- next one
+
+        size_t pos[256];
+        pos[0] = 0;
+        for(size_t c = 1; c < 256; ++c) pos[c] = pos[c - 1] + count[c - 1];
+
+        for(I it = first; it != last; ++it) tmp[pos[byte_at(*it, depth)]++] = *it;
+        std::copy(tmp, tmp + n, first);
+
+        size_t big = 0;
+        for(size_t c = 1; c < 256; ++c) if (count[c] > count[big]) big = c;
+
+        I big_first = first;
+        for(size_t c = 0; c < 256; first += count[c], ++c)
+        {
+            if (c == big) big_first = first;
+            else if (count[c] > 1) msd_sort(first, first + count[c], depth + 1, tmp, level + 1);
+        }
+
+        first = big_first;
+        last = big_first + count[big];
+        ++depth;
+    }
+}
+
+
+//------------------------------------------------------------------------------
+template<class I, enable_if<is_radix_sortable<I>>...>
+inline void stable_sort_parrays(I first, I last)
+{
+    if (last - first < 2) return;
+
+    vector<value_type<I>> tmp(size_t(last - first));
+    sort_by_len(first, last, tmp.data());
+
+    for(I it = first; it != last; )
+    {
+        I group_end = it;
+        while(group_end != last && group_end->len == it->len) ++group_end;
+        msd_sort(it, group_end, 0, tmp.data());
+        it = group_end;
+    }
+}
+
+template<class I, enable_if<!is_radix_sortable<I>>...>
+inline void stable_sort_parrays(I first, I last) { std::stable_sort(first, last); }
+
+
+//------------------------------------------------------------------------------
+// radix sort is stable anyway -- sort_parrays() only differs for element types/traits that aren't radix-sortable
+template<class I, enable_if<is_radix_sortable<I>>...>
+inline void sort_parrays(I first, I last) { stable_sort_parrays(first, last); }
+
+template<class I, enable_if<!is_radix_sortable<I>>...>
+inline void sort_parrays(I first, I last) { std::sort(first, last); }
+
+
+//------------------------------------------------------------------------------
+// parallel sort + unique
+//
+enum : size_t { parallel_min = 1 << 16 };    // don't bother with threads for less elements
+
+// run f(t) for t in [0, threads), f(0) runs in calling thread
+template<class F>
+void run_threads(unsigned threads, F f)
+{
+    vector<std::thread> pool;
+    for(unsigned t = 1; t < threads; ++t) pool.emplace_back(f, t);
+    f(0u);
+    for(auto& th : pool) th.join();
+}
+
+// stable distribution of [first, first + n) by key(v) (key(v) < buckets), bucket sizes are placed into count
+template<class V, class Key>
+void parallel_distribute(V* first, size_t n, V* tmp, size_t buckets, Key key, unsigned threads, vector<size_t>& count)
+{
+    auto chunk_begin = [n, threads](unsigned t) { return n * t / threads; };
+
+    vector<size_t> pos(size_t(threads) * buckets, 0);      // pos[t*buckets + b] -- where thread t puts next element of bucket b
+    run_threads(threads, [&](unsigned t) {
+        size_t* h = &pos[t * buckets];
+        for(size_t i = chunk_begin(t), e = chunk_begin(t + 1); i < e; ++i) ++h[key(first[i])];
+    });
+
+    count.assign(buckets, 0);
+    size_t total = 0;
+    for(size_t b = 0; b < buckets; ++b)
+        for(unsigned t = 0; t < threads; ++t)
+        {
+            size_t c = pos[t * buckets + b];
+            pos[t * buckets + b] = total;
+            total += c;
+            count[b] += c;
+        }
+
+    run_threads(threads, [&](unsigned t) {
+        size_t* h = &pos[t * buckets];
+        for(size_t i = chunk_begin(t), e = chunk_begin(t + 1); i < e; ++i) tmp[h[key(first[i])]++] = first[i];
+    });
+
+    run_threads(threads, [&](unsigned t) { std::copy(tmp + chunk_begin(t), tmp + chunk_begin(t + 1), first + chunk_begin(t)); });
+}
+
+struct sort_task
+{
+    size_t first, last;     // range of same-length arrays that are equal up to depth
+    size_t depth;
+    size_t kept;            // number of unique elements left at the beginning of range
+};
+
+// split range into tasks no larger than 'big' (unless they can't be split any further), largest bucket is split in a
+// loop (like in msd_sort()) -- tasks are not ordered by position
+template<class V>
+void split_tasks(V* data, V* tmp, size_t first, size_t last, size_t depth, size_t big, unsigned threads, vector<sort_task>& tasks)
+{
+    size_t const len = data[first].len;
+    vector<size_t> count;
+    while(last - first > big && depth < len)
+    {
+        parallel_distribute(data + first, last - first, tmp + first, 256, [depth](V const& v) { return byte_at(v, depth); }, threads, count);
+
+        size_t top = size_t(std::max_element(count.begin(), count.end()) - count.begin());
+        if (count[top] == last - first) { ++depth; continue; }     // common byte
+
+        size_t top_first = first;
+        for(size_t c = 0, b = first; c < 256; b += count[c], ++c)
+        {
+            if (c == top) top_first = b;
+            else if (count[c]) split_tasks(data, tmp, b, b + count[c], depth + 1, big, threads, tasks);
+        }
+
+        first = top_first;
+        last = top_first + count[top];
+        ++depth;
+    }
+    tasks.push_back({first, last, depth, 0});
+}
+
+template<class V>
+inline bool same_len_eq(V const& l, V const& r) { return l.p == r.p || std::memcmp(l.p, r.p, l.len) == 0; }
+
+template<class V, class A, enable_if<is_radix_sortable<V*>>...>
+void parallel_sort_unique(vector<V, A>& v, unsigned threads = 0)
+{
+    if (!threads) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    size_t const n = v.size();
+    if (threads == 1 || n < parallel_min)
+    {
+        sort_parrays(v.begin(), v.end());
+        v.erase(std::unique(v.begin(), v.end()), v.end());
+        return;
+    }
+
+    V* data = v.data();
+    vector<V> tmp(n);
+
+    // by length
+    vector<size_t> max_len(threads, 0);
+    run_threads(threads, [&](unsigned t) {
+        for(size_t i = n * t / threads, e = n * (t + 1) / threads; i < e; ++i) max_len[t] = std::max<size_t>(max_len[t], data[i].len);
+    });
+    size_t const len_buckets = *std::max_element(max_len.begin(), max_len.end()) + 1;
+
+    vector<size_t> count;
+    if (len_buckets > counting_len_limit && len_buckets / 4 > n)
+        sort_by_len(data, data + n, tmp.data());
+    else
+        parallel_distribute(data, n, tmp.data(), len_buckets, [](V const& v) { return size_t(v.len); }, threads, count);
+
+    // independent ranges
+    vector<sort_task> tasks;
+    size_t const big = std::max<size_t>(n / (threads * 8), small_sort_limit);
+    for(size_t first = 0; first < n; )
+    {
+        size_t last = first;
+        while(last < n && data[last].len == data[first].len) ++last;
+        split_tasks(data, tmp.data(), first, last, 0, big, threads, tasks);
+        first = last;
+    }
+    std::sort(tasks.begin(), tasks.end(), [](sort_task const& l, sort_task const& r) { return l.first < r.first; });
+
+    // sort and deduplicate every range, largest first
+    vector<size_t> order(tasks.size());
+    for(size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t l, size_t r) { return tasks[l].last - tasks[l].first > tasks[r].last - tasks[r].first; });
+
+    std::atomic<size_t> next{0};
+    run_threads(threads, [&](unsigned) {
+        for(size_t k; (k = next++) < order.size(); )
+        {
+            sort_task& task = tasks[order[k]];
+            msd_sort(data + task.first, data + task.last, task.depth, tmp.data() + task.first);
+
+            size_t out = task.first + 1;
+            for(size_t i = task.first + 1; i < task.last; ++i)
+                if (!same_len_eq(data[out - 1], data[i])) data[out++] = data[i];
+            task.kept = out - task.first;
+        }
+    });
+
+    // close the gaps
+    size_t out = 0;
+    for(sort_task const& task : tasks)
+    {
+        if (out != task.first) std::copy(data + task.first, data + task.first + task.kept, data + out);
+        out += task.kept;
+    }
+    v.resize(out);
+}
+
+template<class V, class A, enable_if<!is_radix_sortable<V*>>...>
+void parallel_sort_unique(vector<V, A>& v, unsigned = 0)
+{
+    sort_parrays(v.begin(), v.end());
+    v.erase(std::unique(v.begin(), v.end()), v.end());
+}
+
+
+//------------------------------------------------------------------------------
+} // namespace parray_sort_pvt_
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+using parray_sort_pvt_::sort_parrays;
+using parray_sort_pvt_::stable_sort_parrays;
+using parray_sort_pvt_::parallel_sort_unique;
+
+
+//------------------------------------------------------------------------------
+} // namespace adv
+//------------------------------------------------------------------------------
+
+
+#endif //PARRAY_SORT_H_2026_10_18_17_20_55_314_H_
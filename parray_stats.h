@@ -0,0 +1,246 @@
+/*/////////////////////////////////////////////////////////////////////////////
+    ADV library
+
+  Author:
+    Michael Kilburn
+
+/////////////////////////////////////////////////////////////////////////////*/
+
+
+#ifndef PARRAY_STATS_H_2026_10_18_20_02_37_145_H_
+#define PARRAY_STATS_H_2026_10_18_20_02_37_145_H_
+
+
+#include "parray.h"
+#include <type_traits>
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+
+
+//------------------------------------------------------------------------------
+// parray_counting_traits<Base>
+//
+//  Instrumented version of Base trait (parray_traits by default) -- compares exactly like Base, but also counts how
+// comparisons were decided. Meant to verify (on real data) that most comparisons don't touch memory, e.g. to tune key
+// layout:
+//
+//      using counted_string = parray<char const, parray_counting_traits<>>;
+//      ... run workload with counted_string keys ...
+//      parray_cmp_stats s = parray_counting_traits<>::stats();
+//      printf("%.1f%% decided without touching elements\n", 100 * s.memory_free_ratio());
+//
+//  parray_cmp_stats
+//      eq_calls, lt_calls      -- array comparisons (==, != are eq; <, >, <=, >= are lt)
+//      by_length               -- decided by length alone (lengths differ or both arrays are empty)
+//      by_same_ptr             -- equal lengths, same pointer (elements of scalar types aren't compared in this case)
+//      scanned                 -- elements had to be compared
+//      bytes_scanned           -- total size of elements compared (up to and including first mismatch)
+//      scanned_hist[k]         -- number of scanning comparisons that compared [2^k, 2^(k+1)) bytes (last bucket -- more)
+//      ntbs_calls              -- comparisons involving ntbs (they always touch memory)
+//
+//  parray_counting_traits<Base>::stats()   -- totals over all threads (including finished ones)
+//  parray_counting_traits<Base>::reset()   -- reset counters
+//
+// Notes:
+//  - every thread updates its own counters (no atomic read-modify-write operations), stats() sums them up under mutex
+//  - stats are kept per trait type
+//  - it is a diagnostic tool: scanning comparisons are more expensive (mismatch position is located separately)
+//  - Base has to be a length-first trait (i.e. not parray_lex_traits)
+//
+
+
+//------------------------------------------------------------------------------
+namespace adv { namespace parray_stats_pvt_ {
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+using std::size_t;
+using std::uint64_t;
+using adv::parray_traits;
+
+
+//------------------------------------------------------------------------------
+struct parray_cmp_stats
+{
+    enum : size_t { hist_size = 16 };
+
+    uint64_t eq_calls       = 0;
+    uint64_t lt_calls       = 0;
+    uint64_t by_length      = 0;
+    uint64_t by_same_ptr    = 0;
+    uint64_t scanned        = 0;
+    uint64_t bytes_scanned  = 0;
+    uint64_t ntbs_calls     = 0;
+    uint64_t scanned_hist[hist_size] = {};
+
+    uint64_t calls() const { return eq_calls + lt_calls; }
+
+    // share of array comparisons decided without comparing elements
+    double memory_free_ratio() const { return calls() ? double(by_length + by_same_ptr) / double(calls()) : 1.0; }
+
+    // histogram bucket for given number of bytes
+    static size_t bucket(uint64_t bytes)
+    {
+        size_t k = 0;
+        for(; bytes > 1 && k + 1 < hist_size; bytes >>= 1) ++k;
+        return k;
+    }
+};
+
+
+//------------------------------------------------------------------------------
+template<class Base = parray_traits>
+struct parray_counting_traits : Base
+{
+    static_assert(!std::is_base_of<adv::parray_lex_traits, Base>::value, "parray_counting_traits: Base has to be a length-first trait");
+
+private:
+    enum : size_t { c_eq, c_lt, c_length, c_same_ptr, c_scanned, c_bytes, c_ntbs, c_hist, c_count = c_hist + parray_cmp_stats::hist_size };
+
+    struct registry;
+
+    // per-thread counters, written by owning thread only
+    struct block
+    {
+        std::atomic<uint64_t> c[c_count];
+
+        block()
+        {
+            for(auto& v : c) v.store(0, std::memory_order_relaxed);
+            registry& r = registry_();
+            std::lock_guard<std::mutex> lock(r.m);
+            r.live.push_back(this);
+        }
+
+        ~block()
+        {
+            registry& r = registry_();
+            std::lock_guard<std::mutex> lock(r.m);
+            for(size_t i = 0; i < c_count; ++i) r.retired[i] += c[i].load(std::memory_order_relaxed);
+            r.live.erase(std::find(r.live.begin(), r.live.end(), this));
+        }
+
+        void add(size_t i, uint64_t v = 1) { c[i].store(c[i].load(std::memory_order_relaxed) + v, std::memory_order_relaxed); }
+    };
+
+    struct registry
+    {
+        std::mutex m;
+        std::vector<block*> live;
+        uint64_t retired[c_count] = {};     // totals of finished threads
+    };
+
+    static registry& registry_() { static registry r; return r; }
+    static block& local_() { thread_local block b; return b; }
+
+    template<class L, class R>
+    static void count_(size_t i, size_t l_len, L* l, size_t r_len, R* r)
+    {
+        block& b = local_();
+        b.add(i);
+
+        if (l_len != r_len || l_len == 0) { b.add(c_length); return; }
+        if (std::is_scalar<L>::value && std::is_scalar<R>::value && Base::same_ptr(l, r)) { b.add(c_same_ptr); return; }
+
+        size_t n = 0;                                                   // locate first mismatch
+        while(n < l_len && Base::eq(1, l + n, 1, r + n)) ++n;
+        uint64_t bytes = uint64_t((n < l_len) ? n + 1 : l_len) * sizeof(L);
+
+        b.add(c_scanned);
+        b.add(c_bytes, bytes);
+        b.add(c_hist + parray_cmp_stats::bucket(bytes));
+    }
+
+    static void count_ntbs_() { local_().add(c_ntbs); }
+
+public:
+    // comparisons
+    template<class L, class R> static bool eq    (size_t l_len, L* l, size_t r_len, R* r) { count_(c_eq, l_len, l, r_len, r); return Base::eq(l_len, l, r_len, r); }
+    template<class L, class R> static bool eq_not(size_t l_len, L* l, size_t r_len, R* r) { return !eq(l_len, l, r_len, r); }
+    template<class L, class R> static bool lt    (size_t l_len, L* l, size_t r_len, R* r) { count_(c_lt, l_len, l, r_len, r); return Base::lt(l_len, l, r_len, r); }
+    template<class L, class R> static bool gt    (size_t l_len, L* l, size_t r_len, R* r) { return lt (r_len, r, l_len, l); }
+    template<class L, class R> static bool lt_eq (size_t l_len, L* l, size_t r_len, R* r) { return !lt(r_len, r, l_len, l); }
+    template<class L, class R> static bool gt_eq (size_t l_len, L* l, size_t r_len, R* r) { return !lt(l_len, l, r_len, r); }
+
+    // ntbs comparisons (counted, but not classified)
+    template<class L, class R> static bool ntbs_eq    (L* l, R* r) { count_ntbs_(); return Base::ntbs_eq    (l, r); }
+    template<class L, class R> static bool ntbs_not_eq(L* l, R* r) { count_ntbs_(); return Base::ntbs_not_eq(l, r); }
+    template<class L, class R> static bool ntbs_lt    (L* l, R* r) { count_ntbs_(); return Base::ntbs_lt    (l, r); }
+    template<class L, class R> static bool ntbs_gt    (L* l, R* r) { count_ntbs_(); return Base::ntbs_gt    (l, r); }
+    template<class L, class R> static bool ntbs_lt_eq (L* l, R* r) { count_ntbs_(); return Base::ntbs_lt_eq (l, r); }
+    template<class L, class R> static bool ntbs_gt_eq (L* l, R* r) { count_ntbs_(); return Base::ntbs_gt_eq (l, r); }
+
+    template<class L, class R> static bool ntbs_eq    (size_t l_len, L* l, R* r) { count_ntbs_(); return Base::ntbs_eq    (l_len, l, r); }
+    template<class L, class R> static bool ntbs_not_eq(size_t l_len, L* l, R* r) { count_ntbs_(); return Base::ntbs_not_eq(l_len, l, r); }
+    template<class L, class R> static bool ntbs_lt    (size_t l_len, L* l, R* r) { count_ntbs_(); return Base::ntbs_lt    (l_len, l, r); }
+    template<class L, class R> static bool ntbs_gt    (size_t l_len, L* l, R* r) { count_ntbs_(); return Base::ntbs_gt    (l_len, l, r); }
+    template<class L, class R> static bool ntbs_lt_eq (size_t l_len, L* l, R* r) { count_ntbs_(); return Base::ntbs_lt_eq (l_len, l, r); }
+    template<class L, class R> static bool ntbs_gt_eq (size_t l_len, L* l, R* r) { count_ntbs_(); return Base::ntbs_gt_eq (l_len, l, r); }
+
+    template<class L, class R> static bool ntbs_eq    (L* l, size_t r_len, R* r) { count_ntbs_(); return Base::ntbs_eq    (l, r_len, r); }
+    template<class L, class R> static bool ntbs_not_eq(L* l, size_t r_len, R* r) { count_ntbs_(); return Base::ntbs_not_eq(l, r_len, r); }
+    template<class L, class R> static bool ntbs_lt    (L* l, size_t r_len, R* r) { count_ntbs_(); return Base::ntbs_lt    (l, r_len, r); }
+    template<class L, class R> static bool ntbs_gt    (L* l, size_t r_len, R* r) { count_ntbs_(); return Base::ntbs_gt    (l, r_len, r); }
+    template<class L, class R> static bool ntbs_lt_eq (L* l, size_t r_len, R* r) { count_ntbs_(); return Base::ntbs_lt_eq (l, r_len, r); }
+    template<class L, class R> static bool ntbs_gt_eq (L* l, size_t r_len, R* r) { count_ntbs_(); return Base::ntbs_gt_eq (l, r_len, r); }
+
+    // statistics
+    static parray_cmp_stats stats()
+    {
+        local_();                                       // make sure registry outlives this thread's counters
+
+        uint64_t t[c_count];
+        registry& r = registry_();
+        {
+            std::lock_guard<std::mutex> lock(r.m);
+            for(size_t i = 0; i < c_count; ++i) t[i] = r.retired[i];
+            for(block* b : r.live)
+                for(size_t i = 0; i < c_count; ++i) t[i] += b->c[i].load(std::memory_order_relaxed);
+        }
+
+        parray_cmp_stats s;
+        s.eq_calls      = t[c_eq];
+        s.lt_calls      = t[c_lt];
+        s.by_length     = t[c_length];
+        s.by_same_ptr   = t[c_same_ptr];
+        s.scanned       = t[c_scanned];
+        s.bytes_scanned = t[c_bytes];
+        s.ntbs_calls    = t[c_ntbs];
+        for(size_t i = 0; i < parray_cmp_stats::hist_size; ++i) s.scanned_hist[i] = t[c_hist + i];
+        return s;
+    }
+
+    // counters of threads that compare concurrently with reset() may survive it
+    static void reset()
+    {
+        local_();
+
+        registry& r = registry_();
+        std::lock_guard<std::mutex> lock(r.m);
+        for(auto& v : r.retired) v = 0;
+        for(block* b : r.live)
+            for(auto& v : b->c) v.store(0, std::memory_order_relaxed);
+    }
+};
+
+
+//------------------------------------------------------------------------------
+} // namespace parray_stats_pvt_
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+using parray_stats_pvt_::parray_cmp_stats;
+using parray_stats_pvt_::parray_counting_traits;
+
+
+//------------------------------------------------------------------------------
+} // namespace adv
+//------------------------------------------------------------------------------
+
+
+#endif //PARRAY_STATS_H_2026_10_18_20_02_37_145_H_
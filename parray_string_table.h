@@ -0,0 +1,562 @@
+/*/////////////////////////////////////////////////////////////////////////////
+    ADV library
+
+  Author:
+    Michael Kilburn
+
+/////////////////////////////////////////////////////////////////////////////*/
+
+
+#ifndef PARRAY_STRING_TABLE_H_2026_10_18_16_47_03_862_H_
+#define PARRAY_STRING_TABLE_H_2026_10_18_16_47_03_862_H_
+
+
+#include "parray.h"
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <cassert>
+#include <vector>
+#include <algorithm>
+
+#if defined(__unix__) || defined(__APPLE__)
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <fcntl.h>
+#   include <unistd.h>
+#   include <cerrno>
+#   define PARRAY_STRING_TABLE_HAS_MMAP
+#endif
+
+
+//------------------------------------------------------------------------------
+// Immutable string table -- sorted set of char arrays serialized into a flat image that can be used in place (e.g.
+// mmap'ed file) without parsing or memory allocation
+//
+//  string_table_builder
+//      add(rcstring k)                         -- add key (it is copied)
+//      write(vector<char>& out, restart = 0)   -- serialize sorted unique keys into out
+//      save(path, restart = 0)                 -- same, but into a file (returns false and leaves errno on error)
+//
+//  string_table
+//      attach(rcstring image)                  -- use image (8-byte aligned, has to outlive the table), false if invalid
+//                                                 (image is validated: O(groups), front-coded blocks -- O(image size))
+//      open(path)                              -- mmap file and attach it (POSIX only)
+//      find(rcstring k)                        -- index of k or npos, O(log n)
+//      operator[](i)                           -- i-th key (no front-coding only)
+//      key(i, buf)                             -- i-th key, decoded into buf if necessary (buf has to fit max_len())
+//      for_each(f)                             -- call f(rcstring) for every key in order
+//
+// Image layout (native byte order):
+//      header
+//      group[group_count]      -- one per distinct key length, ascending: {len, first key index, key count, blob offset,
+//                                 first restart offset index}
+//      offset[offset_count]    -- uint64 offsets of restart keys in blob (front-coded tables only)
+//      blob                    -- key bytes
+//
+//  Keys are ordered like parray_traits orders them (length first, then unsigned bytes), so each group is a contiguous
+// sorted run of keys of the same length. Without front-coding i-th key of a group is at blob offset + i*len (no
+// per-key offsets are needed). Lookup finds the group by length and binary-searches its run.
+//
+//  With front-coding (restart > 0) every restart'th key of a group is stored in full, keys in between are stored as
+// (varint shared prefix length, suffix) -- suffix length is implied by group's key length. Lookup binary-searches
+// restart keys and scans one block without decoding it.
+//
+// Example:
+//
+//      string_table_builder b;
+//      for(auto& w : words) b.add(rcstring(w));
+//      b.save("words.st", 16);
+//      ...
+//      string_table t;
+//      if (t.open("words.st") && t.find(ntba("parray")) != string_table::npos) ...
+//
+
+
+//------------------------------------------------------------------------------
+namespace adv { namespace parray_string_table_pvt_ {
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+using std::size_t;
+using std::uint64_t;
+using std::vector;
+using adv::rcstring;
+
+
+//------------------------------------------------------------------------------
+// image format
+//
+struct string_table_header
+{
+    char magic[8];              // "ADVSTRT2"
+    uint64_t byte_order;        // string_table_byte_order (as written by builder)
+    uint64_t count;             // number of keys
+    uint64_t max_len;           // length of longest key
+    uint64_t restart;           // front-coding restart interval (0 -- no front-coding)
+    uint64_t group_count;
+    uint64_t offset_count;
+    uint64_t blob_size;
+};
+
+struct string_table_group
+{
+    uint64_t len;               // length of every key in group
+    uint64_t first;             // index of first key
+    uint64_t count;             // number of keys
+    uint64_t blob_offset;       // offset of group's data in blob
+    uint64_t first_restart;     // index of group's first restart offset (front-coded tables only)
+};
+
+static char const string_table_magic[8] = { 'A', 'D', 'V', 'S', 'T', 'R', 'T', '2' };
+enum : uint64_t { string_table_byte_order = 0x0102030405060708ull };
+
+
+//------------------------------------------------------------------------------
+// varint (LEB128)
+inline void put_varint(vector<char>& out, uint64_t v)
+{
+    for(; v >= 0x80; v >>= 7) out.push_back(static_cast<char>(v | 0x80));
+    out.push_back(static_cast<char>(v));
+}
+
+// bounds-checked version (for image validation), false if varint is truncated or too long
+inline bool get_varint(unsigned char const* p, uint64_t size, uint64_t& pos, uint64_t& v)
+{
+    v = 0;
+    for(unsigned shift = 0; pos < size && shift < 64; shift += 7)
+    {
+        unsigned char b = p[pos++];
+        v |= uint64_t(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+inline uint64_t get_varint(unsigned char const*& p)
+{
+    uint64_t v = 0;
+    for(unsigned shift = 0; ; shift += 7)
+    {
+        unsigned char b = *p++;
+        v |= uint64_t(b & 0x7F) << shift;
+        if (!(b & 0x80)) return v;
+    }
+}
+
+// parray_traits order of same-length keys
+inline int cmp_bytes(void const* l, void const* r, size_t len) { return len ? std::memcmp(l, r, len) : 0; }
+
+inline void copy_bytes(void* dst, void const* src, size_t len) { if (len) std::memcpy(dst, src, len); }
+
+
+//------------------------------------------------------------------------------
+class string_table_builder
+{
+    struct entry { size_t off, len; };      // key position in data_ (it may be reallocated)
+
+    vector<char> data_;
+    vector<entry> keys_;
+
+public:
+    void add(rcstring k)
+    {
+        keys_.push_back({data_.size(), k.len});
+        data_.insert(data_.end(), k.p, k.p + k.len);
+    }
+
+    size_t size() const { return keys_.size(); }    // including duplicates
+
+    void write(vector<char>& out, size_t restart = 0) const
+    {
+        // sorted unique keys
+        vector<rcstring> keys;
+        keys.reserve(keys_.size());
+        for(entry const& e : keys_) keys.push_back(rcstring(e.len, data_.data() + e.off));
+
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+        // groups, offsets and blob
+        vector<string_table_group> groups;
+        vector<uint64_t> offsets;
+        vector<char> blob;
+
+        for(size_t i = 0; i < keys.size(); ++i)
+        {
+            rcstring k = keys[i];
+            if (groups.empty() || groups.back().len != k.len)
+                groups.push_back({k.len, i, 0, blob.size(), offsets.size()});
+
+            size_t pos = groups.back().count++;
+            if (restart == 0 || pos % restart == 0)
+            {
+                if (restart) offsets.push_back(blob.size());
+                blob.insert(blob.end(), k.p, k.p + k.len);
+            }
+            else
+            {
+                rcstring prev = keys[i - 1];
+                size_t shared = 0;
+                while(shared < k.len && k.p[shared] == prev.p[shared]) ++shared;
+
+                put_varint(blob, shared);
+                blob.insert(blob.end(), k.p + shared, k.p + k.len);
+            }
+        }
+
+        string_table_header h;
+        std::memcpy(h.magic, string_table_magic, sizeof(h.magic));
+        h.byte_order   = string_table_byte_order;
+        h.count        = keys.size();
+        h.max_len      = keys.empty() ? 0 : keys.back().len;
+        h.restart      = restart;
+        h.group_count  = groups.size();
+        h.offset_count = offsets.size();
+        h.blob_size    = blob.size();
+
+        auto put = [&out](void const* p, size_t n) { out.insert(out.end(), static_cast<char const*>(p), static_cast<char const*>(p) + n); };
+
+        out.reserve(out.size() + sizeof(h) + groups.size()*sizeof(string_table_group) + offsets.size()*sizeof(uint64_t) + blob.size());
+        put(&h, sizeof(h));
+        put(groups.data(), groups.size()*sizeof(string_table_group));
+        put(offsets.data(), offsets.size()*sizeof(uint64_t));
+        put(blob.data(), blob.size());
+    }
+
+    bool save(char const* path, size_t restart = 0) const
+    {
+        vector<char> image;
+        write(image, restart);
+
+        FILE* f = std::fopen(path, "wb");
+        if (!f) return false;
+
+        bool ok = std::fwrite(image.data(), 1, image.size(), f) == image.size();
+        ok = (std::fclose(f) == 0) && ok;
+        return ok;
+    }
+};
+
+
+//------------------------------------------------------------------------------
+class string_table
+{
+    string_table_header const* h_ = nullptr;
+    string_table_group const* groups_ = nullptr;
+    uint64_t const* offsets_ = nullptr;
+    unsigned char const* blob_ = nullptr;
+
+    void* map_ = nullptr;                   // mapping owned by this object (see open())
+    size_t map_size_ = 0;
+
+    // group of keys of given length or nullptr
+    string_table_group const* group_(size_t len) const
+    {
+        string_table_group const* end = groups_ + h_->group_count;
+        string_table_group const* g = std::lower_bound(groups_, end, len, [](string_table_group const& g, size_t len) { return g.len < len; });
+        return (g != end && g->len == len) ? g : nullptr;
+    }
+
+    string_table_group const* group_of_(size_t i) const
+    {
+        string_table_group const* g = std::upper_bound(groups_, groups_ + h_->group_count, i, [](size_t i, string_table_group const& g) { return i < g.first; });
+        return g - 1;
+    }
+
+    // k-th key of group (no front-coding), first key of block-th restart block of group (front-coding)
+    unsigned char const* key_at_(string_table_group const& g, size_t k) const { return blob_ + g.blob_offset + k*g.len; }
+    unsigned char const* restart_at_(string_table_group const& g, size_t block) const { return blob_ + offsets_[g.first_restart + block]; }
+
+    // groups and offsets have to describe blob exactly (front-coded blocks are decoded), so lookups never leave the image
+    static bool valid_(string_table_header const& h, string_table_group const* groups, uint64_t const* offsets, unsigned char const* blob)
+    {
+        if (h.restart == 0 && h.offset_count != 0) return false;
+        if (h.max_len != (h.group_count ? groups[h.group_count - 1].len : 0)) return false;
+
+        uint64_t key = 0, pos = 0, ri = 0;
+        for(uint64_t gi = 0; gi < h.group_count; ++gi)
+        {
+            string_table_group const& g = groups[gi];
+            if (g.first != key || g.blob_offset != pos || g.count == 0 || g.count > h.count - key) return false;
+            if ((gi && g.len <= groups[gi - 1].len) || (g.len == 0 && g.count != 1)) return false;
+            key += g.count;
+
+            if (h.restart == 0)
+            {
+                if (g.len && g.count > (h.blob_size - pos)/g.len) return false;
+                pos += g.count*g.len;
+                continue;
+            }
+
+            uint64_t blocks = g.count/h.restart + (g.count % h.restart != 0);
+            if (g.first_restart != ri || blocks > h.offset_count - ri) return false;
+            for(uint64_t b = 0; b < blocks; ++b, ++ri)
+            {
+                if (offsets[ri] != pos || g.len > h.blob_size - pos) return false;
+                pos += g.len;
+
+                for(uint64_t k = 1, n = std::min(h.restart, g.count - b*h.restart); k < n; ++k)
+                {
+                    uint64_t shared;
+                    if (!get_varint(blob, h.blob_size, pos, shared) || shared >= g.len || g.len - shared > h.blob_size - pos) return false;
+                    pos += g.len - shared;
+                }
+            }
+        }
+        return key == h.count && pos == h.blob_size && ri == h.offset_count;
+    }
+
+    size_t find_plain_(string_table_group const& g, rcstring k) const
+    {
+        size_t lo = 0, hi = g.count;
+        while(lo < hi)
+        {
+            size_t mid = lo + (hi - lo)/2;
+            int c = cmp_bytes(key_at_(g, mid), k.p, k.len);
+            if (c == 0) return g.first + mid;
+            if (c < 0) lo = mid + 1; else hi = mid;
+        }
+        return npos;
+    }
+
+    size_t find_front_coded_(string_table_group const& g, rcstring k) const
+    {
+        size_t const len = k.len;
+        unsigned char const* kp = reinterpret_cast<unsigned char const*>(k.p);
+
+        // last restart key <= k
+        size_t blocks = (g.count + h_->restart - 1) / h_->restart;
+        size_t lo = 0, hi = blocks;
+        while(lo < hi)
+        {
+            size_t mid = lo + (hi - lo)/2;
+            int c = cmp_bytes(restart_at_(g, mid), kp, len);
+            if (c == 0) return g.first + mid*h_->restart;
+            if (c < 0) lo = mid + 1; else hi = mid;
+        }
+        if (lo == 0) return npos;       // k is less than first key
+
+        // scan block -- match is the length of common prefix of k and current key (current key < k)
+        size_t block = lo - 1;
+        unsigned char const* p = restart_at_(g, block);
+        size_t match = 0;
+        while(p[match] == kp[match]) ++match;
+        p += len;
+
+        size_t block_end = std::min<size_t>(g.count, (block + 1)*h_->restart);
+        for(size_t pos = block*h_->restart + 1; pos < block_end; ++pos)
+        {
+            size_t shared = static_cast<size_t>(get_varint(p));
+            unsigned char const* suffix = p;
+            p += len - shared;
+
+            if (shared > match) continue;           // key[match] == prev[match] < k[match] -- still less than k
+            if (shared < match) return npos;        // key[shared] > prev[shared] == k[shared] -- past k
+
+            size_t i = 0;
+            while(shared + i < len && suffix[i] == kp[shared + i]) ++i;
+            if (shared + i == len) return g.first + pos;
+            if (suffix[i] > kp[shared + i]) return npos;
+            match = shared + i;
+        }
+        return npos;
+    }
+
+public:
+    enum : size_t { npos = ~size_t(0) };
+
+    string_table() = default;
+    string_table(string_table const&) = delete;
+    string_table& operator=(string_table const&) = delete;
+    ~string_table() { close(); }
+
+    // use image in place, it has to be 8-byte aligned and outlive this object
+    bool attach(rcstring image)
+    {
+        close();
+
+        string_table_header const* h = reinterpret_cast<string_table_header const*>(image.p);
+        if (image.len < sizeof(string_table_header) || reinterpret_cast<std::uintptr_t>(image.p) % alignof(uint64_t)) return false;
+        if (std::memcmp(h->magic, string_table_magic, sizeof(h->magic)) || h->byte_order != string_table_byte_order) return false;
+
+        size_t size = sizeof(string_table_header);
+        if (h->group_count > (image.len - size)/sizeof(string_table_group)) return false;
+        size += h->group_count*sizeof(string_table_group);
+        if (h->offset_count > (image.len - size)/sizeof(uint64_t)) return false;
+        size += h->offset_count*sizeof(uint64_t);
+        if (h->blob_size != image.len - size) return false;
+
+        auto groups = reinterpret_cast<string_table_group const*>(h + 1);
+        auto offsets = reinterpret_cast<uint64_t const*>(groups + h->group_count);
+        auto blob = reinterpret_cast<unsigned char const*>(offsets + h->offset_count);
+        if (!valid_(*h, groups, offsets, blob)) return false;
+
+        h_ = h;
+        groups_ = groups;
+        offsets_ = offsets;
+        blob_ = blob;
+        return true;
+    }
+
+#ifdef PARRAY_STRING_TABLE_HAS_MMAP
+    // map file and attach it, returns false on error (errno is set to EINVAL if file isn't a valid string table)
+    bool open(char const* path)
+    {
+        close();
+
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0)
+        {
+            int err = errno;
+            ::close(fd);
+            errno = err;
+            return false;
+        }
+        if (st.st_size == 0)
+        {
+            ::close(fd);
+            errno = EINVAL;
+            return false;
+        }
+
+        void* p = ::mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        int err = errno;
+        ::close(fd);
+        if (p == MAP_FAILED) { errno = err; return false; }
+
+        if (!attach(rcstring(size_t(st.st_size), static_cast<char const*>(p))))
+        {
+            ::munmap(p, size_t(st.st_size));
+            errno = EINVAL;
+            return false;
+        }
+
+        map_ = p;
+        map_size_ = size_t(st.st_size);
+        return true;
+    }
+#endif
+
+    void close()
+    {
+#ifdef PARRAY_STRING_TABLE_HAS_MMAP
+        if (map_) ::munmap(map_, map_size_);
+#endif
+        map_ = nullptr;
+        map_size_ = 0;
+        h_ = nullptr;
+    }
+
+    size_t size() const       { return h_ ? size_t(h_->count) : 0; }
+    bool empty() const        { return size() == 0; }
+    size_t max_len() const    { return h_ ? size_t(h_->max_len) : 0; }
+    bool front_coded() const  { return h_ && h_->restart != 0; }
+
+    // index of k or npos
+    size_t find(rcstring k) const
+    {
+        if (!h_) return npos;
+
+        string_table_group const* g = group_(k.len);
+        if (!g) return npos;
+
+        return h_->restart ? find_front_coded_(*g, k) : find_plain_(*g, k);
+    }
+
+    bool contains(rcstring k) const { return find(k) != npos; }
+
+    // i-th key (table must not be front-coded)
+    rcstring operator[](size_t i) const
+    {
+        assert(!front_coded() && i < size());
+        string_table_group const* g = group_of_(i);
+        return rcstring(size_t(g->len), reinterpret_cast<char const*>(key_at_(*g, i - g->first)));
+    }
+
+    // i-th key -- points into the table or (if table is front-coded) into buf (it has to fit max_len() chars)
+    rcstring key(size_t i, char* buf) const
+    {
+        if (!front_coded()) return (*this)[i];
+
+        assert(i < size());
+        string_table_group const* g = group_of_(i);
+        size_t len = size_t(g->len);
+        size_t pos = i - size_t(g->first);
+        size_t block = pos / h_->restart;
+
+        unsigned char const* p = restart_at_(*g, block);
+        copy_bytes(buf, p, len);
+        p += len;
+
+        for(size_t k = block*h_->restart + 1; k <= pos; ++k)
+        {
+            size_t shared = static_cast<size_t>(get_varint(p));
+            copy_bytes(buf + shared, p, len - shared);
+            p += len - shared;
+        }
+        return rcstring(len, buf);
+    }
+
+    // f(rcstring) for every key in order (the argument is valid only during the call)
+    template<class F>
+    void for_each(F f) const
+    {
+        if (!h_) return;
+
+        vector<char> buf(front_coded() ? max_len() : 0);
+        for(size_t gi = 0; gi < h_->group_count; ++gi)
+        {
+            string_table_group const& g = groups_[gi];
+            size_t len = size_t(g.len);
+
+            if (!front_coded())
+            {
+                for(size_t k = 0; k < g.count; ++k) f(rcstring(len, reinterpret_cast<char const*>(key_at_(g, k))));
+                continue;
+            }
+
+            unsigned char const* p = nullptr;
+            for(size_t k = 0; k < g.count; ++k)
+            {
+                if (k % h_->restart == 0)
+                {
+                    p = restart_at_(g, k/h_->restart);
+                    copy_bytes(buf.data(), p, len);
+                    p += len;
+                }
+                else
+                {
+                    size_t shared = static_cast<size_t>(get_varint(p));
+                    copy_bytes(buf.data() + shared, p, len - shared);
+                    p += len - shared;
+                }
+                f(rcstring(len, buf.data()));
+            }
+        }
+    }
+};
+
+
+//------------------------------------------------------------------------------
+} // namespace parray_string_table_pvt_
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+using parray_string_table_pvt_::string_table_builder;
+using parray_string_table_pvt_::string_table;
+using parray_string_table_pvt_::string_table_header;
+using parray_string_table_pvt_::string_table_group;
+
+
+//------------------------------------------------------------------------------
+} // namespace adv
+//------------------------------------------------------------------------------
+
+
+#endif //PARRAY_STRING_TABLE_H_2026_10_18_16_47_03_862_H_
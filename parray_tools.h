@@ -21,13 +21,16 @@
 #include <deque>
 #include <iterator>
 #include <limits>
+#include <utility>
+#include <vector>
+#include <cstdint>
 
 
 //------------------------------------------------------------------------------
 // parray<> tools
 //
 //  parray trim[_left|_right](parray v)
-//      trim whitespaces
+//      trim whitespaces (char/wchar_t -- according to C locale, char16_t/char32_t -- Unicode White_Space)
 //
 //  bools starts_with(parray v1, parray v2)
 //      true if v1 starts with v2
@@ -36,6 +39,13 @@
 //  T* contains(parray v1, parray v2)
 //      returns pointer to v2's occurence inside of v1 (not necessarily the first one) or nullptr if v2 is not in v1
 //
+//  I prefix_lower_bound(I it, I it_end, parray prefix)
+//      first element of lexicographically sorted range that is not less than prefix
+//  I prefix_upper_bound(I it, I it_end, parray prefix)
+//      end of elements that start with prefix
+//  pair<I, I> prefix_range(I it, I it_end, parray prefix)
+//      range of elements that start with prefix
+//
 // split/join functions
 //
 // Notes:
@@ -50,6 +60,11 @@
 //      single value
 //      parray of values
 //      functor with certain interface (see bitset_delim for example)
+//  - single value and parray (up to 8 values) delimiters of 16/32-bit elements (char16_t, char32_t, etc) are searched
+//    for 8/4 (16/8 with AVX2) elements at a time
+//  - bitset_delim<IntT, minV, maxV> keeps a bit per value of [minV, maxV] (8KB for full 16-bit range), values outside of
+//    the range are never delimiters; sparse_bitset_delim<IntT> keeps only 256-value pages that contain delimiters and
+//    covers entire range of IntT (e.g. UTF-16/UTF-32 code units)
 //  - join delimiter can be:
 //      single value
 //      parray of values
@@ -152,6 +167,10 @@ template<class T, class U> constexpr bool is_same = std::is_same<T, U>::value;
 template<class F, class T> constexpr bool is_convertible = std::is_convertible<F, T>::value;
 template<class T> constexpr bool is_scalar = std::is_scalar<T>::value;
 
+#if defined(PARRAY_HAS_SSE2_)
+using adv::parray_pvt_::ctz_;
+#endif
+
 // relaxed version of 'is_same<remove_cv<E>, remove_cv<T>> && is_convertible<E*, T*>'
 template<class E, class T> constexpr bool is_almost_same = (sizeof(E) == sizeof(T)) && is_convertible<E*, T*>;
 
@@ -163,12 +182,24 @@ template<class T> using argtype = typename ArgType<T>::type;
 
 
 //------------------------------------------------------------------------------
-template<class T, enable_if<is_same<remove_cv<T>, char   >>...> inline bool isspace(T v) { return std::isspace (v) != 0; }
-template<class T, enable_if<is_same<remove_cv<T>, wchar_t>>...> inline bool isspace(T v) { return std::iswspace(v) != 0; }
+// Unicode White_Space property
+inline bool is_unicode_space(char32_t cp)
+{
+    if (cp < 0x80) return cp == ' ' || (cp - 9u) < 5u;                         // \t \n \v \f \r
+    return cp == 0x85 || cp == 0xA0 || cp == 0x1680 || (cp - 0x2000u) < 11u ||
+           cp == 0x2028 || cp == 0x2029 || cp == 0x202F || cp == 0x205F || cp == 0x3000;
+}
+
+template<class T, enable_if<is_same<remove_cv<T>, char    >>...> inline bool isspace(T v) { return std::isspace (v) != 0; }
+template<class T, enable_if<is_same<remove_cv<T>, wchar_t >>...> inline bool isspace(T v) { return std::iswspace(v) != 0; }
+template<class T, enable_if<is_same<remove_cv<T>, char16_t>>...> inline bool isspace(T v) { return is_unicode_space(v); }
+template<class T, enable_if<is_same<remove_cv<T>, char32_t>>...> inline bool isspace(T v) { return is_unicode_space(v); }
+
+template<class T> constexpr bool is_text_char = is_same<remove_cv<T>, char> || is_same<remove_cv<T>, wchar_t> || is_same<remove_cv<T>, char16_t> || is_same<remove_cv<T>, char32_t>;
 
 
 //------------------------------------------------------------------------------
-template<class T, class Tr, enable_if<is_same<remove_cv<T>, char> || is_same<remove_cv<T>, wchar_t>>...>
+template<class T, class Tr, enable_if<is_text_char<T>>...>
 inline parray<T, Tr> trim(parray<T, Tr> v)
 {
     T* p_end = v.p + v.len;
@@ -183,7 +214,7 @@ inline parray<T, Tr> trim(parray<T, Tr> v)
 
 
 //------------------------------------------------------------------------------
-template<class T, class Tr, enable_if<is_same<remove_cv<T>, char> || is_same<remove_cv<T>, wchar_t>>...>
+template<class T, class Tr, enable_if<is_text_char<T>>...>
 inline parray<T, Tr> trim_left(parray<T, Tr> v)
 {
     T* p_end = v.p + v.len;
@@ -195,7 +226,7 @@ inline parray<T, Tr> trim_left(parray<T, Tr> v)
 
 
 //------------------------------------------------------------------------------
-template<class T, class Tr, enable_if<is_same<remove_cv<T>, char> || is_same<remove_cv<T>, wchar_t>>...>
+template<class T, class Tr, enable_if<is_text_char<T>>...>
 inline parray<T, Tr> trim_right(parray<T, Tr> v)
 {
     T* p_end = v.p + v.len;
@@ -245,6 +276,30 @@ inline T* contains(parray<T, Tr> v1, parray<E, Tr> v2)
 }
 
 
+//------------------------------------------------------------------------------
+// prefix ranges -- [it, it_end) has to be sorted lexicographically (e.g. arrays with parray_lex_traits), so that all
+// elements that start with given prefix are adjacent
+//
+template<class I, class E, class Tr>
+inline I prefix_lower_bound(I it, I it_end, parray<E, Tr> prefix)
+{
+    return std::lower_bound(it, it_end, prefix, [](auto const& v, parray<E, Tr> p) { return v < p; });
+}
+
+template<class I, class E, class Tr>
+inline I prefix_upper_bound(I it, I it_end, parray<E, Tr> prefix)
+{
+    return std::partition_point(prefix_lower_bound(it, it_end, prefix), it_end, [prefix](auto const& v) { return starts_with(v, prefix); });
+}
+
+template<class I, class E, class Tr>
+inline std::pair<I, I> prefix_range(I it, I it_end, parray<E, Tr> prefix)
+{
+    I first = prefix_lower_bound(it, it_end, prefix);
+    return { first, std::partition_point(first, it_end, [prefix](auto const& v) { return starts_with(v, prefix); }) };
+}
+
+
 //------------------------------------------------------------------------------
 // little helper (to tell apart between D delimiter and single-value T delimiter)
 //
@@ -264,6 +319,70 @@ template<class T> struct IsDelimiter
 template<class T> constexpr bool is_delimiter = IsDelimiter<T>::value;
 
 
+//------------------------------------------------------------------------------
+// unit_find_() -- (internal) search of 16/32-bit elements for any of (up to unit_find_max) values
+//------------------------------------------------------------------------------
+
+template<class T> constexpr bool is_wide_unit = std::is_integral<T>::value && !std::is_volatile<T>::value && (sizeof(T) == 2 || sizeof(T) == 4);
+
+enum : size_t { unit_find_max = 8 };
+
+#if defined(PARRAY_HAS_SSE2_)
+// chunk of U-byte elements compared in one step
+template<size_t U>
+struct unit_chunk
+{
+#if defined(__AVX2__)
+    using reg = __m256i;
+    enum { size = 32 / U };
+
+    static reg load(void const* p)              { return _mm256_loadu_si256(static_cast<__m256i const*>(p)); }
+    static reg zero()                           { return _mm256_setzero_si256(); }
+    static reg set1(std::uint32_t v)            { return (U == 2) ? _mm256_set1_epi16(short(v)) : _mm256_set1_epi32(int(v)); }
+    static reg eq(reg a, reg b)                 { return (U == 2) ? _mm256_cmpeq_epi16(a, b) : _mm256_cmpeq_epi32(a, b); }
+    static reg or_(reg a, reg b)                { return _mm256_or_si256(a, b); }
+    static std::uint32_t mask(reg v)            { return std::uint32_t(_mm256_movemask_epi8(v)); }     // U bits per element
+    static std::uint32_t all()                  { return 0xFFFFFFFFu; }
+#else
+    using reg = __m128i;
+    enum { size = 16 / U };
+
+    static reg load(void const* p)              { return _mm_loadu_si128(static_cast<__m128i const*>(p)); }
+    static reg zero()                           { return _mm_setzero_si128(); }
+    static reg set1(std::uint32_t v)            { return (U == 2) ? _mm_set1_epi16(short(v)) : _mm_set1_epi32(int(v)); }
+    static reg eq(reg a, reg b)                 { return (U == 2) ? _mm_cmpeq_epi16(a, b) : _mm_cmpeq_epi32(a, b); }
+    static reg or_(reg a, reg b)                { return _mm_or_si128(a, b); }
+    static std::uint32_t mask(reg v)            { return std::uint32_t(_mm_movemask_epi8(v)); }
+    static std::uint32_t all()                  { return 0xFFFFu; }
+#endif
+};
+#endif
+
+// first element of [p, p_end) that is (found ? equal : not equal) to any of d[0, n), n <= unit_find_max
+template<class T, class E>
+T* unit_find_(T* p, T* p_end, E const* d, size_t n, bool found)
+{
+#if defined(PARRAY_HAS_SSE2_)
+    using chunk = unit_chunk<sizeof(T)>;
+    typename chunk::reg vd[unit_find_max];
+    for(size_t i = 0; i < n; ++i) vd[i] = chunk::set1(std::uint32_t(d[i]));
+
+    for(; size_t(p_end - p) >= size_t(chunk::size); p += chunk::size)
+    {
+        typename chunk::reg x = chunk::load(p), e = chunk::zero();
+        for(size_t i = 0; i < n; ++i) e = chunk::or_(e, chunk::eq(x, vd[i]));
+
+        std::uint32_t m = chunk::mask(e);
+        if (!found) m ^= chunk::all();
+        if (m) return p + ctz_(m) / sizeof(T);
+    }
+#endif
+    for(; p != p_end; ++p)
+        if ((find(d, d + n, *p) != d + n) == found) return p;
+    return p_end;
+}
+
+
 //------------------------------------------------------------------------------
 // Common delimiter classes
 //------------------------------------------------------------------------------
@@ -278,6 +397,10 @@ struct single_delim
     template<class I> inline I find_first(I p, I p_end) const { return find(p, p_end, delim); }
     template<class I> inline I skip_all  (I p, I p_end) const { return find_if(p, p_end, [this](auto const& v) { return v != delim; }); }
 
+    // 16/32-bit elements
+    template<class E, enable_if<is_wide_unit<E> && is_same<remove_cv<E>, remove_cv<T>>>...> inline E* find_first(E* p, E* p_end) const { return unit_find_(p, p_end, &delim, 1, true); }
+    template<class E, enable_if<is_wide_unit<E> && is_same<remove_cv<E>, remove_cv<T>>>...> inline E* skip_all  (E* p, E* p_end) const { return unit_find_(p, p_end, &delim, 1, false); }
+
     // pre-condition: p was produced by 'find_first()'
     template<class I> inline I skip_one  (I p) const { return ++p; }
 };
@@ -292,6 +415,19 @@ struct multi_delim
     template<class I> inline I find_first(I p, I p_end) const { return find_first_of(p, p_end, delim.p, delim.p + delim.len); }
     template<class I> inline I skip_all  (I p, I p_end) const { return find_if(p, p_end, [this, d_end = delim.p + delim.len](auto const& v) { return find(delim.p, d_end, v) == d_end; }); }
 
+    // 16/32-bit elements, few delimiters
+    template<class E, enable_if<is_wide_unit<E> && is_same<remove_cv<E>, remove_cv<T>>>...>
+    inline E* find_first(E* p, E* p_end) const
+    {
+        return (delim.len <= unit_find_max) ? unit_find_(p, p_end, delim.p, delim.len, true) : find_first_of(p, p_end, delim.p, delim.p + delim.len);
+    }
+
+    template<class E, enable_if<is_wide_unit<E> && is_same<remove_cv<E>, remove_cv<T>>>...>
+    inline E* skip_all(E* p, E* p_end) const
+    {
+        return (delim.len <= unit_find_max) ? unit_find_(p, p_end, delim.p, delim.len, false) : skip_all<E*>(p, p_end);
+    }
+
     // pre-condition: p was produced by 'find_first()' and != p_end
     template<class I> inline I skip_one  (I p) const { return ++p; }
 };
@@ -362,6 +498,98 @@ public:
 };
 
 
+// two-level bitmap lookup delimiter that covers entire range of IntT: bits are kept in 256-value pages, only pages
+// with delimiters in them are allocated (values above 0xFFFF are kept in a sorted list)
+template<class IntT = char16_t>
+class sparse_bitset_delim
+{
+    static_assert(std::is_integral<IntT>::value && sizeof(IntT) <= 4, "");
+
+    using U = std::make_unsigned_t<IntT>;
+
+    enum { page_bits = 256, word_bits = 64, page_count = 256 };
+
+    struct page { std::uint64_t w[page_bits / word_bits]; };
+
+    std::uint16_t idx_[page_count];     // page index for high byte of 16-bit value, 0 -- shared empty page
+    std::vector<page> pages_;
+    std::vector<U> wide_;               // sorted values above 0xFFFF
+
+    static bool get_(page const& pg, unsigned lo) { return (pg.w[lo / word_bits] >> (lo % word_bits)) & 1; }
+
+public:
+    sparse_bitset_delim() { clear_all(); }
+
+    template<class T, class Tr>
+    sparse_bitset_delim(parray<T, Tr> v) : sparse_bitset_delim()
+    {
+        for(size_t i = 0; i < v.len; ++i)
+            set_bit(v[i]);
+    }
+
+    void clear_all()
+    {
+        memset(idx_, 0, sizeof(idx_));
+        pages_.assign(1, page{});
+        wide_.clear();
+    }
+
+    template<class T>
+    void set_bit(T const& v)
+    {
+        U u = IntT(v);
+        if (u > 0xFFFF)
+        {
+            auto it = std::lower_bound(wide_.begin(), wide_.end(), u);
+            if (it == wide_.end() || *it != u) wide_.insert(it, u);
+            return;
+        }
+        unsigned hi = unsigned(u) >> 8, lo = unsigned(u) & 0xFF;
+        if (idx_[hi] == 0)
+        {
+            idx_[hi] = std::uint16_t(pages_.size());    // up to 256 non-empty pages (+ shared empty one)
+            pages_.push_back(page{});
+        }
+        pages_[idx_[hi]].w[lo / word_bits] |= std::uint64_t(1) << (lo % word_bits);
+    }
+
+    template<class T>
+    void clear_bit(T const& v)
+    {
+        U u = IntT(v);
+        if (u > 0xFFFF)
+        {
+            auto it = std::lower_bound(wide_.begin(), wide_.end(), u);
+            if (it != wide_.end() && *it == u) wide_.erase(it);
+            return;
+        }
+        unsigned hi = unsigned(u) >> 8, lo = unsigned(u) & 0xFF;
+        if (idx_[hi]) pages_[idx_[hi]].w[lo / word_bits] &= ~(std::uint64_t(1) << (lo % word_bits));
+    }
+
+    template<class T>
+    bool is_set(T const& v) const
+    {
+        U u = IntT(v);
+        if (u > 0xFFFF) return std::binary_search(wide_.begin(), wide_.end(), u);
+        return get_(pages_[idx_[unsigned(u) >> 8]], unsigned(u) & 0xFF);
+    }
+
+    // memory used by lookup tables (in bytes)
+    size_t footprint() const { return sizeof(idx_) + pages_.size() * sizeof(page) + wide_.size() * sizeof(U); }
+
+    // delimiter implementation
+
+    enum { is_delimiter };      // mark this type for 'delim is: D' case
+
+    template<class I> inline I find_first(I p, I p_end) const { return find_if(p, p_end, [this](auto const& v) { return  this->is_set(v); }); }
+    template<class I> inline I skip_all  (I p, I p_end) const { return find_if(p, p_end, [this](auto const& v) { return !this->is_set(v); }); }
+
+    // pre-condition: p was produced by 'find_first()' and != p_end
+    template<class I> inline I skip_one  (I p) const { return ++p; }
+};
+
+
 //------------------------------------------------------------------------------
 // split[_se]_() -- (internal) generic functions to split range
 //------------------------------------------------------------------------------
@@ -876,6 +1104,9 @@ using parray_tools_pvt_::trim_right;
 using parray_tools_pvt_::starts_with;
 using parray_tools_pvt_::ends_with;
 using parray_tools_pvt_::contains;
+using parray_tools_pvt_::prefix_lower_bound;
+using parray_tools_pvt_::prefix_upper_bound;
+using parray_tools_pvt_::prefix_range;
 using parray_tools_pvt_::split;
 using parray_tools_pvt_::split_se;
 using parray_tools_pvt_::rsplit;
@@ -885,6 +1116,8 @@ using parray_tools_pvt_::join_se;
 using parray_tools_pvt_::rjoin;
 using parray_tools_pvt_::rjoin_se;
 using parray_tools_pvt_::bitset_delim;
+using parray_tools_pvt_::sparse_bitset_delim;
+using parray_tools_pvt_::is_unicode_space;
 
 
 //------------------------------------------------------------------------------
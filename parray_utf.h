@@ -0,0 +1,508 @@
+/*/////////////////////////////////////////////////////////////////////////////
+    ADV library
+
+  Author:
+    Michael Kilburn
+
+/////////////////////////////////////////////////////////////////////////////*/
+
+
+#ifndef PARRAY_UTF_H_2026_10_18_19_20_44_518_H_
+#define PARRAY_UTF_H_2026_10_18_19_20_44_518_H_
+
+
+#include "parray.h"
+#include "parray_tools.h"
+#include <type_traits>
+#include <cstdint>
+#include <iterator>
+
+
+//------------------------------------------------------------------------------
+// UTF-8 validation, UTF-8 <-> UTF-16/UTF-32 transcoding and UTF-8-safe trim/split helpers
+//
+//  UTF-8 arrays are arrays of char/unsigned char/signed char, UTF-16 -- char16_t (or 16-bit wchar_t), UTF-32 --
+// char32_t (or 32-bit wchar_t).
+//
+//  bool utf8_valid(parray v)
+//  T* utf8_find_invalid(parray v)
+//      check if v is well-formed UTF-8 (no overlong forms, surrogates or values above U+10FFFF); utf8_find_invalid()
+//      returns pointer to first byte of first bad (or truncated) sequence or nullptr
+//
+//  utf_result<char16_t> utf8_to_utf16(parray v, char16_t* buf, size_t buf_sz)
+//  utf_result<char32_t> utf8_to_utf32(parray v, char32_t* buf, size_t buf_sz)
+//  utf_result<char>     utf16_to_utf8(parray v, char* buf, size_t buf_sz)
+//  utf_result<char>     utf32_to_utf8(parray v, char* buf, size_t buf_sz)
+//      convert v into buf, stop at first bad sequence or when buf is full
+//  utf_result<C>        xxx_to_yyy(parray v, A alloc)
+//      same, buffer of exact size is obtained once from alloc(n) (e.g. arena)
+//
+//  utf_result<C>
+//      value       -- converted part of input (points into buf)
+//      consumed    -- number of input elements converted
+//      error       -- utf_error::none, ::invalid (bad sequence at v[consumed]), ::incomplete (v ends in the middle of
+//                     sequence, e.g. more data is yet to be received) or ::no_room (buf is too small)
+//
+//  size_t utf16_length(parray utf8), utf32_length(parray utf8), utf8_length(parray utf16/utf32)
+//      size of v converted into another encoding (upper bound if v is not well-formed)
+//
+//  utf8_trim[_left|_right](parray v)
+//      trim whitespaces (ASCII ones and the rest of Unicode White_Space), never cuts multibyte sequence
+//
+//  utf8_delim{ parray d }, utf8_space_delim{}
+//      split() delimiters (see parray_tools.h): any code point from UTF-8 array d / any Unicode whitespace; they only
+//      match whole sequences
+//
+// Example:
+//
+//      rcstring name = ...;
+//      if (!utf8_valid(name)) throw ...;
+//      auto r = utf8_to_utf16(name, [&](size_t n) { return arena.alloc<char16_t>(n); });
+//      api_call(r.value.p, r.value.len);
+//
+//      for(rcstring v : split(text, utf8_delim{ ntba("\xE3\x80\x81\xE3\x80\x82") })) ...     // U+3001, U+3002
+//
+// Notes:
+//  - ASCII runs are processed 16 (32 with AVX2) bytes at a time, multibyte sequences are validated one by one
+//  - ASCII delimiters never occur inside multibyte sequences, i.e. plain split(v, ',') is already safe for UTF-8;
+//    utf8_delim is only needed for non-ASCII delimiters
+//
+
+
+//------------------------------------------------------------------------------
+namespace adv { namespace parray_utf_pvt_ {
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+using std::size_t;
+using std::uint32_t;
+using std::reverse_iterator;
+using std::make_reverse_iterator;
+using adv::parray;
+using adv::parray_tools_pvt_::is_unicode_space;
+
+template<class T> using remove_cv = std::remove_cv_t<T>;
+template<bool B, class T = void> using enable_if = std::enable_if_t<B, T>;
+
+template<class E, size_t N> constexpr bool is_unit = std::is_integral<E>::value && !std::is_same<remove_cv<E>, bool>::value && !std::is_volatile<E>::value && sizeof(E) == N;
+
+template<class E> constexpr bool is_utf8  = is_unit<E, 1>;
+template<class E> constexpr bool is_utf16 = is_unit<E, 2> && (std::is_same<remove_cv<E>, char16_t>::value || std::is_same<remove_cv<E>, wchar_t>::value);
+template<class E> constexpr bool is_utf32 = is_unit<E, 4> && (std::is_same<remove_cv<E>, char32_t>::value || std::is_same<remove_cv<E>, wchar_t>::value);
+
+#if defined(PARRAY_HAS_SSE2_)
+using adv::parray_pvt_::byte_chunk;
+using adv::parray_pvt_::ctz_;
+#endif
+
+
+//------------------------------------------------------------------------------
+enum class utf_error { none, invalid, incomplete, no_room };
+
+template<class C>
+struct utf_result
+{
+    parray<C>   value;
+    size_t      consumed;
+    utf_error   error;
+
+    explicit operator bool() const { return error == utf_error::none; }
+};
+
+
+//------------------------------------------------------------------------------
+// Helpers
+//
+
+template<class T> inline unsigned byte_(T v) { return static_cast<unsigned char>(v); }
+
+enum : size_t { seq_invalid = 0, seq_incomplete = ~size_t(0) };
+
+// decode multibyte sequence at p (p[0] >= 0x80, avail > 0 bytes are available)
+// returns its length, seq_invalid or seq_incomplete (all available bytes are fine, but sequence is cut)
+template<class T>
+inline size_t seq_decode(T const* p, size_t avail, char32_t& cp)
+{
+    unsigned b = byte_(p[0]), lo = 0x80, hi = 0xBF;     // allowed range of second byte
+    size_t n;
+    if      (b < 0xC2) return seq_invalid;              // continuation byte or overlong 2-byte form
+    else if (b < 0xE0) { n = 2; cp = b & 0x1F; }
+    else if (b < 0xF0) { n = 3; cp = b & 0x0F; if (b == 0xE0) lo = 0xA0; if (b == 0xED) hi = 0x9F; }   // overlong, surrogates
+    else if (b < 0xF5) { n = 4; cp = b & 0x07; if (b == 0xF0) lo = 0x90; if (b == 0xF4) hi = 0x8F; }   // overlong, > U+10FFFF
+    else return seq_invalid;
+
+    for(size_t i = 1; i < n; ++i, lo = 0x80, hi = 0xBF)
+    {
+        if (i == avail) return seq_incomplete;
+        unsigned c = byte_(p[i]);
+        if (c < lo || c > hi) return seq_invalid;
+        cp = (cp << 6) | (c & 0x3F);
+    }
+    return n;
+}
+
+// length of sequence that starts with lead byte b (b is known to be a lead byte of valid sequence)
+inline size_t seq_len(unsigned b) { return (b < 0x80) ? 1 : (b < 0xE0) ? 2 : (b < 0xF0) ? 3 : 4; }
+
+// encode cp (valid code point) into p, returns number of bytes
+inline size_t encode(char32_t cp, char* p)
+{
+    if (cp < 0x80)    { p[0] = char(cp); return 1; }
+    if (cp < 0x800)   { p[0] = char(0xC0 | (cp >> 6));  p[1] = char(0x80 | (cp & 0x3F)); return 2; }
+    if (cp < 0x10000) { p[0] = char(0xE0 | (cp >> 12)); p[1] = char(0x80 | ((cp >> 6) & 0x3F)); p[2] = char(0x80 | (cp & 0x3F)); return 3; }
+    p[0] = char(0xF0 | (cp >> 18)); p[1] = char(0x80 | ((cp >> 12) & 0x3F)); p[2] = char(0x80 | ((cp >> 6) & 0x3F)); p[3] = char(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+inline size_t encoded_len(char32_t cp) { return (cp < 0x80) ? 1 : (cp < 0x800) ? 2 : (cp < 0x10000) ? 3 : 4; }
+
+inline utf_error seq_error(size_t n) { return (n == seq_incomplete) ? utf_error::incomplete : utf_error::invalid; }
+
+
+//------------------------------------------------------------------------------
+// Validation
+//
+template<class T, class Tr, enable_if<is_utf8<T>>...>
+T* utf8_find_invalid(parray<T, Tr> v)
+{
+    size_t i = 0;
+    while(i < v.len)
+    {
+#if defined(PARRAY_HAS_SSE2_)
+        if (v.len - i >= byte_chunk::size)
+        {
+            uint32_t m = byte_chunk::high_bits(v.p + i);
+            if (m == 0) { i += byte_chunk::size; continue; }
+            i += ctz_(m);                               // skip ASCII prefix of the chunk
+        }
+#endif
+        if (byte_(v.p[i]) < 0x80) { ++i; continue; }
+
+        char32_t cp = 0;
+        size_t n = seq_decode(v.p + i, v.len - i, cp);
+        if (n == seq_invalid || n == seq_incomplete) return v.p + i;
+        i += n;
+    }
+    return nullptr;
+}
+
+template<class T, class Tr, enable_if<is_utf8<T>>...>
+inline bool utf8_valid(parray<T, Tr> v) { return utf8_find_invalid(v) == nullptr; }
+
+
+//------------------------------------------------------------------------------
+// Lengths
+//
+template<class T, class Tr, enable_if<is_utf8<T>>...>
+size_t utf32_length(parray<T, Tr> v)
+{
+    size_t n = 0;
+    for(size_t i = 0; i < v.len; ++i) n += (byte_(v.p[i]) & 0xC0) != 0x80;      // every byte but continuation ones
+    return n;
+}
+
+template<class T, class Tr, enable_if<is_utf8<T>>...>
+size_t utf16_length(parray<T, Tr> v)
+{
+    size_t n = 0;
+    for(size_t i = 0; i < v.len; ++i)
+    {
+        unsigned b = byte_(v.p[i]);
+        n += ((b & 0xC0) != 0x80) + (b >= 0xF0);        // 4-byte sequences become surrogate pairs
+    }
+    return n;
+}
+
+template<class T, class Tr, enable_if<is_utf16<T>>...>
+size_t utf8_length(parray<T, Tr> v)
+{
+    size_t n = 0;
+    for(size_t i = 0; i < v.len; ++i)
+    {
+        unsigned c = v.p[i];
+        n += (c < 0x80) ? 1 : (c < 0x800 || (c - 0xD800u) < 0x800u) ? 2 : 3;   // each half of surrogate pair -- 2
+    }
+    return n;
+}
+
+template<class T, class Tr, enable_if<is_utf32<T>>...>
+size_t utf8_length(parray<T, Tr> v)
+{
+    size_t n = 0;
+    for(size_t i = 0; i < v.len; ++i) n += encoded_len(char32_t(v.p[i]));
+    return n;
+}
+
+
+//------------------------------------------------------------------------------
+// UTF-8 --> UTF-16/UTF-32
+//
+template<class C, class T>
+utf_result<C> from_utf8_(T* p, size_t len, C* out, size_t out_sz)
+{
+    size_t i = 0, o = 0;
+    utf_error err = utf_error::none;
+    while(i < len)
+    {
+#if defined(PARRAY_HAS_SSE2_)
+        if (len - i >= byte_chunk::size && out_sz - o >= byte_chunk::size)
+        {
+            uint32_t m = byte_chunk::high_bits(p + i);
+            size_t n = m ? ctz_(m) : size_t(byte_chunk::size);
+            for(size_t k = 0; k < n; ++k) out[o + k] = C(byte_(p[i + k]));     // ASCII prefix of the chunk
+            i += n;
+            o += n;
+            if (!m) continue;
+        }
+#endif
+        unsigned b = byte_(p[i]);
+        if (b < 0x80)
+        {
+            if (o == out_sz) { err = utf_error::no_room; break; }
+            out[o++] = C(b);
+            ++i;
+            continue;
+        }
+
+        char32_t cp = 0;
+        size_t n = seq_decode(p + i, len - i, cp);
+        if (n == seq_invalid || n == seq_incomplete) { err = seq_error(n); break; }
+
+        if (sizeof(C) == 2 && cp > 0xFFFF)
+        {
+            if (out_sz - o < 2) { err = utf_error::no_room; break; }
+            out[o++] = C(0xD7C0 + (cp >> 10));          // 0xD800 + ((cp - 0x10000) >> 10)
+            out[o++] = C(0xDC00 | (cp & 0x3FF));
+        }
+        else
+        {
+            if (o == out_sz) { err = utf_error::no_room; break; }
+            out[o++] = C(cp);
+        }
+        i += n;
+    }
+    return { {o, out}, i, err };
+}
+
+template<class T, class Tr, enable_if<is_utf8<T>>...>
+inline utf_result<char16_t> utf8_to_utf16(parray<T, Tr> v, char16_t* buf, size_t buf_sz) { return from_utf8_(v.p, v.len, buf, buf_sz); }
+
+template<class T, class Tr, enable_if<is_utf8<T>>...>
+inline utf_result<char32_t> utf8_to_utf32(parray<T, Tr> v, char32_t* buf, size_t buf_sz) { return from_utf8_(v.p, v.len, buf, buf_sz); }
+
+template<class T, class Tr, class A, enable_if<is_utf8<T> && !std::is_pointer<A>::value>...>
+utf_result<char16_t> utf8_to_utf16(parray<T, Tr> v, A alloc)
+{
+    size_t n = utf16_length(v);
+    return from_utf8_(v.p, v.len, static_cast<char16_t*>(alloc(n)), n);
+}
+
+template<class T, class Tr, class A, enable_if<is_utf8<T> && !std::is_pointer<A>::value>...>
+utf_result<char32_t> utf8_to_utf32(parray<T, Tr> v, A alloc)
+{
+    size_t n = utf32_length(v);
+    return from_utf8_(v.p, v.len, static_cast<char32_t*>(alloc(n)), n);
+}
+
+
+//------------------------------------------------------------------------------
+// UTF-16/UTF-32 --> UTF-8
+//
+template<class T>
+utf_result<char> to_utf8_(T* p, size_t len, char* out, size_t out_sz)
+{
+    size_t i = 0, o = 0;
+    utf_error err = utf_error::none;
+    while(i < len)
+    {
+        char32_t cp = char32_t(p[i]);
+        size_t n = 1;
+        if (sizeof(T) == 2 && (cp - 0xD800u) < 0x800u)                 // surrogate
+        {
+            if (cp >= 0xDC00) { err = utf_error::invalid; break; }      // low one can't come first
+            if (i + 1 == len) { err = utf_error::incomplete; break; }
+            char32_t lo = char32_t(p[i + 1]);
+            if ((lo - 0xDC00u) >= 0x400u) { err = utf_error::invalid; break; }
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+            n = 2;
+        }
+        else if (sizeof(T) == 4 && (cp > 0x10FFFF || (cp - 0xD800u) < 0x800u)) { err = utf_error::invalid; break; }
+
+        if (cp < 0x80 && o < out_sz) { out[o++] = char(cp); ++i; continue; }    // ASCII shortcut
+
+        if (out_sz - o < encoded_len(cp)) { err = utf_error::no_room; break; }
+        o += encode(cp, out + o);
+        i += n;
+    }
+    return { {o, out}, i, err };
+}
+
+template<class T, class Tr, enable_if<is_utf16<T>>...>
+inline utf_result<char> utf16_to_utf8(parray<T, Tr> v, char* buf, size_t buf_sz) { return to_utf8_(v.p, v.len, buf, buf_sz); }
+
+template<class T, class Tr, enable_if<is_utf32<T>>...>
+inline utf_result<char> utf32_to_utf8(parray<T, Tr> v, char* buf, size_t buf_sz) { return to_utf8_(v.p, v.len, buf, buf_sz); }
+
+template<class T, class Tr, class A, enable_if<is_utf16<T> && !std::is_pointer<A>::value>...>
+utf_result<char> utf16_to_utf8(parray<T, Tr> v, A alloc)
+{
+    size_t n = utf8_length(v);
+    return to_utf8_(v.p, v.len, static_cast<char*>(alloc(n)), n);
+}
+
+template<class T, class Tr, class A, enable_if<is_utf32<T> && !std::is_pointer<A>::value>...>
+utf_result<char> utf32_to_utf8(parray<T, Tr> v, A alloc)
+{
+    size_t n = utf8_length(v);
+    return to_utf8_(v.p, v.len, static_cast<char*>(alloc(n)), n);
+}
+
+
+//------------------------------------------------------------------------------
+// split() delimiters that match whole UTF-8 sequences (D is_delim(char32_t) predicate)
+//
+template<class D>
+struct utf8_delim_base
+{
+    enum { is_delimiter };      // mark this type for 'delim is: D' case
+
+    template<class I> I find_first(I p, I p_end) const
+    {
+        for(size_t n; p != p_end; p += n)
+            if (at_(p, p_end, n)) return p;
+        return p_end;
+    }
+
+    template<class I> I skip_all(I p, I p_end) const
+    {
+        for(size_t n; p != p_end && at_(p, p_end, n); p += n) {}
+        return p;
+    }
+
+    // pre-condition: p was produced by 'find_first()' and != p_end
+    template<class T> T* skip_one(T* p) const { return p + seq_len(byte_(*p)); }
+    template<class T> reverse_iterator<T*> skip_one(reverse_iterator<T*> p) const
+    {
+        while((byte_(*p) & 0xC0) == 0x80) ++p;          // we are at the last byte of sequence, go to its lead byte
+        return ++p;
+    }
+
+private:
+    bool is_delim_(char32_t cp) const { return static_cast<D const*>(this)->is_delim(cp); }
+
+    // is there delimiter at p, n -- length of sequence at p (1 for bad bytes)
+    template<class T> bool at_(T* p, T* p_end, size_t& n) const
+    {
+        unsigned b = byte_(*p);
+        n = 1;
+        if (b < 0x80) return is_delim_(b);
+
+        char32_t cp = 0;
+        size_t k = seq_decode(p, p_end - p, cp);
+        if (k == seq_invalid || k == seq_incomplete) return false;
+        n = k;
+        return is_delim_(cp);
+    }
+
+    // same for reversed range (*p is the last byte of sequence)
+    template<class T> bool at_(reverse_iterator<T*> p, reverse_iterator<T*> p_end, size_t& n) const
+    {
+        T* q = p.base();
+        T* q_begin = p_end.base();
+        unsigned b = byte_(q[-1]);
+        n = 1;
+        if (b < 0x80) return is_delim_(b);
+
+        size_t k = 1;
+        while(k < 4 && q - k > q_begin && (byte_(q[-k]) & 0xC0) == 0x80) ++k;      // find lead byte
+
+        char32_t cp = 0;
+        if (seq_decode(q - k, k, cp) != k) return false;   // it has to be a complete sequence that ends at q
+        n = k;
+        return is_delim_(cp);
+    }
+};
+
+// any code point of d (which is UTF-8 array), d is not copied
+struct utf8_delim : utf8_delim_base<utf8_delim>
+{
+    parray<char const> d;
+
+    template<class T, class Tr, enable_if<is_utf8<T>>...>
+    explicit utf8_delim(parray<T, Tr> v) : d(v.len, reinterpret_cast<char const*>(v.p)) {}
+
+    bool is_delim(char32_t cp) const
+    {
+        for(size_t i = 0; i < d.len; )
+        {
+            char32_t c = byte_(d.p[i]);
+            size_t n = (c < 0x80) ? 1 : seq_decode(d.p + i, d.len - i, c);
+            if (n == seq_invalid || n == seq_incomplete) return false;      // malformed d
+            if (c == cp) return true;
+            i += n;
+        }
+        return false;
+    }
+};
+
+// any Unicode whitespace
+struct utf8_space_delim : utf8_delim_base<utf8_space_delim>
+{
+    bool is_delim(char32_t cp) const { return is_unicode_space(cp); }
+};
+
+
+//------------------------------------------------------------------------------
+// trim family
+//
+template<class T, class Tr, enable_if<is_utf8<T>>...>
+inline parray<T, Tr> utf8_trim_left(parray<T, Tr> v)
+{
+    T* p_end = v.p + v.len;
+    v.p = utf8_space_delim{}.skip_all(v.p, p_end);
+    v.len = p_end - v.p;
+    return v;
+}
+
+template<class T, class Tr, enable_if<is_utf8<T>>...>
+inline parray<T, Tr> utf8_trim_right(parray<T, Tr> v)
+{
+    v.len = utf8_space_delim{}.skip_all(make_reverse_iterator(v.p + v.len), make_reverse_iterator(v.p)).base() - v.p;
+    return v;
+}
+
+template<class T, class Tr, enable_if<is_utf8<T>>...>
+inline parray<T, Tr> utf8_trim(parray<T, Tr> v) { return utf8_trim_right(utf8_trim_left(v)); }
+
+
+//------------------------------------------------------------------------------
+} // namespace parray_utf_pvt_
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+using parray_utf_pvt_::utf_error;
+using parray_utf_pvt_::utf_result;
+using parray_utf_pvt_::utf8_valid;
+using parray_utf_pvt_::utf8_find_invalid;
+using parray_utf_pvt_::utf16_length;
+using parray_utf_pvt_::utf32_length;
+using parray_utf_pvt_::utf8_length;
+using parray_utf_pvt_::utf8_to_utf16;
+using parray_utf_pvt_::utf8_to_utf32;
+using parray_utf_pvt_::utf16_to_utf8;
+using parray_utf_pvt_::utf32_to_utf8;
+using parray_utf_pvt_::utf8_delim;
+using parray_utf_pvt_::utf8_space_delim;
+using parray_utf_pvt_::utf8_trim;
+using parray_utf_pvt_::utf8_trim_left;
+using parray_utf_pvt_::utf8_trim_right;
+
+
+//------------------------------------------------------------------------------
+} // namespace adv
+//------------------------------------------------------------------------------
+
+
+#endif //PARRAY_UTF_H_2026_10_18_19_20_44_518_H_
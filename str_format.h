@@ -0,0 +1,360 @@
+/*/////////////////////////////////////////////////////////////////////////////
+    ADV library
+
+  Author:
+    Michael Kilburn
+
+/////////////////////////////////////////////////////////////////////////////*/
+
+
+#ifndef STR_FORMAT_H_2026_10_18_13_05_52_204_H_
+#define STR_FORMAT_H_2026_10_18_13_05_52_204_H_
+
+
+#include "parray.h"
+#include "parray_format.h"
+#include <type_traits>
+#include <utility>
+#include <cstring>
+#include <string>
+
+
+//------------------------------------------------------------------------------
+// Type-safe formatting into fixed buffer
+//
+//  str_format_result str_format(char* buf, size_t size, ADV_FMT("..."), args...)
+//  str_format_result str_format(char (&buf)[n], ADV_FMT("..."), args...)
+//      format args into buf according to format string, result is not nul-terminated
+//
+//  str_format_result
+//      str         -- formatted string (points into buf)
+//      required    -- buffer size required to hold entire result
+//      truncated() -- true if buffer was too small (str contains the beginning of result)
+//
+// Format string:
+//  - {}    -- next argument
+//  - {:x}  -- next argument in lower case hex (integral types only)
+//  - {:X}  -- next argument in upper case hex (integral types only)
+//  - {{ }} -- literal '{' and '}'
+//
+// Arguments:
+//  - integral types (via format_int), bool ("true"/"false"), char, float/double (via format_double)
+//  - parray<char [const] [volatile], Tr>, ntbs_t<char>, basic_string<char>
+//  - raw pointers and char arrays are not accepted (use ntbs()/ntba())
+//
+// Notes:
+//  - format string is parsed at compile time: number of arguments, placeholder syntax and argument types
+//    are verified by static_assert and positions of all literal pieces are compile-time constants
+//  - format string has to be wrapped into ADV_FMT() macro -- this is the only way to make string literal
+//    a compile-time constant in C++14
+//  - unlike str_printf, truncation is reported and parray arguments don't need "%.*s" dance
+//
+// Example:
+//
+//      rcstring user = ...;
+//      char buf[256];
+//      auto r = str_format(buf, ADV_FMT("user={} id={:x} load={}"), user, 255, 0.5);
+//      // r.str == "user=... id=ff load=0.5"
+//      if (r.truncated()) ...;
+//
+
+
+//------------------------------------------------------------------------------
+namespace adv { namespace str_format_pvt_ {
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+using std::size_t;
+using adv::parray;
+using std::basic_string;
+using rcstring = parray<char const>;
+
+template<class T> using remove_cv = std::remove_cv_t<T>;
+template<bool B, class T = void> using enable_if = std::enable_if_t<B, T>;
+template<class T, class U> constexpr bool is_same = std::is_same<T, U>::value;
+template<class T> constexpr bool is_integral = std::is_integral<T>::value && !is_same<T, bool> && !is_same<T, char>;
+template<class T> constexpr bool is_floating_point = std::is_floating_point<T>::value;
+template<class B, class D> constexpr bool is_base_of = std::is_base_of<B, D>::value;
+
+
+//------------------------------------------------------------------------------
+struct str_format_result
+{
+    rcstring    str;
+    size_t      required;
+
+    bool truncated() const { return required > str.len; }
+};
+
+
+//------------------------------------------------------------------------------
+// compile-time format string parsing
+//
+
+struct fmt_tag {};          // base for types produced by ADV_FMT()
+
+// returns number of placeholders or -1 if format string is malformed
+constexpr int fmt_count(char const* s, size_t len)
+{
+    int count = 0;
+    for(size_t i = 0; i < len; ++i)
+    {
+        if (s[i] == '{')
+        {
+            if (i + 1 < len && s[i + 1] == '{') { ++i; continue; }
+            if (i + 1 < len && s[i + 1] == '}') { ++i; ++count; continue; }
+            if (i + 3 < len && s[i + 1] == ':' && (s[i + 2] == 'x' || s[i + 2] == 'X') && s[i + 3] == '}') { i += 3; ++count; continue; }
+            return -1;
+        }
+        if (s[i] == '}')
+        {
+            if (i + 1 < len && s[i + 1] == '}') { ++i; continue; }
+            return -1;
+        }
+    }
+    return count;
+}
+
+// position of n-th placeholder (or len if there is no such placeholder)
+constexpr size_t fmt_pos(char const* s, size_t len, int n)
+{
+    for(size_t i = 0; i < len; ++i)
+    {
+        if (s[i] == '{' && s[i + 1] == '{') { ++i; continue; }
+        if (s[i] == '}') { ++i; continue; }
+        if (s[i] == '{' && n-- == 0) return i;
+        if (s[i] == '{') i += (s[i + 1] == '}') ? 1 : 3;
+    }
+    return len;
+}
+
+// length of n-th placeholder
+constexpr size_t fmt_size(char const* s, size_t len, int n)
+{
+    return (fmt_pos(s, len, n) == len) ? 0 : (s[fmt_pos(s, len, n) + 1] == '}') ? 2 : 4;
+}
+
+// spec of n-th placeholder ('\0', 'x' or 'X')
+constexpr char fmt_spec(char const* s, size_t len, int n)
+{
+    return (fmt_size(s, len, n) == 4) ? s[fmt_pos(s, len, n) + 2] : '\0';
+}
+
+// true if [b, e) contains escaped braces
+constexpr bool fmt_has_escapes(char const* s, size_t b, size_t e)
+{
+    for(; b < e; ++b)
+        if (s[b] == '{' || s[b] == '}') return true;
+    return false;
+}
+
+
+//------------------------------------------------------------------------------
+// output
+//
+
+class writer
+{
+    char*   buf_;
+    size_t  size_;
+    size_t  len_ = 0;       // may exceed size_ (if result was truncated)
+
+public:
+    writer(char* buf, size_t size) : buf_(buf), size_(size) {}
+
+    void put(char const* p, size_t n)
+    {
+        if (len_ < size_) std::memcpy(buf_ + len_, p, (n < size_ - len_) ? n : size_ - len_);
+        len_ += n;
+    }
+
+    void put(char c)
+    {
+        if (len_ < size_) buf_[len_] = c;
+        ++len_;
+    }
+
+    // literal with escaped braces
+    void put_escaped(char const* p, size_t n)
+    {
+        for(char const* p_end = p + n; p != p_end; ++p)
+        {
+            put(*p);
+            if (*p == '{' || *p == '}') ++p;        // skip second brace
+        }
+    }
+
+    // space for in-place formatting, nullptr if there isn't enough room
+    char* reserve(size_t n) { return (len_ < size_ && n <= size_ - len_) ? buf_ + len_ : nullptr; }
+    void commit(size_t n)   { len_ += n; }
+
+    str_format_result result() const { return { rcstring((len_ < size_) ? len_ : size_, buf_), len_ }; }
+};
+
+
+//------------------------------------------------------------------------------
+// arguments
+//
+
+template<class T, enable_if<is_integral<T>>...>
+inline void put_arg(writer& w, T v, char spec)
+{
+    if (spec)
+    {
+        char const* digits = (spec == 'x') ? "0123456789abcdef" : "0123456789ABCDEF";
+        auto u = static_cast<std::make_unsigned_t<T>>(v);
+
+        char hex[sizeof(T)*2];
+        char* p = hex + sizeof(hex);
+        do { *--p = digits[u & 0xF]; u >>= 4; } while(u);
+        w.put(p, hex + sizeof(hex) - p);
+        return;
+    }
+
+    if (char* p = w.reserve(format_max<T>))
+        w.commit(format_int(p, format_max<T>, v).len);
+    else
+    {
+        char tmp[format_max<T>];
+        rcstring s = format_int(tmp, v);
+        w.put(s.p, s.len);
+    }
+}
+
+template<class T, enable_if<is_floating_point<T>>...>
+inline void put_arg(writer& w, T v, char)
+{
+    if (char* p = w.reserve(format_max<double>))
+        w.commit(format_double(p, format_max<double>, v).len);
+    else
+    {
+        char tmp[format_max<double>];
+        rcstring s = format_double(tmp, v);
+        w.put(s.p, s.len);
+    }
+}
+
+inline void put_arg(writer& w, bool v, char) { if (v) w.put("true", 4); else w.put("false", 5); }
+inline void put_arg(writer& w, char v, char) { w.put(v); }
+
+// raw pointers (and char arrays) are rejected -- otherwise they'd be silently converted to bool
+template<class T> void put_arg(writer&, T*, char) = delete;
+
+template<class E, class Tr, enable_if<is_same<remove_cv<E>, char> && !std::is_volatile<E>::value>...>
+inline void put_arg(writer& w, parray<E, Tr> v, char) { w.put(v.p, v.len); }
+
+template<class E, class Tr, enable_if<is_same<remove_cv<E>, char> && std::is_volatile<E>::value>...>
+inline void put_arg(writer& w, parray<E, Tr> v, char) { for(size_t i = 0; i < v.len; ++i) w.put(v.p[i]); }
+
+template<class E, class Tr, enable_if<is_same<remove_cv<E>, char>>...>
+inline void put_arg(writer& w, parray_pvt_::ntbs_t<E, Tr> v, char) { put_arg(w, parray<E, Tr>(v), '\0'); }
+
+template<class Tr, class A>
+inline void put_arg(writer& w, basic_string<char, Tr, A> const& v, char) { w.put(v.data(), v.size()); }
+
+
+//------------------------------------------------------------------------------
+// compile-time checks
+//
+
+template<class T> constexpr bool is_hex_ok = is_integral<remove_cv<std::remove_reference_t<T>>>;
+
+template<class Fmt, class... Args, size_t... I>
+constexpr bool fmt_check(std::index_sequence<I...>)
+{
+    bool const ok[] = { true, (fmt_spec(Fmt::str(), Fmt::size(), I) == '\0' || is_hex_ok<Args>)... };
+    for(bool v : ok)
+        if (!v) return false;
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+// formatting
+//
+
+template<class Fmt, size_t I>
+inline void put_literal(writer& w)
+{
+    constexpr size_t b = (I == 0) ? 0 : fmt_pos(Fmt::str(), Fmt::size(), int(I) - 1) + fmt_size(Fmt::str(), Fmt::size(), int(I) - 1);
+    constexpr size_t e = fmt_pos(Fmt::str(), Fmt::size(), int(I));
+    constexpr bool escapes = fmt_has_escapes(Fmt::str(), b, e);
+
+    if (b == e) return;
+    if (escapes)
+        w.put_escaped(Fmt::str() + b, e - b);
+    else
+        w.put(Fmt::str() + b, e - b);
+}
+
+template<class Fmt, size_t I, class A>
+inline void put_piece(writer& w, A const& a)
+{
+    constexpr char spec = fmt_spec(Fmt::str(), Fmt::size(), int(I));
+
+    put_literal<Fmt, I>(w);
+    put_arg(w, a, spec);
+}
+
+template<class Fmt, class... Args, size_t... I>
+inline str_format_result str_format_(char* buf, size_t size, std::index_sequence<I...>, Args const&... args)
+{
+    writer w(buf, size);
+    int const dummy[] = { 0, (put_piece<Fmt, I>(w, args), 0)... };
+    (void)dummy;
+    put_literal<Fmt, sizeof...(I)>(w);
+    return w.result();
+}
+
+
+//------------------------------------------------------------------------------
+// str_format() family
+//
+template<class Fmt, class... Args, enable_if<is_base_of<fmt_tag, Fmt>>...>
+inline str_format_result str_format(char* buf, size_t size, Fmt, Args const&... args)
+{
+    static_assert(fmt_count(Fmt::str(), Fmt::size()) >= 0, "malformed format string");
+    static_assert(fmt_count(Fmt::str(), Fmt::size()) == int(sizeof...(Args)), "number of arguments doesn't match format string");
+    static_assert(fmt_check<Fmt, Args...>(std::index_sequence_for<Args...>{}), "hex format used for non-integral argument");
+
+    return str_format_<Fmt>(buf, size, std::index_sequence_for<Args...>{}, args...);
+}
+
+template<size_t n, class Fmt, class... Args, enable_if<is_base_of<fmt_tag, Fmt>>...>
+inline str_format_result str_format(char (&buf)[n], Fmt fmt, Args const&... args)
+{
+    return str_format(&buf[0], n, fmt, args...);
+}
+
+
+//------------------------------------------------------------------------------
+} // namespace str_format_pvt_
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+using str_format_pvt_::str_format_result;
+using str_format_pvt_::str_format;
+
+
+//------------------------------------------------------------------------------
+} // namespace adv
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+// turns string literal into a type (with compile-time accessible content)
+//
+#define ADV_FMT(s)                                                                      \
+    ([] {                                                                               \
+        struct fmt_ : ::adv::str_format_pvt_::fmt_tag                                   \
+        {                                                                               \
+            static constexpr char const* str() { return s; }                            \
+            static constexpr ::std::size_t size() { return sizeof(s) - 1; }             \
+        };                                                                              \
+        return fmt_{};                                                                  \
+    }())
+
+
+#endif //STR_FORMAT_H_2026_10_18_13_05_52_204_H_
@@ -6,7 +6,9 @@
 #include <cstdio>
 #include <cassert>
 #include <climits>
+#include <cstring>
 #include "misc_macro.h"
+#include "parray.h"       // adv::rcstring -- result of str_aprintf()
 
 
 //------------------------------------------------------------------------------
@@ -51,8 +53,10 @@ using std::size_t;
 // to accomodate whole string or truncation happens. Sometimes it is necessary to
 // know if buffer was large enough (i.e. in CString::Format(...)) -- in this case
 // you will need to use:
-//      _vsnprintf
-//      _snprintf
+//      str_nprintf -- same as str_printf, but returns length of complete result,
+//                     if it is >= buffer size -- truncation happened
+//      str_aprintf -- appends result to growable buffer (vector<char>, string, etc),
+//                     in most cases formatting is performed only once
 
 
 //------------------------------------------------------------------------------
@@ -171,6 +175,110 @@ inline size_t str_printf(char* buf, size_t size, char const* pszFormat, ...) noe
 }
 
 
+//------------------------------------------------------------------------------
+// va_list + size, returns length of complete result (not counting zero) [closure]
+//  - if result >= size then output was truncated and buffer of (result + 1) chars is required
+//  - buffer is always zero-terminated (if size != 0)
+inline size_t str_vnprintf(char* buf, size_t size, char const* pszFormat, va_list args) noexcept
+{
+    int nRes = std::vsnprintf(buf, size, pszFormat, args);     // C99 semantic (MSVC 2015+)
+    if (nRes < 0)
+    {
+        if (size) buf[0] = '\0';
+        return 0;
+    }
+    return static_cast<size_t>(nRes);
+}
+
+
+//------------------------------------------------------------------------------
+// [...] + size, returns length of complete result
+inline size_t str_nprintf(char* buf, size_t size, char const* pszFormat, ...) noexcept PRINTF_ARGS(3, 4);
+
+inline size_t str_nprintf(char* buf, size_t size, char const* pszFormat, ...) noexcept
+{
+    va_list args;
+    va_start(args, pszFormat);
+
+    size_t nRes = str_vnprintf(buf, size, pszFormat, args);
+
+    va_end(args);
+
+    return nRes;
+}
+
+
+//------------------------------------------------------------------------------
+// [...] + deduction, returns length of complete result
+template<size_t size>
+inline size_t str_nprintf(char (&buf)[size], char const* pszFormat, ...) noexcept
+{
+    va_list args;
+    va_start(args, pszFormat);
+
+    size_t nRes = str_vnprintf(buf, size, pszFormat, args);
+
+    va_end(args);
+
+    return nRes;
+}
+
+
+//------------------------------------------------------------------------------
+// va_list + growable buffer
+// appends formatted string to R (R should have size(), resize(), data() and operator[] -- e.g. vector<char> or string)
+// and returns appended part (it stays valid until R is modified)
+//  - short results (< str_aprintf_min_room) are formatted into stack buffer and copied, longer ones are formatted
+//    again directly into R; either way R is resized once to exact size (its spare capacity isn't touched, i.e.
+//    appending to pre-reserved buffer is cheap)
+//  - terminating zero is not kept in R
+enum { str_aprintf_min_room = 256 };
+
+template<class R>
+inline adv::rcstring str_vaprintf(R& r, char const* pszFormat, va_list args)
+{
+    size_t pos = r.size();
+
+    va_list args2;
+    va_copy(args2, args);
+
+    char buf[str_aprintf_min_room];
+    int nRes = std::vsnprintf(buf, sizeof(buf), pszFormat, args);
+    size_t len = (nRes < 0) ? 0 : static_cast<size_t>(nRes);
+    if (len)
+    {
+        r.resize(pos + len + 1);                                // room for terminating zero
+        if (len < sizeof(buf))
+            std::memcpy(&r[pos], buf, len);
+        else
+            std::vsnprintf(&r[pos], len + 1, pszFormat, args2);
+        r.resize(pos + len);
+    }
+    va_end(args2);
+
+    return {len, r.data() + pos};
+}
+
+
+//------------------------------------------------------------------------------
+// [...] + growable buffer
+template<class R>
+inline adv::rcstring str_aprintf(R& r, char const* pszFormat, ...) PRINTF_ARGS(2, 3);
+
+template<class R>
+inline adv::rcstring str_aprintf(R& r, char const* pszFormat, ...)
+{
+    va_list args;
+    va_start(args, pszFormat);
+
+    adv::rcstring res = str_vaprintf(r, pszFormat, args);
+
+    va_end(args);
+
+    return res;
+}
+
+
 //------------------------------------------------------------------------------
 } //namespace common {
 //------------------------------------------------------------------------------